@@ -0,0 +1,133 @@
+#include <benchmark/benchmark.h>
+
+#include <string>
+#include <vector>
+
+#include "cpp-badger/filter/bloom_filter.hh"
+#include "cpp-badger/util/random.hh"
+
+namespace badger {
+
+namespace {
+
+/// Hashes of range(0) keys added to a filter of 10 bits per key, and of as
+/// many keys that were not added.
+class BenchFilter {
+ public:
+  explicit BenchFilter(const benchmark::State& state, double bits_per_key = 10)
+      : reader_(Slice()) {
+    Random64 rnd(301);
+    const auto num_keys = static_cast<size_t>(state.range(0));
+    BloomFilterBuilder builder(bits_per_key);
+
+    for (size_t i = 0; i < num_keys; ++i) {
+      added_.push_back(rnd.Next());
+      builder.AddKeyHash(added_.back());
+      absent_.push_back(rnd.Next());
+    }
+
+    builder.Finish(&contents_);
+    reader_ = BloomFilterReader(contents_);
+  }
+
+  const BloomFilterReader& reader() const { return reader_; }
+  const std::vector<uint64_t>& added() const { return added_; }
+  const std::vector<uint64_t>& absent() const { return absent_; }
+
+ private:
+  std::vector<uint64_t> added_;
+  std::vector<uint64_t> absent_;
+  std::string contents_;
+  BloomFilterReader reader_;
+};
+
+void BM_BloomFilterBuild(benchmark::State& state) {
+  Random64 rnd(301);
+  std::vector<uint64_t> hashes(state.range(0));
+  for (auto& h : hashes) h = rnd.Next();
+  std::string contents;
+
+  for (auto _ : state) {
+    BloomFilterBuilder builder;
+    for (uint64_t h : hashes) builder.AddKeyHash(h);
+    contents.clear();
+    builder.Finish(&contents);
+    benchmark::DoNotOptimize(contents.data());
+  }
+
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) *
+                          state.range(0));
+}
+
+/// Probe throughput for keys that were added (range(1) == 1) or not. Filters
+/// of 10K keys fit in L1/L2; 10M keys (12 MiB) do not.
+void BM_BloomFilterMayContain(benchmark::State& state) {
+  const BenchFilter filter(state);
+  const auto& hashes = state.range(1) ? filter.added() : filter.absent();
+  size_t i = 0;
+  size_t hits = 0;
+
+  for (auto _ : state) {
+    hits += filter.reader().MayContainHash(hashes[i]);
+    if (++i == hashes.size()) i = 0;
+  }
+
+  benchmark::DoNotOptimize(hits);
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+}
+
+/// The same probes through MayContainHashes() in batches of 1024, with the
+/// scalar kernel (range(2) == 0) or the one selected for the CPU.
+void BM_BloomFilterMayContainBatch(benchmark::State& state) {
+  constexpr size_t kBatch = 1024;
+  const BenchFilter filter(state);
+  const auto& hashes = state.range(1) ? filter.added() : filter.absent();
+  bool out[kBatch];
+  size_t i = 0;
+  size_t hits = 0;
+
+  // Resolve the selected kernel, then swap in the one under test.
+  filter.reader().MayContainHashes(hashes.data(), 1, out);
+  const BloomProbeFunction resolved = internal::bloom_probe.load();
+  if (state.range(2) == 0) internal::bloom_probe.store(BloomProbeScalar);
+
+  for (auto _ : state) {
+    filter.reader().MayContainHashes(hashes.data() + i, kBatch, out);
+    for (bool hit : out) hits += hit;
+    i += kBatch;
+    if (i + kBatch > hashes.size()) i = 0;
+  }
+
+  internal::bloom_probe.store(resolved);
+  benchmark::DoNotOptimize(hits);
+  state.SetLabel(state.range(2) ? BloomProbeKernelName() : "scalar");
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * kBatch);
+}
+
+/// Measured and estimated false positive rates at range(1) bits per key.
+void BM_BloomFilterFpRate(benchmark::State& state) {
+  const BenchFilter filter(state, static_cast<double>(state.range(1)));
+  size_t false_positives = 0;
+  size_t queries = 0;
+
+  for (auto _ : state) {
+    for (uint64_t h : filter.absent())
+      false_positives += filter.reader().MayContainHash(h);
+    queries += filter.absent().size();
+  }
+
+  state.counters["fp_rate"] = static_cast<double>(false_positives) / queries;
+  state.counters["estimated_fp_rate"] = BloomFilter::EstimatedFpRate(
+      state.range(0), filter.reader().NumLines(), filter.reader().NumProbes());
+}
+
+BENCHMARK(BM_BloomFilterBuild)->Arg(10000)->Arg(1000000);
+BENCHMARK(BM_BloomFilterMayContain)
+    ->ArgsProduct({{10000, 10000000}, {0, 1}});
+BENCHMARK(BM_BloomFilterMayContainBatch)
+    ->ArgsProduct({{10000, 10000000}, {0, 1}, {0, 1}});
+BENCHMARK(BM_BloomFilterFpRate)->ArgsProduct({{1000000}, {6, 10, 16}});
+
+}  // namespace
+
+}  // namespace badger
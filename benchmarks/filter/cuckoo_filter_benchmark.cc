@@ -0,0 +1,90 @@
+#include <benchmark/benchmark.h>
+
+#include <string>
+#include <vector>
+
+#include "cpp-badger/filter/bloom_filter.hh"
+#include "cpp-badger/filter/cuckoo_filter.hh"
+#include "cpp-badger/util/random.hh"
+
+namespace badger {
+
+namespace {
+
+std::vector<uint64_t> RandomHashes(size_t n, uint64_t seed) {
+  Random64 rnd(seed);
+  std::vector<uint64_t> hashes(n);
+  for (auto& h : hashes) h = rnd.Next();
+
+  return hashes;
+}
+
+/// Probe throughput for keys that were added (range(1) == 1) or not, in a
+/// filter filled to capacity.
+void BM_CuckooFilterMayContain(benchmark::State& state) {
+  const std::vector<uint64_t> added = RandomHashes(state.range(0), 301);
+  const std::vector<uint64_t> absent = RandomHashes(state.range(0), 302);
+  Arena arena;
+  CuckooFilter filter(&arena, added.size());
+  for (uint64_t h : added) filter.AddKeyHash(h);
+
+  const auto& hashes = state.range(1) ? added : absent;
+  size_t i = 0;
+  size_t hits = 0;
+
+  for (auto _ : state) {
+    hits += filter.MayContainHash(hashes[i]);
+    if (++i == hashes.size()) i = 0;
+  }
+
+  benchmark::DoNotOptimize(hits);
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+}
+
+/// A deduplication window of range(0) keys: each new key is added and the
+/// oldest deleted.
+void BM_CuckooFilterSlidingWindow(benchmark::State& state) {
+  const auto window = static_cast<size_t>(state.range(0));
+  const std::vector<uint64_t> hashes = RandomHashes(4 * window, 301);
+  Arena arena;
+  CuckooFilter filter(&arena, window);
+  for (size_t i = 0; i < window; ++i) filter.AddKeyHash(hashes[i]);
+  size_t next = window;
+
+  for (auto _ : state) {
+    filter.AddKeyHash(hashes[next % hashes.size()]);
+    filter.DeleteKeyHash(hashes[(next - window) % hashes.size()]);
+    ++next;
+  }
+
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+  state.counters["bits_per_key"] =
+      64.0 * filter.NumBuckets() / static_cast<double>(window);
+}
+
+/// The alternative: rebuilding a Bloom filter over the window, per key of
+/// the window (as if rebuilt once per window).
+void BM_BloomFilterWindowRebuild(benchmark::State& state) {
+  const std::vector<uint64_t> hashes = RandomHashes(state.range(0), 301);
+  std::string contents;
+
+  for (auto _ : state) {
+    BloomFilterBuilder builder(16);
+    for (uint64_t h : hashes) builder.AddKeyHash(h);
+    contents.clear();
+    builder.Finish(&contents);
+    benchmark::DoNotOptimize(contents.data());
+  }
+
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) *
+                          state.range(0));
+}
+
+BENCHMARK(BM_CuckooFilterMayContain)
+    ->ArgsProduct({{10000, 10000000}, {0, 1}});
+BENCHMARK(BM_CuckooFilterSlidingWindow)->Arg(10000)->Arg(10000000);
+BENCHMARK(BM_BloomFilterWindowRebuild)->Arg(10000)->Arg(10000000);
+
+}  // namespace
+
+}  // namespace badger
@@ -0,0 +1,81 @@
+#include <benchmark/benchmark.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "cpp-badger/filter/fuse_filter.hh"
+#include "cpp-badger/util/random.hh"
+#include "cpp-badger/util/threadpool.hh"
+
+namespace badger {
+
+namespace {
+
+std::vector<uint64_t> RandomHashes(size_t n, uint64_t seed) {
+  Random64 rnd(seed);
+  std::vector<uint64_t> hashes(n);
+  for (auto& h : hashes) h = rnd.Next();
+
+  return hashes;
+}
+
+/// Builds a filter over range(0) keys on range(1) threads (0 for the calling
+/// thread only).
+void BM_FuseFilterBuild(benchmark::State& state) {
+  const std::vector<uint64_t> hashes = RandomHashes(state.range(0), 301);
+  const auto num_threads = static_cast<int>(state.range(1));
+  std::unique_ptr<ThreadPool> pool;
+  if (num_threads > 0) pool = std::make_unique<ThreadPool>(num_threads);
+  std::string contents;
+
+  for (auto _ : state) {
+    FuseFilterBuilder builder;
+    for (uint64_t h : hashes) builder.AddKeyHash(h);
+    contents.clear();
+    builder.Finish(&contents, pool.get());
+    benchmark::DoNotOptimize(contents.data());
+  }
+
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) *
+                          state.range(0));
+  state.counters["bits_per_key"] = 8.0 * contents.size() / hashes.size();
+}
+
+/// Probe throughput and false positive rate for keys that were added
+/// (range(1) == 1) or not.
+void BM_FuseFilterMayContain(benchmark::State& state) {
+  const std::vector<uint64_t> added = RandomHashes(state.range(0), 301);
+  const std::vector<uint64_t> absent = RandomHashes(state.range(0), 302);
+  FuseFilterBuilder builder;
+  for (uint64_t h : added) builder.AddKeyHash(h);
+  std::string contents;
+  builder.Finish(&contents);
+  const FuseFilterReader reader(contents);
+
+  const auto& hashes = state.range(1) ? added : absent;
+  size_t i = 0;
+  size_t hits = 0;
+
+  for (auto _ : state) {
+    hits += reader.MayContainHash(hashes[i]);
+    if (++i == hashes.size()) i = 0;
+  }
+
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+  state.counters["hit_rate"] =
+      static_cast<double>(hits) / static_cast<double>(state.iterations());
+}
+
+BENCHMARK(BM_FuseFilterBuild)
+    ->Args({100000, 0})
+    ->Args({4000000, 0})
+    ->Args({4000000, 4})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+BENCHMARK(BM_FuseFilterMayContain)
+    ->ArgsProduct({{10000, 10000000}, {0, 1}});
+
+}  // namespace
+
+}  // namespace badger
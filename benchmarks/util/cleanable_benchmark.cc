@@ -0,0 +1,120 @@
+#include <benchmark/benchmark.h>
+
+#include <string>
+#include <vector>
+
+#include "cpp-badger/util/cleanable.hh"
+#include "cpp-badger/util/slice.hh"
+
+namespace badger {
+
+namespace {
+
+void Release(void* counter, void*) { ++*static_cast<int*>(counter); }
+
+/// Registers range(0) cleanups and runs them, as an iterator that pins one or
+/// more blocks does over its lifetime.
+void BM_RegisterAndReset(benchmark::State& state) {
+  const int n = static_cast<int>(state.range(0));
+  Cleanable cleanable;
+  int counter = 0;
+
+  for (auto _ : state) {
+    for (int i = 0; i < n; ++i)
+      cleanable.RegisterCleanup(&Release, &counter, nullptr);
+    cleanable.Reset();
+  }
+
+  benchmark::DoNotOptimize(counter);
+}
+BENCHMARK(BM_RegisterAndReset)->Arg(1)->Arg(2)->Arg(8);
+
+/// Hands the cleanups of a short-lived Cleanable to a longer-lived one, which
+/// already owns range(0) cleanups.
+void BM_DelegateCleanupsTo(benchmark::State& state) {
+  const int n = static_cast<int>(state.range(0));
+  int counter = 0;
+
+  for (auto _ : state) {
+    Cleanable owner;
+    for (int i = 0; i < n; ++i)
+      owner.RegisterCleanup(&Release, &counter, nullptr);
+
+    Cleanable temp;
+    temp.RegisterCleanup(&Release, &counter, nullptr);
+    temp.RegisterCleanup(&Release, &counter, nullptr);
+    temp.DelegateCleanupsTo(&owner);
+  }
+
+  benchmark::DoNotOptimize(counter);
+}
+BENCHMARK(BM_DelegateCleanupsTo)->Arg(0)->Arg(1)->Arg(8);
+
+/// The read path: pin a value owned by a block, hand it to the caller, and
+/// release it.
+void BM_PinnableSliceChurn(benchmark::State& state) {
+  const std::string value(100, 'v');
+  PinnableSlice slice;
+  int counter = 0;
+
+  for (auto _ : state) {
+    slice.PinSlice(value, &Release, &counter, nullptr);
+    benchmark::DoNotOptimize(slice.data());
+    slice.Reset();
+  }
+
+  benchmark::DoNotOptimize(counter);
+}
+BENCHMARK(BM_PinnableSliceChurn);
+
+/// Same as above, but the pin is transferred from the block's Cleanable.
+void BM_PinnableSliceDelegateChurn(benchmark::State& state) {
+  const std::string value(100, 'v');
+  PinnableSlice slice;
+  int counter = 0;
+
+  for (auto _ : state) {
+    Cleanable block;
+    block.RegisterCleanup(&Release, &counter, nullptr);
+    slice.PinSlice(value, &block);
+    benchmark::DoNotOptimize(slice.data());
+    slice.Reset();
+  }
+
+  benchmark::DoNotOptimize(counter);
+}
+BENCHMARK(BM_PinnableSliceDelegateChurn);
+
+/// Many threads pin one shared block from kResults results each and release
+/// them. range(0) selects how the references are taken: 0 one atomic op per
+/// copy, 1 through a RefBatch, 2 through a RefBatch with deferred unrefs.
+void BM_SharedPinChurn(benchmark::State& state) {
+  constexpr size_t kResults = 64;
+  static SharedCleanablePtr* block = [] {
+    auto* scp = new SharedCleanablePtr();
+    scp->Allocate();
+    return scp;
+  }();
+  const int mode = static_cast<int>(state.range(0));
+  std::vector<Cleanable> results(kResults);
+
+  for (auto _ : state) {
+    if (mode == 0) {
+      for (auto& result : results) block->RegisterCopyWith(&result);
+    } else {
+      SharedCleanablePtr::RefBatch batch(*block, kResults, mode == 2);
+      for (auto& result : results) batch.RegisterCopyWith(&result);
+    }
+
+    for (auto& result : results) result.Reset();
+  }
+
+  SharedCleanablePtr::FlushDeferredUnrefs();
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) *
+                          kResults);
+}
+BENCHMARK(BM_SharedPinChurn)->DenseRange(0, 2)->ThreadRange(1, 8);
+
+}  // namespace
+
+}  // namespace badger
@@ -0,0 +1,147 @@
+#include <benchmark/benchmark.h>
+
+#include <string>
+#include <vector>
+
+#include "cpp-badger/util/hash.hh"
+#include "cpp-badger/util/random.hh"
+#include "cpp-badger/util/slice.hh"
+
+namespace badger {
+
+namespace {
+
+std::string RandomBytes(size_t n) {
+  Random rnd(301);
+  std::string bytes(n, '\0');
+
+  for (auto& c : bytes) c = static_cast<char>(rnd.Uniform(256));
+
+  return bytes;
+}
+
+void SetBytesProcessed(benchmark::State& state) {
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) *
+                          state.range(0));
+}
+
+/// MurmurHash1, the existing 32-bit hash.
+void BM_Hash32(benchmark::State& state) {
+  const std::string data = RandomBytes(state.range(0));
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(data.data());
+    benchmark::DoNotOptimize(hash(data.data(), data.size(), 0));
+  }
+
+  SetBytesProcessed(state);
+}
+
+void BM_Hash64(benchmark::State& state) {
+  const std::string data = RandomBytes(state.range(0));
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(data.data());
+    benchmark::DoNotOptimize(Hash64(data.data(), data.size()));
+  }
+
+  SetBytesProcessed(state);
+}
+
+void BM_Hash128(benchmark::State& state) {
+  const std::string data = RandomBytes(state.range(0));
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(data.data());
+    benchmark::DoNotOptimize(Hash128(data.data(), data.size()));
+  }
+
+  SetBytesProcessed(state);
+}
+
+/// Hashes 64 KiB of input fed in pieces of range(0) bytes, as a checksum of
+/// a value or file block that is produced piecemeal.
+void BM_StreamingHash64(benchmark::State& state) {
+  const std::string data = RandomBytes(64 << 10);
+  const auto piece = static_cast<size_t>(state.range(0));
+
+  for (auto _ : state) {
+    StreamingHash hasher;
+    for (size_t pos = 0; pos < data.size(); pos += piece)
+      hasher.Update(data.data() + pos, piece);
+    benchmark::DoNotOptimize(hasher.Final64());
+  }
+
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) *
+                          data.size());
+}
+BENCHMARK(BM_StreamingHash64)->RangeMultiplier(8)->Range(16, 64 << 10);
+
+/// kNumKeys random keys of range(0) to range(1) bytes.
+class RandomKeys {
+ public:
+  static constexpr size_t kNumKeys = 1024;
+
+  explicit RandomKeys(const benchmark::State& state) : storage_(kNumKeys) {
+    Random rnd(301);
+    const auto min_size = static_cast<uint32_t>(state.range(0));
+    const auto max_size = static_cast<uint32_t>(state.range(1));
+
+    for (auto& key : storage_) {
+      key.resize(min_size + rnd.Uniform(max_size - min_size + 1));
+      for (auto& c : key) c = static_cast<char>(rnd.Uniform(256));
+      keys_.emplace_back(key);
+    }
+  }
+
+  const Slice* data() const { return keys_.data(); }
+
+ private:
+  std::vector<std::string> storage_;
+  std::vector<Slice> keys_;
+};
+
+/// The baseline for BM_HashBatch: one Hash64() call per key.
+void BM_Hash64Loop(benchmark::State& state) {
+  const RandomKeys keys(state);
+  std::vector<uint64_t> out(RandomKeys::kNumKeys);
+
+  for (auto _ : state) {
+    for (size_t i = 0; i < RandomKeys::kNumKeys; ++i)
+      out[i] = Hash64(keys.data()[i].data(), keys.data()[i].size());
+    benchmark::ClobberMemory();
+  }
+
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) *
+                          RandomKeys::kNumKeys);
+}
+
+void BM_HashBatch(benchmark::State& state) {
+  const RandomKeys keys(state);
+  std::vector<uint64_t> out(RandomKeys::kNumKeys);
+
+  for (auto _ : state) {
+    HashBatch(keys.data(), RandomKeys::kNumKeys, out.data());
+    benchmark::ClobberMemory();
+  }
+
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) *
+                          RandomKeys::kNumKeys);
+}
+
+#define BADGER_HASH_SIZES RangeMultiplier(4)->Range(4, 64 << 10)
+
+BENCHMARK(BM_Hash32)->BADGER_HASH_SIZES;
+BENCHMARK(BM_Hash64)->BADGER_HASH_SIZES;
+BENCHMARK(BM_Hash128)->BADGER_HASH_SIZES;
+
+#define BADGER_KEY_SIZES \
+  Args({8, 8})->Args({16, 16})->Args({24, 24})->Args({32, 32}) \
+      ->Args({16, 32})->Args({1, 64})
+
+BENCHMARK(BM_Hash64Loop)->BADGER_KEY_SIZES;
+BENCHMARK(BM_HashBatch)->BADGER_KEY_SIZES;
+
+}  // namespace
+
+}  // namespace badger
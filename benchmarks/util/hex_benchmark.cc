@@ -0,0 +1,84 @@
+#include <benchmark/benchmark.h>
+
+#include <string>
+
+#include "cpp-badger/util/hex.hh"
+#include "cpp-badger/util/random.hh"
+#include "cpp-badger/util/slice.hh"
+
+namespace badger {
+
+namespace {
+
+std::string RandomBytes(size_t n) {
+  Random rnd(301);
+  std::string bytes(n, '\0');
+
+  for (auto& c : bytes) c = static_cast<char>(rnd.Uniform(256));
+
+  return bytes;
+}
+
+void SetBytesProcessed(benchmark::State& state) {
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) *
+                          state.range(0));
+}
+
+/// range(0) is the number of bytes encoded.
+template <HexEncodeFunction kEncode>
+void BM_HexEncode(benchmark::State& state) {
+  const std::string bytes = RandomBytes(state.range(0));
+  std::string hex(2 * bytes.size(), '\0');
+
+  for (auto _ : state) {
+    kEncode(bytes.data(), bytes.size(), hex.data());
+    benchmark::DoNotOptimize(hex.data());
+    benchmark::ClobberMemory();
+  }
+
+  SetBytesProcessed(state);
+}
+
+/// range(0) is the number of bytes decoded into.
+template <HexDecodeFunction kDecode>
+void BM_HexDecode(benchmark::State& state) {
+  const std::string bytes = RandomBytes(state.range(0));
+  std::string hex(2 * bytes.size(), '\0');
+  std::string decoded(bytes.size(), '\0');
+  HexEncode(bytes.data(), bytes.size(), hex.data());
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(kDecode(hex.data(), hex.size(), decoded.data()));
+    benchmark::ClobberMemory();
+  }
+
+  SetBytesProcessed(state);
+}
+
+/// The allocating API, for comparison with the caller-buffer one.
+void BM_SliceToStringHex(benchmark::State& state) {
+  const std::string bytes = RandomBytes(state.range(0));
+  const Slice slice(bytes);
+
+  for (auto _ : state) benchmark::DoNotOptimize(slice.ToString(true));
+
+  SetBytesProcessed(state);
+}
+
+#define BADGER_HEX_SIZES RangeMultiplier(8)->Range(8, 64 << 10)
+
+BENCHMARK_TEMPLATE(BM_HexEncode, HexEncodeScalar)->BADGER_HEX_SIZES;
+BENCHMARK_TEMPLATE(BM_HexEncode, HexEncode)->BADGER_HEX_SIZES;
+BENCHMARK_TEMPLATE(BM_HexDecode, HexDecodeScalar)->BADGER_HEX_SIZES;
+BENCHMARK_TEMPLATE(BM_HexDecode, HexDecode)->BADGER_HEX_SIZES;
+#ifdef BADGER_HAVE_X86_HEX
+BENCHMARK_TEMPLATE(BM_HexEncode, HexEncodeSSE2)->BADGER_HEX_SIZES;
+BENCHMARK_TEMPLATE(BM_HexEncode, HexEncodeAVX2)->BADGER_HEX_SIZES;
+BENCHMARK_TEMPLATE(BM_HexDecode, HexDecodeSSE2)->BADGER_HEX_SIZES;
+BENCHMARK_TEMPLATE(BM_HexDecode, HexDecodeAVX2)->BADGER_HEX_SIZES;
+#endif
+BENCHMARK(BM_SliceToStringHex)->BADGER_HEX_SIZES;
+
+}  // namespace
+
+}  // namespace badger
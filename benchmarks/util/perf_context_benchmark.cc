@@ -0,0 +1,61 @@
+#include "cpp-badger/util/perf_context.hh"
+
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <string>
+
+#include "cpp-badger/memtable/memtable.hh"
+
+namespace badger {
+
+namespace {
+
+constexpr int kKeys = 100000;
+
+/// A memtable of kKeys keys, shared by all benchmarks.
+const MemTable& GetMemTable() {
+  static const MemTable* mem = [] {
+    auto* m = new MemTable();
+    for (int i = 0; i < kKeys; ++i)
+      m->Add(i + 1, kTypeValue, std::to_string(i), "value");
+    return m;
+  }();
+  return *mem;
+}
+
+/// The cost of the instrumentation in MemTable::Get() at each level; the
+/// argument is the PerfLevel.
+void BM_MemTableGet(benchmark::State& state) {
+  const MemTable& mem = GetMemTable();
+  std::string value;
+  uint64_t i = 0;
+
+  SetPerfLevel(static_cast<PerfLevel>(state.range(0)));
+  for (auto _ : state) {
+    const std::string key = std::to_string(i++ % kKeys);
+    benchmark::DoNotOptimize(mem.Get(key, kKeys, &value));
+  }
+  SetPerfLevel(PerfLevel::kDisable);
+
+  state.SetItemsProcessed(state.iterations());
+}
+
+void BM_CounterAdd(benchmark::State& state) {
+  SetPerfLevel(static_cast<PerfLevel>(state.range(0)));
+  for (auto _ : state) {
+    for (int i = 0; i < 1024; ++i)
+      BADGER_PERF_COUNTER_ADD(user_key_comparison_count, 1);
+    benchmark::ClobberMemory();
+  }
+  SetPerfLevel(PerfLevel::kDisable);
+
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * 1024);
+}
+
+BENCHMARK(BM_MemTableGet)->DenseRange(0, 2);
+BENCHMARK(BM_CounterAdd)->DenseRange(0, 2);
+
+}  // namespace
+
+}  // namespace badger
@@ -0,0 +1,131 @@
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+
+#include "cpp-badger/util/random.hh"
+
+namespace badger {
+
+namespace {
+
+/// Draws per iteration, so that the loop overhead is amortized.
+constexpr int kDraws = 1024;
+
+/// Bound for Uniform(): not a power of two, so % can't be a mask.
+constexpr uint32_t kRange = 1000003;
+
+void SetItemsProcessed(benchmark::State& state) {
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * kDraws);
+}
+
+/// The LCG with %.
+void BM_RandomUniform(benchmark::State& state) {
+  Random rnd(301);
+  uint64_t sum = 0;
+
+  for (auto _ : state)
+    for (int i = 0; i < kDraws; ++i) sum += rnd.Uniform(kRange);
+
+  benchmark::DoNotOptimize(sum);
+  SetItemsProcessed(state);
+}
+
+/// The thread's LCG, looked up on every draw as RandomHeight() used to.
+void BM_RandomTLSUniform(benchmark::State& state) {
+  uint64_t sum = 0;
+
+  for (auto _ : state)
+    for (int i = 0; i < kDraws; ++i)
+      sum += Random::GetTLSInstance()->Uniform(kRange);
+
+  benchmark::DoNotOptimize(sum);
+  SetItemsProcessed(state);
+}
+
+/// mt19937_64 with std::uniform_int_distribution.
+void BM_Random64Uniform(benchmark::State& state) {
+  Random64 rnd(301);
+  uint64_t sum = 0;
+
+  for (auto _ : state)
+    for (int i = 0; i < kDraws; ++i) sum += rnd.Uniform(kRange);
+
+  benchmark::DoNotOptimize(sum);
+  SetItemsProcessed(state);
+}
+
+/// xoshiro256++ with fast_range64(), through a handle fetched once.
+void BM_RandomGeneratorUniform(benchmark::State& state) {
+  RandomGenerator* rnd = RandomGenerator::GetTLSInstance();
+  uint64_t sum = 0;
+
+  for (auto _ : state)
+    for (int i = 0; i < kDraws; ++i) sum += rnd->Uniform(kRange);
+
+  benchmark::DoNotOptimize(sum);
+  SetItemsProcessed(state);
+}
+
+/// Skiplist height sampling with branching factor 4 and max height 12.
+void BM_RandomHeightLCG(benchmark::State& state) {
+  Random* rnd = Random::GetTLSInstance();
+  const uint32_t threshold = (Random::kMaxNext + 1) / 4;
+  uint64_t sum = 0;
+
+  for (auto _ : state) {
+    for (int i = 0; i < kDraws; ++i) {
+      int height = 1;
+      while (height < 12 && rnd->Next() < threshold) ++height;
+      sum += height;
+    }
+  }
+
+  benchmark::DoNotOptimize(sum);
+  SetItemsProcessed(state);
+}
+
+void BM_RandomHeightGenerator(benchmark::State& state) {
+  RandomGenerator rnd(301);
+  const uint64_t threshold = (uint64_t{1} << 32) / 4;
+  uint64_t sum = 0;
+
+  for (auto _ : state) {
+    for (int i = 0; i < kDraws; ++i) {
+      int height = 1;
+      while (height < 12 && rnd.Next32() < threshold) ++height;
+      sum += height;
+    }
+  }
+
+  benchmark::DoNotOptimize(sum);
+  SetItemsProcessed(state);
+}
+
+/// What SkipList::RandomHeight() does for a power-of-two branching factor:
+/// one draw, counting trailing zero bits.
+void BM_RandomHeightBits(benchmark::State& state) {
+  RandomGenerator rnd(301);
+  uint64_t sum = 0;
+
+  for (auto _ : state) {
+    for (int i = 0; i < kDraws; ++i)
+      sum += std::min(12, 1 + std::countr_zero(rnd.Next()) / 2);
+  }
+
+  benchmark::DoNotOptimize(sum);
+  SetItemsProcessed(state);
+}
+
+BENCHMARK(BM_RandomUniform);
+BENCHMARK(BM_RandomTLSUniform);
+BENCHMARK(BM_Random64Uniform);
+BENCHMARK(BM_RandomGeneratorUniform);
+BENCHMARK(BM_RandomHeightLCG);
+BENCHMARK(BM_RandomHeightGenerator);
+BENCHMARK(BM_RandomHeightBits);
+
+}  // namespace
+
+}  // namespace badger
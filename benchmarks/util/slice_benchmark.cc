@@ -0,0 +1,130 @@
+#include <benchmark/benchmark.h>
+
+#include <cstring>
+#include <string>
+
+#include "cpp-badger/util/mismatch.hh"
+#include "cpp-badger/util/slice.hh"
+
+namespace badger {
+
+namespace {
+
+/// Two keys of `len` bytes that differ only in the last byte, so every
+/// comparison scans the whole key.
+struct KeyPair {
+  explicit KeyPair(size_t len) : a(len, 'k'), b(len, 'k') {
+    if (len > 0) b.back() = 'l';
+  }
+
+  std::string a;
+  std::string b;
+};
+
+void SetBytesProcessed(benchmark::State& state) {
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) *
+                          state.range(0));
+}
+
+/// The previous Slice::Compare(): memcmp plus a length tie-break.
+void BM_MemcmpCompare(benchmark::State& state) {
+  KeyPair keys(state.range(0));
+  const Slice a(keys.a);
+  const Slice b(keys.b);
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(a);
+    benchmark::DoNotOptimize(b);
+
+    const size_t min_len = std::min(a.size(), b.size());
+    int r = memcmp(a.data(), b.data(), min_len);
+
+    if (r == 0) r = (a.size() > b.size()) - (a.size() < b.size());
+
+    benchmark::DoNotOptimize(r);
+  }
+
+  SetBytesProcessed(state);
+}
+
+void BM_SliceCompare(benchmark::State& state) {
+  KeyPair keys(state.range(0));
+  const Slice a(keys.a);
+  const Slice b(keys.b);
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(a);
+    benchmark::DoNotOptimize(b);
+    benchmark::DoNotOptimize(a.Compare(b));
+  }
+
+  SetBytesProcessed(state);
+}
+
+/// The previous Slice::DifferenceOffset(): a byte-at-a-time loop.
+void BM_ByteLoopDifferenceOffset(benchmark::State& state) {
+  KeyPair keys(state.range(0));
+  const char* a = keys.a.data();
+  const char* b = keys.b.data();
+  const size_t len = keys.a.size();
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(a);
+    benchmark::DoNotOptimize(b);
+
+    size_t off = 0;
+
+    for (; off < len; off++)
+      if (a[off] != b[off]) break;
+
+    benchmark::DoNotOptimize(off);
+  }
+
+  SetBytesProcessed(state);
+}
+
+void BM_SliceDifferenceOffset(benchmark::State& state) {
+  KeyPair keys(state.range(0));
+  const Slice a(keys.a);
+  const Slice b(keys.b);
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(a);
+    benchmark::DoNotOptimize(b);
+    benchmark::DoNotOptimize(a.DifferenceOffset(b));
+  }
+
+  SetBytesProcessed(state);
+  state.SetLabel(MismatchKernelName());
+}
+
+template <MismatchFunction kKernel>
+void BM_Kernel(benchmark::State& state) {
+  KeyPair keys(state.range(0));
+  const char* a = keys.a.data();
+  const char* b = keys.b.data();
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(a);
+    benchmark::DoNotOptimize(b);
+    benchmark::DoNotOptimize(kKernel(a, b, keys.a.size()));
+  }
+
+  SetBytesProcessed(state);
+}
+
+#define BADGER_KEY_LENGTHS RangeMultiplier(2)->Range(8, 1024)
+
+BENCHMARK(BM_MemcmpCompare)->BADGER_KEY_LENGTHS;
+BENCHMARK(BM_SliceCompare)->BADGER_KEY_LENGTHS;
+BENCHMARK(BM_ByteLoopDifferenceOffset)->BADGER_KEY_LENGTHS;
+BENCHMARK(BM_SliceDifferenceOffset)->BADGER_KEY_LENGTHS;
+BENCHMARK_TEMPLATE(BM_Kernel, FindFirstMismatchScalar)->BADGER_KEY_LENGTHS;
+#ifdef BADGER_HAVE_X86_MISMATCH
+BENCHMARK_TEMPLATE(BM_Kernel, FindFirstMismatchSSE2)->BADGER_KEY_LENGTHS;
+BENCHMARK_TEMPLATE(BM_Kernel, FindFirstMismatchAVX2)->BADGER_KEY_LENGTHS;
+#endif
+
+}  // namespace
+
+}  // namespace badger
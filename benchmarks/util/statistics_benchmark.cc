@@ -0,0 +1,93 @@
+#include "cpp-badger/util/statistics.hh"
+
+#include <benchmark/benchmark.h>
+
+#include <atomic>
+#include <cstdint>
+
+namespace badger {
+
+namespace {
+
+/// Records per iteration, so that the loop overhead is amortized.
+constexpr int kRecords = 1024;
+
+Statistics* GetStatistics() {
+  static Statistics stats;
+  return &stats;
+}
+
+void SetItemsProcessed(benchmark::State& state) {
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) *
+                          kRecords);
+}
+
+/// What a ticker would cost as one shared counter: every thread adds to
+/// the same cache line.
+void BM_SharedAtomicTick(benchmark::State& state) {
+  static std::atomic<uint64_t> counter{0};
+
+  for (auto _ : state)
+    for (int i = 0; i < kRecords; ++i)
+      counter.fetch_add(1, std::memory_order_relaxed);
+
+  SetItemsProcessed(state);
+}
+
+void BM_RecordTick(benchmark::State& state) {
+  Statistics* stats = GetStatistics();
+
+  for (auto _ : state)
+    for (int i = 0; i < kRecords; ++i) stats->RecordTick(kSkipListInserts);
+
+  SetItemsProcessed(state);
+}
+
+void BM_RecordTickDisabled(benchmark::State& state) {
+  Statistics* stats = nullptr;
+  benchmark::DoNotOptimize(stats);
+
+  for (auto _ : state)
+    for (int i = 0; i < kRecords; ++i) RecordTick(stats, kSkipListInserts);
+
+  SetItemsProcessed(state);
+}
+
+void BM_RecordInHistogram(benchmark::State& state) {
+  Statistics* stats = GetStatistics();
+  uint64_t value = 0;
+
+  for (auto _ : state)
+    for (int i = 0; i < kRecords; ++i)
+      stats->RecordInHistogram(kSkipListInsertNanos, 100 + (++value & 1023));
+
+  SetItemsProcessed(state);
+}
+
+/// A timed operation: two clock reads and a histogram record.
+void BM_StopWatch(benchmark::State& state) {
+  Statistics* stats = GetStatistics();
+
+  for (auto _ : state)
+    for (int i = 0; i < kRecords; ++i)
+      StopWatch timer(stats, kSkipListInsertNanos);
+
+  SetItemsProcessed(state);
+}
+
+void BM_Snapshot(benchmark::State& state) {
+  Statistics* stats = GetStatistics();
+
+  for (auto _ : state) benchmark::DoNotOptimize(stats->Snapshot());
+}
+
+BENCHMARK(BM_SharedAtomicTick)->ThreadRange(1, 8);
+BENCHMARK(BM_RecordTick)->ThreadRange(1, 8);
+BENCHMARK(BM_RecordTickDisabled);
+BENCHMARK(BM_RecordInHistogram)->ThreadRange(1, 8);
+BENCHMARK(BM_StopWatch);
+BENCHMARK(BM_Snapshot);
+
+}  // namespace
+
+}  // namespace badger
@@ -0,0 +1,99 @@
+#include "cpp-badger/util/workload_generator.hh"
+
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+
+namespace badger {
+
+namespace {
+
+/// Draws per iteration, so that the loop overhead is amortized.
+constexpr int kDraws = 1024;
+
+constexpr uint64_t kNumKeys = 10000000;
+
+void SetItemsProcessed(benchmark::State& state) {
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * kDraws);
+}
+
+/// Through the base class, as a benchmark driver holding any generator
+/// would call it.
+void RunKeys(benchmark::State& state, KeyGenerator* gen) {
+  uint64_t sum = 0;
+
+  for (auto _ : state)
+    for (int i = 0; i < kDraws; ++i) sum += gen->Next();
+
+  benchmark::DoNotOptimize(sum);
+  SetItemsProcessed(state);
+}
+
+void BM_Uniform(benchmark::State& state) {
+  UniformGenerator gen(kNumKeys, 301);
+  RunKeys(state, &gen);
+}
+
+void BM_Zipfian(benchmark::State& state) {
+  ZipfianGenerator gen(kNumKeys, ZipfianGenerator::kDefaultTheta, 301);
+  RunKeys(state, &gen);
+}
+
+void BM_ScrambledZipfian(benchmark::State& state) {
+  ScrambledZipfianGenerator gen(kNumKeys, ZipfianGenerator::kDefaultTheta,
+                                301);
+  RunKeys(state, &gen);
+}
+
+void BM_Latest(benchmark::State& state) {
+  LatestGenerator gen(kNumKeys, ZipfianGenerator::kDefaultTheta, 301);
+  RunKeys(state, &gen);
+}
+
+void BM_Hotspot(benchmark::State& state) {
+  HotspotGenerator gen(kNumKeys, 0.2, 0.8, 301);
+  RunKeys(state, &gen);
+}
+
+void BM_Exponential(benchmark::State& state) {
+  ExponentialGenerator gen(kNumKeys, ExponentialGenerator::kDefaultPercentile,
+                           ExponentialGenerator::kDefaultRangeFraction, 301);
+  RunKeys(state, &gen);
+}
+
+void RunValueSizes(benchmark::State& state, ValueSizeGenerator gen) {
+  uint64_t sum = 0;
+
+  for (auto _ : state)
+    for (int i = 0; i < kDraws; ++i) sum += gen.Next();
+
+  benchmark::DoNotOptimize(sum);
+  SetItemsProcessed(state);
+}
+
+void BM_ValueSizeUniform(benchmark::State& state) {
+  RunValueSizes(state, ValueSizeGenerator::Uniform(16, 4096, 301));
+}
+
+void BM_ValueSizeNormal(benchmark::State& state) {
+  RunValueSizes(state, ValueSizeGenerator::Normal(1024, 256, 16, 4096, 301));
+}
+
+void BM_ValueSizePareto(benchmark::State& state) {
+  RunValueSizes(state,
+                ValueSizeGenerator::Pareto(226.409, 0.923, 16, 4096, 301));
+}
+
+BENCHMARK(BM_Uniform);
+BENCHMARK(BM_Zipfian);
+BENCHMARK(BM_ScrambledZipfian);
+BENCHMARK(BM_Latest);
+BENCHMARK(BM_Hotspot);
+BENCHMARK(BM_Exponential);
+BENCHMARK(BM_ValueSizeUniform);
+BENCHMARK(BM_ValueSizeNormal);
+BENCHMARK(BM_ValueSizePareto);
+
+}  // namespace
+
+}  // namespace badger
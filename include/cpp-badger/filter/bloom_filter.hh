@@ -0,0 +1,186 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+
+// A cache-local ("blocked") Bloom filter, after RocksDB's FastLocalBloom.
+//
+// Every key sets and tests bits in a single 64-byte cache line, so a query
+// costs at most one cache miss. The line is picked with fast_range32() from
+// the low half of the key's Hash64() and the probes within it come from the
+// high half, one 9-bit position per probe.
+//
+// Serialized layout
+// -----------------
+//
+//   [line 0: 64 bytes] ... [line n - 1: 64 bytes] [trailer: 8 bytes]
+//
+//   trailer: num_lines (fixed32) | num_probes (1 byte) | 0 (2 bytes) |
+//            kBloomFilterMarker (1 byte)
+//
+// Bit i of a line is bit (i % 8) of byte (i / 8), so the layout is the same
+// on every platform and may be persisted, e.g. in SST files.
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "cpp-badger/util/fast_range.hh"
+#include "cpp-badger/util/hash.hh"
+#include "cpp-badger/util/slice.hh"
+
+namespace badger {
+
+/// The last byte of a serialized BloomFilter.
+inline constexpr uint8_t kBloomFilterMarker = 0xB1;
+
+/// Parameters of the filter shared by the builder and the reader.
+struct BloomFilter {
+  static constexpr size_t kLineSize = 64;
+  static constexpr size_t kTrailerSize = 8;
+  static constexpr int kMaxProbes = 24;
+
+  /// \return The number of probes that minimizes the false positive rate of
+  ///         a filter with `millibits_per_key` / 1000 bits per key, taking
+  ///         the uneven filling of cache lines into account.
+  static int ChooseNumProbes(int millibits_per_key);
+
+  /// \return The expected false positive rate of a filter with the given
+  ///         shape.
+  static double EstimatedFpRate(size_t num_keys, size_t num_lines,
+                                int num_probes);
+
+  /// \return The bit of a line that probe state `h` selects.
+  static uint32_t ProbeBit(uint32_t h) { return h >> (32 - 9); }
+
+  /// Multiplier that derives the next probe from the previous one.
+  static constexpr uint32_t kProbeMultiplier = 0x9e3779b9;
+};
+
+/// Tests `n` keys against their lines: sets out[i] to whether all
+/// `num_probes` bits that `probe_hashes[i]` (the high half of the key hash)
+/// selects are set in the 64-byte line at `lines[i]`.
+using BloomProbeFunction = void (*)(const uint8_t* const* lines,
+                                    const uint32_t* probe_hashes, size_t n,
+                                    int num_probes, bool* out);
+
+/// One probe at a time, as BloomFilterReader::MayContainHash().
+void BloomProbeScalar(const uint8_t* const* lines,
+                      const uint32_t* probe_hashes, size_t n, int num_probes,
+                      bool* out);
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define BADGER_HAVE_X86_BLOOM 1
+
+/// Eight probes at a time: the line is held in two registers and the probed
+/// words are picked out with permutes.
+/// REQUIRES: the CPU supports AVX2.
+void BloomProbeAVX2(const uint8_t* const* lines, const uint32_t* probe_hashes,
+                    size_t n, int num_probes, bool* out);
+#endif
+
+/// \return The name of the probe kernel selected for this CPU, e.g. "avx2".
+const char* BloomProbeKernelName();
+
+namespace internal {
+
+/// Points to a resolver until the first call, then to the selected kernel.
+extern std::atomic<BloomProbeFunction> bloom_probe;
+
+}  // namespace internal
+
+/// Collects key hashes and serializes a BloomFilter over them.
+class BloomFilterBuilder {
+ public:
+  /// \param bits_per_key Filter size per key, clamped to [1, 100]. 10 gives
+  ///                     a false positive rate of about 1%.
+  explicit BloomFilterBuilder(double bits_per_key = 10);
+
+  void AddKey(const Slice& key) {
+    AddKeyHash(Hash64(key.data(), key.size()));
+  }
+
+  /// Adds a key by its Hash64(). Repeats of the previous hash are ignored.
+  void AddKeyHash(uint64_t hash) {
+    if (!hashes_.empty() && hashes_.back() == hash) return;
+
+    hashes_.push_back(hash);
+  }
+
+  /// \return The number of distinct hashes added so far.
+  size_t NumAdded() const { return hashes_.size(); }
+
+  /// \return The number of bytes Finish() would append now.
+  size_t EstimatedSize() const;
+
+  /// Appends the serialized filter to `out` and resets the builder.
+  void Finish(std::string* out);
+
+ private:
+  size_t NumLines() const;
+
+  const int millibits_per_key_;
+  std::vector<uint64_t> hashes_;
+};
+
+/// Queries a serialized BloomFilter in place. The contents must outlive the
+/// reader.
+class BloomFilterReader {
+ public:
+  /// If `contents` is not a well-formed filter, the reader answers true to
+  /// every query, which is always safe, and IsValid() is false.
+  explicit BloomFilterReader(const Slice& contents);
+
+  bool IsValid() const { return valid_; }
+
+  /// \return false if `key` was definitely not added; true if it may have
+  ///         been.
+  bool MayContain(const Slice& key) const {
+    return MayContainHash(Hash64(key.data(), key.size()));
+  }
+
+  /// Sets out[i] = MayContain(keys[i]) for i < n. Hashes the keys with
+  /// HashBatch() and prefetches the lines of a batch of keys before testing
+  /// any of them, so that their cache misses overlap; the probes are tested
+  /// with the fastest BloomProbeFunction for the CPU. For MultiGet.
+  void MayContain(const Slice* keys, size_t n, bool* out) const;
+
+  /// Same as above, for keys given by their Hash64().
+  void MayContainHashes(const uint64_t* hashes, size_t n, bool* out) const;
+
+  /// Same as MayContain(), for a key given by its Hash64().
+  bool MayContainHash(uint64_t hash) const {
+    if (num_lines_ == 0) return !valid_;
+
+    const uint8_t* line = Line(hash);
+    uint32_t h = static_cast<uint32_t>(hash >> 32);
+
+    for (int i = 0; i < num_probes_; ++i) {
+      const uint32_t bit = BloomFilter::ProbeBit(h);
+      if ((line[bit >> 3] & (1u << (bit & 7))) == 0) return false;
+      h *= BloomFilter::kProbeMultiplier;
+    }
+
+    return true;
+  }
+
+  uint32_t NumLines() const { return num_lines_; }
+  int NumProbes() const { return num_probes_; }
+
+ private:
+  const uint8_t* Line(uint64_t hash) const {
+    return lines_ + fast_range32(static_cast<uint32_t>(hash), num_lines_) *
+                        BloomFilter::kLineSize;
+  }
+
+  const uint8_t* lines_ = nullptr;
+  uint32_t num_lines_ = 0;
+  int num_probes_ = 0;
+  bool valid_ = false;
+};
+
+}  // namespace badger
@@ -0,0 +1,166 @@
+// A cuckoo filter (Fan et al., "Cuckoo Filter: Practically Better Than
+// Bloom", 2014) with 16-bit fingerprints in buckets of four, resident in an
+// Arena.
+//
+// Unlike BloomFilter and FuseFilter, keys can be deleted, so a filter over a
+// sliding window of keys, as used for deduplication, is kept up to date in
+// place instead of being rebuilt.
+//
+// A key's fingerprint lives in one of two buckets. The first is picked with
+// fast_range64() from its Hash64(); the other is derived from the first and
+// the fingerprint alone, as (f - i) mod num_buckets where f is a hash of the
+// fingerprint, so that an entry can move between its buckets without the
+// key and the table may have any number of buckets. A bucket is a single
+// 64-bit word, so a query reads two words and compares all four slots of
+// each at once.
+//
+// At 95% occupancy the filter takes about 17 bits per key for a false
+// positive rate of about 8 / 65536 (0.012%).
+//
+// Thread safety
+// -------------
+//
+// None; callers must synchronize. The filter is never serialized, so the
+// layout may change.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "cpp-badger/memtable/arena.hh"
+#include "cpp-badger/util/fast_range.hh"
+#include "cpp-badger/util/hash.hh"
+#include "cpp-badger/util/random.hh"
+#include "cpp-badger/util/slice.hh"
+
+namespace badger {
+
+class CuckooFilter {
+  CuckooFilter(const CuckooFilter&) = delete;
+  CuckooFilter& operator=(const CuckooFilter&) = delete;
+
+ public:
+  static constexpr int kSlotsPerBucket = 4;
+  /// Key counts are divided by this to size the table.
+  static constexpr double kMaxLoadFactor = 0.95;
+  /// Entries moved by one AddKeyHash() before the table counts as full.
+  static constexpr int kMaxKicks = 500;
+
+  /// Creates an empty filter with room for `capacity` keys, allocated from
+  /// `arena`, which must outlive the filter.
+  ///
+  /// \throws std::bad_alloc if the table cannot be allocated.
+  CuckooFilter(Arena* arena, size_t capacity);
+
+  /// \return false if the filter is full. If a key was being kept aside,
+  ///         it is tried again first and this key is not added; otherwise
+  ///         this key is added, but another is now kept aside. Either way no
+  ///         added key goes missing.
+  bool AddKey(const Slice& key) {
+    return AddKeyHash(Hash64(key.data(), key.size()));
+  }
+
+  /// Same as AddKey(), for a key given by its Hash64(). Repeats of a key are
+  /// stored again, up to 2 * kSlotsPerBucket times.
+  bool AddKeyHash(uint64_t hash);
+
+  /// Removes one copy of a key.
+  ///
+  /// REQUIRES: the key was added; deleting another key that shares its
+  /// fingerprint and buckets would remove that key instead.
+  /// \return false if no matching fingerprint was found.
+  bool DeleteKey(const Slice& key) {
+    return DeleteKeyHash(Hash64(key.data(), key.size()));
+  }
+
+  bool DeleteKeyHash(uint64_t hash);
+
+  /// \return false if `key` is definitely not in the filter; true if it may
+  ///         be.
+  bool MayContain(const Slice& key) const {
+    return MayContainHash(Hash64(key.data(), key.size()));
+  }
+
+  bool MayContainHash(uint64_t hash) const {
+    const uint16_t fp = Fingerprint(hash);
+    const size_t i1 = fast_range64(hash, num_buckets_);
+    const size_t i2 = AltBucket(i1, fp);
+
+    return HasFingerprint(buckets_[i1], fp) ||
+           HasFingerprint(buckets_[i2], fp) ||
+           (victim_fp_ == fp &&
+            (victim_bucket_ == i1 || victim_bucket_ == i2));
+  }
+
+  /// \return The number of keys added and not deleted.
+  size_t Size() const { return size_; }
+
+  size_t NumBuckets() const { return num_buckets_; }
+
+  /// \return The number of slots, an upper bound on Size().
+  size_t Capacity() const { return num_buckets_ * kSlotsPerBucket; }
+
+ private:
+  static constexpr uint64_t kLowBits = 0x0001000100010001ULL;
+  static constexpr uint64_t kHighBits = 0x8000800080008000ULL;
+
+  /// \return The fingerprint of a key hash; never 0, which marks an empty
+  ///         slot. Taken from the low bits, which fast_range64() barely
+  ///         uses to pick the bucket.
+  static uint16_t Fingerprint(uint64_t hash) {
+    const auto fp = static_cast<uint16_t>(hash);
+
+    return fp != 0 ? fp : 1;
+  }
+
+  /// \return The other bucket of fingerprint `fp` in bucket `i`. Applying it
+  ///         twice gives `i` back.
+  size_t AltBucket(size_t i, uint16_t fp) const {
+    const size_t f = fast_range64(fp * 0x9e3779b97f4a7c15ULL, num_buckets_);
+
+    return f >= i ? f - i : f + num_buckets_ - i;
+  }
+
+  /// \return Whether any slot of `bucket` holds `fp`. Exact: a slot that
+  ///         matches makes its lane of `x` zero, and borrows only spread
+  ///         upwards from a zero lane.
+  static bool HasFingerprint(uint64_t bucket, uint16_t fp) {
+    const uint64_t x = bucket ^ (fp * kLowBits);
+
+    return ((x - kLowBits) & ~x & kHighBits) != 0;
+  }
+
+  static uint16_t GetSlot(uint64_t bucket, int slot) {
+    return static_cast<uint16_t>(bucket >> (16 * slot));
+  }
+
+  static void SetSlot(uint64_t* bucket, int slot, uint16_t fp) {
+    *bucket &= ~(uint64_t{0xffff} << (16 * slot));
+    *bucket |= uint64_t{fp} << (16 * slot);
+  }
+
+  /// Stores `fp` in a free slot of bucket `i`, if any.
+  bool TryPut(size_t i, uint16_t fp);
+
+  /// Removes one `fp` from bucket `i`, if any.
+  bool TryRemove(size_t i, uint16_t fp);
+
+  /// Stores `fp`, which belongs in bucket `i`, moving other entries out of
+  /// the way if needed.
+  ///
+  /// \return false if it took too many moves; some fingerprint is then left
+  ///         over as the victim.
+  bool Place(size_t i, uint16_t fp);
+
+  size_t num_buckets_;
+  uint64_t* buckets_;
+  size_t size_ = 0;
+  Random rnd_;
+  /// A fingerprint that could not be placed after kMaxKicks moves, and one
+  /// of its buckets; 0 if none. While it is set the filter is full.
+  uint16_t victim_fp_ = 0;
+  size_t victim_bucket_ = 0;
+};
+
+}  // namespace badger
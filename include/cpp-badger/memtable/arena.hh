@@ -1,5 +1,6 @@
 #pragma once
 
+#include <algorithm>
 #include <cassert>
 #include <cstddef>
 #include <cstdint>
@@ -7,6 +8,9 @@
 #include <set>
 #include <stdexcept>
 
+#include "cpp-badger/util/perf_context.hh"
+#include "cpp-badger/util/statistics.hh"
+
 namespace badger {
 
 /// The Arena class provides a memory management system that allocates large
@@ -24,8 +28,10 @@ class Arena {
   /// Constructs an Arena with the specified initial block size.
   ///
   /// \param initial_size The size of the first memory block to allocate.
+  ///                     Subsequent blocks are at least this large too.
   /// \throws std::bad_alloc if the initial block cannot be allocated.
-  explicit Arena(size_t initial_size = kDefaultInitialSize) {
+  explicit Arena(size_t initial_size = kDefaultInitialSize)
+      : block_size_(initial_size) {
     assert(initial_size > 0 && "Initial size must be positive");
 
     CreateNewBlock(initial_size);
@@ -36,7 +42,16 @@ class Arena {
   /// Move constructor.
   ///
   /// \param other The Arena to move from.
-  Arena(Arena&& other) noexcept : blocks_(std::move(other.blocks_)) {}
+  Arena(Arena&& other) noexcept
+      : block_size_(other.block_size_),
+        blocks_(std::move(other.blocks_)),
+        stats_(other.stats_) {}
+
+  /// Records allocations in `stats`, which must outlive the arena; null
+  /// stops recording.
+  ///
+  /// REQUIRES: no concurrent Allocate().
+  void SetStatistics(Statistics* stats) { stats_ = stats; }
 
   /// Allocates memory with the specified size and alignment.
   ///
@@ -46,9 +61,14 @@ class Arena {
   /// \throws std::bad_alloc if memory allocation fails.
   void* Allocate(size_t size, size_t alignment = alignof(std::max_align_t)) {
     if (size == 0) return nullptr;
+    BADGER_PERF_COUNTER_ADD(arena_bytes_allocated, size);
+    if (stats_ != nullptr) RecordAllocation(size);
     if (auto p = TryAllocateFromExistingBlock(size, alignment)) return p;
 
-    CreateNewBlock(size, alignment);
+    // Never create blocks smaller than the configured block size; otherwise
+    // every allocation after the first block fills up would get its own
+    // block and make the search above linear in the number of allocations.
+    CreateNewBlock(std::max(size, block_size_), alignment);
     auto p = TryAllocateFromExistingBlock(size, alignment);
 
     assert(p);
@@ -67,6 +87,13 @@ class Arena {
 
   void Dump(std::ostream& os);
 
+  /// \return The total capacity of all blocks owned by this arena.
+  size_t MemoryAllocatedBytes() const;
+
+  /// \return The number of bytes handed out so far, including alignment
+  ///         padding.
+  size_t ApproximateMemoryUsage() const;
+
  private:
   class MemoryBlock {
    public:
@@ -140,6 +167,12 @@ class Arena {
     return (address + alignment - 1) & ~(alignment - 1);
   }
 
+  void RecordAllocation(size_t size) {
+    stats_->RecordTick(kArenaAllocations);
+    stats_->RecordTick(kArenaAllocatedBytes, size);
+    stats_->RecordInHistogram(kArenaAllocationBytes, size);
+  }
+
   /// Create a new block with the specified size.
   ///
   /// \param size The number of bytes to allocate.
@@ -173,7 +206,9 @@ class Arena {
     return nullptr;
   }
 
+  size_t block_size_;
   std::multiset<MemoryBlock> blocks_;
+  Statistics* stats_ = nullptr;
 };
 
 // Arena-based allocator for STL containers
@@ -0,0 +1,154 @@
+// A read-only copy of a sealed MemTable laid out as a contiguous sorted array.
+//
+// Once a memtable stops taking writes it only serves reads until it is
+// flushed, yet the skiplist keeps paying for its towers and pointer chasing.
+// CompactMemTable packs the entries back to back in internal key order and
+// searches them through an offset table, so the skiplist and its arena can be
+// released while the data waits for flush.
+//
+// Layout
+// ------
+//
+//   data_      entry 0 | entry 1 | ... | entry n-1, each encoded as
+//                varint32 user_key_size | user_key | fixed64 tag | value
+//   offsets_   n + 1 offsets into data_; entry i is [offsets_[i],
+//              offsets_[i + 1]), so value sizes are implicit
+//   index_     the first 8 bytes of every kIndexInterval-th user key as a
+//              big-endian integer, which narrows a seek to a few entries
+//              with integer comparisons over contiguous memory
+//
+// Thread safety
+// -------------
+//
+// Immutable after construction; all methods may be called concurrently.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "cpp-badger/memtable/memtable.hh"
+#include "cpp-badger/memtable/merge_operator.hh"
+#include "cpp-badger/memtable/range_tombstone_fragmenter.hh"
+#include "cpp-badger/util/slice.hh"
+#include "cpp-badger/util/threadpool.hh"
+
+namespace badger {
+
+class CompactMemTable {
+  CompactMemTable(const CompactMemTable&) = delete;
+  CompactMemTable& operator=(const CompactMemTable&) = delete;
+
+ public:
+  /// Number of entries between two sparse index samples.
+  static constexpr size_t kIndexInterval = 16;
+
+  /// Copies every entry and range tombstone of `mem`, including versions
+  /// that are shadowed at the latest sequence number, so that reads at any
+  /// sequence number return the same results as `mem`.
+  ///
+  /// REQUIRES: `mem` is sealed; no writes are in flight.
+  /// \throw std::length_error if the packed entries exceed 4 GiB.
+  explicit CompactMemTable(const MemTable& mem);
+
+  using ConvertCallback =
+      std::function<void(std::shared_ptr<const CompactMemTable>)>;
+
+  /// Converts `mem` on `executor` and passes the result to `done` on the
+  /// executor thread. The task drops its reference to `mem` before calling
+  /// `done`, so once the caller swaps `mem` for the result the arena is freed.
+  /// `done` receives nullptr if the conversion failed, in which case `mem`
+  /// should simply be kept.
+  static void ScheduleConversion(Executor* executor,
+                                 std::shared_ptr<const MemTable> mem,
+                                 ConvertCallback done);
+
+  /// Same as MemTable::Get().
+  LookupResult Get(const Slice& key, SequenceNumber seq,
+                   std::string* value) const;
+
+  /// Same as MemTable::GetRangeTombstones(); the list references memory owned
+  /// by this object.
+  std::shared_ptr<const FragmentedRangeTombstoneList> GetRangeTombstones()
+      const {
+    return range_tombstones_;
+  }
+
+  /// \return The number of point entries.
+  uint64_t NumEntries() const { return offsets_.size() - 1; }
+
+  /// \return The number of range tombstones.
+  uint64_t NumRangeDeletes() const {
+    return range_tombstones_->num_unfragmented_tombstones();
+  }
+
+  /// \return The number of bytes held by the array, its index and the range
+  ///         tombstones.
+  size_t ApproximateMemoryUsage() const;
+
+  /// Same semantics as MemTable::Iterator.
+  class Iterator {
+   public:
+    Iterator(const CompactMemTable* mem, SequenceNumber read_seq);
+
+    bool Valid() const { return pos_ < mem_->NumEntries(); }
+
+    /// Positions at the first entry whose user key is >= `user_key`.
+    void Seek(const Slice& user_key);
+    void SeekToFirst();
+    void SeekToLast();
+    void Next();
+    void Prev();
+
+    Slice key() const;
+    SequenceNumber sequence() const;
+    ValueType type() const;
+    Slice value() const;
+
+   private:
+    bool IsHidden() const;
+    void SkipForward();
+
+    const CompactMemTable* mem_;
+    SequenceNumber read_seq_;
+    /// Index of the current entry; NumEntries() when invalid.
+    size_t pos_;
+  };
+
+ private:
+  /// A decoded view of an entry.
+  struct Entry {
+    Slice user_key;
+    uint64_t tag;
+    Slice value;
+  };
+
+  /// \return A decoded view of entry i.
+  /// \throw std::runtime_error if the entry does not decode; the bytes are
+  ///        written once by the constructor, so this means memory corruption.
+  Entry GetEntry(size_t i) const;
+
+  /// \return The index of the first entry that sorts at or after
+  ///         (user_key, seq), or NumEntries() if there is none.
+  size_t LowerBound(const Slice& user_key, SequenceNumber seq) const;
+
+  /// \return The first 8 bytes of `key` as a big-endian integer, zero-padded,
+  ///         so that integer order agrees with bytewise order.
+  static uint64_t KeyPrefix(const Slice& key);
+
+  std::shared_ptr<const MergeOperator> merge_operator_;
+
+  std::unique_ptr<char[]> data_;
+  std::vector<uint32_t> offsets_;
+  std::vector<uint64_t> index_;
+
+  /// Backing storage for the start and end keys of the range tombstones.
+  std::string tombstone_data_;
+  std::shared_ptr<const FragmentedRangeTombstoneList> range_tombstones_;
+};
+
+}  // namespace badger
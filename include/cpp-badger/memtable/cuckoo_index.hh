@@ -0,0 +1,164 @@
+// An in-memory hash index from keys to 64-bit values, such as file offsets
+// for a hash-indexed table or row cache handles, built as a concurrent
+// cuckoo hash table in an Arena.
+//
+// A key may live in one of two buckets, picked with fast_range64() from two
+// independently seeded Hash64()s. A bucket is one cache line holding six
+// slots: a pointer to an arena-resident entry (key and value) and a 16-bit
+// tag of the key hash that filters out most mismatches without touching the
+// entry. When both buckets of a new key are full, the writer searches for a
+// path of entries to move to their alternate buckets, breadth first, and
+// moves them one at a time from the end of the path.
+//
+// Thread safety
+// -------------
+//
+// All methods are thread-safe.
+//
+// Readers take no locks. Each bucket has a version that writers make odd
+// while they change the bucket; Get() reads the versions of both buckets of
+// the key, searches them and retries if either version changed. Since an
+// entry only ever moves between its own two buckets, and the move changes
+// both versions, a reader never misses an entry that is in the table.
+//
+// Writers lock the stripes of the buckets they change (two at a time, in
+// stripe order), so writers to unrelated buckets rarely contend. Entries
+// are allocated from the arena under an internal mutex: nothing else may
+// allocate from the arena while writers run.
+//
+// Invariants:
+//
+// (1) Entries are never freed until the arena is. Erase() and moves only
+// unlink them, so a reader may safely dereference a stale pointer.
+//
+// (2) The key and hashes of an entry are immutable once it is published;
+// only its value changes, atomically.
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+#include "cpp-badger/memtable/arena.hh"
+#include "cpp-badger/util/slice.hh"
+
+namespace badger {
+
+class CuckooIndex {
+  CuckooIndex(const CuckooIndex&) = delete;
+  CuckooIndex& operator=(const CuckooIndex&) = delete;
+
+ public:
+  static constexpr int kSlotsPerBucket = 6;
+  /// Key counts are divided by this to size the table.
+  static constexpr double kMaxLoadFactor = 0.9;
+
+  /// Creates a table with room for `expected_keys` keys, allocated from
+  /// `arena`. The table does not grow; Insert() fails once it is too full
+  /// to make room, typically well past kMaxLoadFactor.
+  ///
+  /// \param arena Holds the buckets and entries, and must outlive the index.
+  /// \throws std::bad_alloc if the buckets cannot be allocated.
+  CuckooIndex(Arena* arena, size_t expected_keys);
+
+  /// Maps `key` to `value`, replacing the value if `key` is present.
+  ///
+  /// \return false if `key` is absent and the table has no room for it.
+  bool Insert(const Slice& key, uint64_t value);
+
+  /// \return true and sets `*value` if `key` is present.
+  bool Get(const Slice& key, uint64_t* value) const;
+
+  /// Removes `key`. The entry's memory stays in the arena.
+  ///
+  /// \return false if `key` was not present.
+  bool Erase(const Slice& key);
+
+  /// \return The number of keys in the table.
+  size_t Size() const { return size_.load(std::memory_order_relaxed); }
+
+  size_t NumBuckets() const { return num_buckets_; }
+
+  /// \return The number of slots, an upper bound on Size().
+  size_t Capacity() const { return num_buckets_ * kSlotsPerBucket; }
+
+ private:
+  static constexpr size_t kCacheLineSize = 64;
+  static constexpr size_t kNumLockStripes = 64;
+
+  struct Entry {
+    mutable std::atomic<uint64_t> value;
+    /// The two key hashes; the first also gives the tag.
+    uint64_t hashes[2];
+    uint32_t key_size;
+    char key[1];
+
+    Slice GetKey() const { return Slice(key, key_size); }
+  };
+
+  struct alignas(kCacheLineSize) Bucket {
+    /// Odd while a writer changes the bucket.
+    std::atomic<uint32_t> version;
+    std::atomic<uint16_t> tags[kSlotsPerBucket];
+    std::atomic<const Entry*> entries[kSlotsPerBucket];
+  };
+
+  static_assert(sizeof(Bucket) == kCacheLineSize);
+
+  /// Padded to a cache line so that writers locking neighbouring stripes do
+  /// not false-share the mutexes.
+  struct alignas(kCacheLineSize) LockStripe {
+    std::mutex mutex;
+  };
+
+  struct KeyHash {
+    uint64_t hashes[2];
+    size_t buckets[2];
+    uint16_t tag;
+  };
+
+  class StripeGuard;
+
+  KeyHash HashKey(const Slice& key) const;
+
+  static uint16_t Tag(uint64_t hash) { return static_cast<uint16_t>(hash); }
+
+  /// \return The bucket of `entry` other than `bucket`.
+  size_t AltBucket(const Entry& entry, size_t bucket) const;
+
+  /// \return The slot of `bucket` that holds the key of `kh`, or -1.
+  static int FindSlot(const Bucket& bucket, const Slice& key,
+                      const KeyHash& kh);
+  static int FreeSlot(const Bucket& bucket);
+
+  /// Makes the version of `bucket` odd. REQUIRES: its stripe is locked.
+  static void BeginWrite(Bucket* bucket);
+  /// Makes the version of `bucket` even again.
+  static void EndWrite(Bucket* bucket);
+
+  static void SetSlot(Bucket* bucket, int slot, const Entry* entry);
+
+  const Entry* NewEntry(const Slice& key, const KeyHash& kh, uint64_t value);
+
+  /// Tries to free a slot in bucket `b1` or `b2` by moving entries along a
+  /// cuckoo path.
+  ///
+  /// \return false if no path was found or another writer got in the way.
+  bool MakeRoom(size_t b1, size_t b2);
+
+  /// Moves the entry in `slot` of bucket `from` to its other bucket `to`, if
+  /// it is still there and `to` still has a free slot.
+  bool Move(size_t from, int slot, size_t to);
+
+  Arena* const arena_;
+  std::mutex arena_mutex_;
+  size_t num_buckets_;
+  Bucket* buckets_;
+  std::atomic<size_t> size_{0};
+  std::array<LockStripe, kNumLockStripes> stripes_;
+};
+
+}  // namespace badger
@@ -0,0 +1,321 @@
+// Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+//
+// Thread safety
+// -------------
+//
+// Add(), Update() and Merge() require external synchronization, most likely a
+// mutex. Get() and iterators may run concurrently with a single writer, with
+// the same guarantees as SkipList.
+//
+// Entry format
+// ------------
+//
+// Point entries and range tombstones are stored in the arena as
+//
+//   varint32  internal_key_size     (= user_key.size() + 8)
+//   char[]    user_key
+//   fixed64   tag                   (= seq << 8 | type)
+//   varint32  value_size
+//   char[]    value
+//
+// and ordered by user key ascending, then by sequence number descending, so
+// that seeking to (key, seq) lands on the newest version visible at seq.
+// For a range tombstone, user_key is the (inclusive) start key and value is
+// the (exclusive) end key.
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <vector>
+
+#include "cpp-badger/memtable/arena.hh"
+#include "cpp-badger/memtable/merge_operator.hh"
+#include "cpp-badger/memtable/range_tombstone_fragmenter.hh"
+#include "cpp-badger/memtable/skiplist.hh"
+#include "cpp-badger/util/slice.hh"
+#include "cpp-badger/util/statistics.hh"
+
+namespace badger {
+
+/// Value types encoded as the last component of internal keys.
+enum ValueType : uint8_t {
+  kTypeDeletion = 0x0,
+  kTypeValue = 0x1,
+  kTypeMerge = 0x2,
+  /// A merge operand that combines every older operand of the key in the
+  /// same memtable. Readers stop at it; the older operands are only kept for
+  /// reads at earlier sequence numbers.
+  kTypeFoldedMerge = 0x3,
+  kTypeRangeDeletion = 0xF,
+};
+
+/// Sequence numbers use the upper 56 bits of the packed tag.
+inline constexpr SequenceNumber kMaxSequenceNumber = ((0x1ull << 56) - 1);
+
+inline uint64_t PackSequenceAndType(SequenceNumber seq, ValueType t) {
+  assert(seq <= kMaxSequenceNumber);
+
+  return (seq << 8) | t;
+}
+
+inline void UnPackSequenceAndType(uint64_t packed, SequenceNumber* seq,
+                                  ValueType* t) {
+  *seq = packed >> 8;
+  *t = static_cast<ValueType>(packed & 0xff);
+}
+
+/// Outcome of a MemTable point lookup.
+enum class LookupResult {
+  kNotFound,         ///< The memtable has no entry for the key.
+  kFound,            ///< The newest visible entry is a value.
+  kDeleted,          ///< The newest visible entry is a deletion.
+  kMergeInProgress,  ///< Only merge operands were found; the value holds
+                     ///< them combined and must be applied to older data.
+  kMergeFailed,      ///< The merge operator rejected the operands.
+};
+
+/// Resolves a point lookup from the versions of a single user key, visited
+/// newest first. Shared by the memtable representations so that they agree on
+/// merge and deletion semantics.
+class KeyVersionResolver {
+ public:
+  /// \param tombstone_seq Sequence number of the newest visible range
+  ///                      tombstone covering the key, or 0 if there is none.
+  explicit KeyVersionResolver(SequenceNumber tombstone_seq)
+      : tombstone_seq_(tombstone_seq),
+        result_(tombstone_seq > 0 ? LookupResult::kDeleted
+                                  : LookupResult::kNotFound) {}
+
+  /// Feeds the next older visible version of the key.
+  ///
+  /// \return false once older versions can no longer affect the result.
+  bool Visit(SequenceNumber seq, ValueType type, const Slice& value);
+
+  /// \param merge_operator Required if any merge operand was visited.
+  /// \param value Receives the value as documented by MemTable::Get().
+  LookupResult Finish(const MergeOperator* merge_operator, const Slice& key,
+                      std::string* value) const;
+
+ private:
+  SequenceNumber tombstone_seq_;
+  LookupResult result_;
+  Slice base_;
+  std::vector<Slice> operands_;  // newest first
+};
+
+struct MemTableOptions {
+  /// Size of each block allocated by the memtable arena.
+  size_t arena_block_size = Arena::kDefaultInitialSize;
+
+  /// When true, Update() overwrites the value of the newest entry for a key
+  /// in place if the new value is not larger than the old one, instead of
+  /// inserting a new entry. This bounds memory by the number of distinct keys
+  /// for overwrite-heavy workloads (e.g. counters), at the cost of snapshot
+  /// consistency: the overwritten entry keeps its original sequence number,
+  /// so every reader that could see the old value sees the new one instead.
+  bool inplace_update_support = false;
+
+  /// Number of striped locks protecting in-place updates. Only used when
+  /// inplace_update_support is true.
+  size_t inplace_update_num_locks = 10000;
+
+  /// Operator used to fold the operands written with Merge(). Required if
+  /// Merge() is used.
+  std::shared_ptr<const MergeOperator> merge_operator;
+
+  /// When a key already has this many successive merge operands in this
+  /// memtable, Merge() folds them together with the new operand, so reads
+  /// never fold longer chains. The result is stored as a plain value if the
+  /// chain sits on a value (or deletion), and as a kTypeFoldedMerge operand
+  /// otherwise. 0 disables folding on write.
+  size_t max_successive_merges = 0;
+
+  /// If not null, the arena and skiplists record into it; must outlive the
+  /// memtable.
+  Statistics* statistics = nullptr;
+};
+
+class MemTable {
+  MemTable(const MemTable&) = delete;
+  MemTable& operator=(const MemTable&) = delete;
+
+ public:
+  explicit MemTable(const MemTableOptions& options = MemTableOptions());
+
+  /// Adds an entry that maps `key` to `value` at sequence number `seq`.
+  ///
+  /// For kTypeDeletion `value` is ignored (typically empty). For
+  /// kTypeRangeDeletion `key` is the inclusive start and `value` the
+  /// exclusive end of the deleted range; the tombstone is stored once in a
+  /// separate skiplist regardless of how many keys it covers.
+  ///
+  /// REQUIRES: external synchronization; no other entry with the same `key`
+  ///           and `seq` has been added.
+  void Add(SequenceNumber seq, ValueType type, const Slice& key,
+           const Slice& value);
+
+  /// Same as Add() with the concatenations of `key` and `value`, which are
+  /// gathered directly into the memtable without an intermediate copy.
+  void Add(SequenceNumber seq, ValueType type, const SliceParts& key,
+           const SliceParts& value);
+
+  /// Writes `key` => `value` at sequence number `seq`. With
+  /// inplace_update_support, the value of the newest entry for `key` is
+  /// overwritten in place when that entry is a live value whose slot is large
+  /// enough; otherwise this is the same as Add(seq, kTypeValue, key, value).
+  ///
+  /// REQUIRES: external synchronization.
+  void Update(SequenceNumber seq, const Slice& key, const Slice& value);
+
+  /// Appends the merge operand `operand` for `key` at sequence number `seq`.
+  /// Operands are folded lazily by Get() using the configured merge
+  /// operator, or eagerly once max_successive_merges is reached.
+  ///
+  /// REQUIRES: external synchronization; a merge operator is configured.
+  void Merge(SequenceNumber seq, const Slice& key, const Slice& operand);
+
+  /// Deletes every key in [begin, end) that is older than `seq`.
+  void DeleteRange(SequenceNumber seq, const Slice& begin, const Slice& end) {
+    Add(seq, kTypeRangeDeletion, begin, end);
+  }
+
+  /// Looks up the newest version of `key` visible at sequence number `seq`,
+  /// taking point entries, merge operands and range tombstones into account.
+  ///
+  /// \param value Receives the value if the result is kFound, or the combined
+  ///              merge operands if the result is kMergeInProgress.
+  LookupResult Get(const Slice& key, SequenceNumber seq,
+                   std::string* value) const;
+
+  /// \return A fragmented, non-overlapping view of all range tombstones added
+  ///         so far. Built lazily and cached until the next DeleteRange().
+  ///         The returned list references memtable memory and must not
+  ///         outlive the memtable.
+  std::shared_ptr<const FragmentedRangeTombstoneList> GetRangeTombstones()
+      const;
+
+  const MemTableOptions& options() const { return options_; }
+
+  /// \return The number of point entries.
+  uint64_t NumEntries() const {
+    return num_entries_.load(std::memory_order_relaxed);
+  }
+
+  /// \return The number of range tombstones.
+  uint64_t NumRangeDeletes() const {
+    return num_range_deletes_.load(std::memory_order_relaxed);
+  }
+
+  /// \return The number of updates that were applied in place.
+  uint64_t NumInplaceUpdates() const {
+    return num_inplace_updates_.load(std::memory_order_relaxed);
+  }
+
+  /// \return The number of arena bytes used by entries and skiplist nodes.
+  ///
+  /// REQUIRES: external synchronization, as for Add().
+  size_t ApproximateMemoryUsage() const {
+    return arena_.ApproximateMemoryUsage();
+  }
+
+  /// Compares two encoded entries by internal key.
+  struct KeyComparator {
+    int operator()(const char* a, const char* b) const;
+  };
+
+  using Table = SkipList<const char*, KeyComparator>;
+
+  /// Iterates point entries in internal key order: user key ascending, then
+  /// sequence number descending. Entries newer than the read sequence number
+  /// and entries deleted by a range tombstone visible at the read sequence
+  /// number are skipped. Range tombstones themselves are exposed through
+  /// GetRangeTombstones(). Merge operands are returned as is (kTypeMerge or
+  /// kTypeFoldedMerge); entries below a kTypeFoldedMerge are already part of
+  /// it.
+  ///
+  /// value() does not take the in-place update locks; with
+  /// inplace_update_support it may observe a concurrent overwrite.
+  class Iterator {
+   public:
+    Iterator(const MemTable* mem, SequenceNumber read_seq);
+
+    bool Valid() const { return iter_.Valid(); }
+
+    /// Positions at the first entry whose user key is >= `user_key`.
+    void Seek(const Slice& user_key);
+    void SeekToFirst();
+    void SeekToLast();
+    void Next();
+    void Prev();
+
+    Slice key() const;
+    SequenceNumber sequence() const;
+    ValueType type() const;
+    Slice value() const;
+
+   private:
+    bool IsHidden() const;
+    void SkipForward();
+    void SkipBackward();
+
+    Table::Iterator iter_;
+    SequenceNumber read_seq_;
+    std::shared_ptr<const FragmentedRangeTombstoneList> tombstones_;
+    std::string scratch_;
+  };
+
+ private:
+  friend class CompactMemTable;
+
+  /// Tries to overwrite the newest entry of `key` in place.
+  ///
+  /// \return true on success; false if a new entry must be added instead.
+  bool UpdateInPlace(const Slice& key, const Slice& value);
+
+  /// \return The number of merge operands, up to `limit`, at the top of the
+  ///         chain of `key`. A kTypeFoldedMerge operand counts as one and
+  ///         ends the chain.
+  size_t CountSuccessiveMerges(const Slice& key, size_t limit) const;
+
+  /// \return The sequence number of the newest range tombstone covering `key`
+  ///         that is visible at `seq`, or 0 if there is none.
+  SequenceNumber MaxCoveringTombstoneSeqnum(const Slice& key,
+                                            SequenceNumber seq) const;
+
+  /// \return The lock guarding in-place updates of `key`.
+  std::shared_mutex& GetLock(const Slice& key) const;
+
+  const MemTableOptions options_;
+  KeyComparator comparator_;
+  Arena arena_;
+  Table table_;
+  Table range_del_table_;
+
+  std::atomic<uint64_t> num_entries_{0};
+  std::atomic<uint64_t> num_range_deletes_{0};
+  std::atomic<uint64_t> num_inplace_updates_{0};
+
+  /// Striped locks for in-place updates; empty unless
+  /// inplace_update_support is set.
+  std::unique_ptr<std::shared_mutex[]> locks_;
+
+  /// Serializes rebuilding and invalidating the fragmented tombstones;
+  /// readers only load the published list.
+  mutable std::mutex range_del_mutex_;
+  mutable std::atomic<std::shared_ptr<const FragmentedRangeTombstoneList>>
+      fragmented_range_tombstones_;
+};
+
+}  // namespace badger
@@ -0,0 +1,51 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+
+#pragma once
+
+#include <string>
+
+#include "cpp-badger/util/slice.hh"
+
+namespace badger {
+
+/// An associative merge operator: merging is a binary operation
+/// Merge(a, b) that is associative, so any two adjacent operands can be
+/// combined into one without knowing the value they will be applied to.
+/// Examples are counters (addition), max/min and string append.
+///
+/// Operands are written with MemTable::Merge() and folded lazily when the
+/// key is read.
+class MergeOperator {
+ public:
+  virtual ~MergeOperator() = default;
+
+  /// Combines `existing_value` with `value`, which is newer.
+  ///
+  /// \param key The key the operands belong to.
+  /// \param existing_value The older value or operand; nullptr if the key does
+  ///                       not exist.
+  /// \param value The newer operand.
+  /// \param new_value Receives the result.
+  /// \return false if the operands are malformed; the merge then fails.
+  virtual bool Merge(const Slice& key, const Slice* existing_value,
+                     const Slice& value, std::string* new_value) const = 0;
+
+  /// \return The name of this operator; used to detect mismatches when data
+  ///         written with one operator is read with another.
+  virtual const char* Name() const = 0;
+};
+
+/// Adds unsigned 64-bit integers encoded as fixed64 (little endian). A
+/// missing existing value counts as zero.
+class UInt64AddOperator : public MergeOperator {
+ public:
+  bool Merge(const Slice& key, const Slice* existing_value, const Slice& value,
+             std::string* new_value) const override;
+
+  const char* Name() const override { return "UInt64AddOperator"; }
+};
+
+}  // namespace badger
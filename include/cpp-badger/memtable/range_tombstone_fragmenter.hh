@@ -0,0 +1,90 @@
+//  Copyright (c) 2018-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+//
+// A range tombstone [start, end)@seq deletes every entry whose user key is
+// in [start, end) and whose sequence number is smaller than seq. Overlapping
+// tombstones are split ("fragmented") at every start/end boundary so that the
+// resulting fragments never overlap. Each fragment keeps the sequence numbers
+// of every tombstone that covers it, newest first, which lets a point lookup
+// find the newest covering tombstone with two binary searches.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "cpp-badger/util/slice.hh"
+
+namespace badger {
+
+using SequenceNumber = uint64_t;
+
+/// An unfragmented range tombstone as written by DeleteRange().
+struct RangeTombstone {
+  Slice start;
+  Slice end;
+  SequenceNumber seq = 0;
+
+  RangeTombstone() = default;
+  RangeTombstone(const Slice& s, const Slice& e, SequenceNumber sn)
+      : start(s), end(e), seq(sn) {}
+};
+
+/// A non-overlapping piece of one or more range tombstones.
+/// [seq_start_idx, seq_end_idx) indexes into
+/// FragmentedRangeTombstoneList::seqs().
+struct RangeTombstoneFragment {
+  Slice start;
+  Slice end;
+  size_t seq_start_idx;
+  size_t seq_end_idx;
+};
+
+/// An immutable, sorted and non-overlapping view over a set of range
+/// tombstones.
+///
+/// The fragments only reference the key bytes of the input tombstones; the
+/// caller must keep that memory alive (for the memtable it lives in the
+/// arena) for as long as the list is in use.
+class FragmentedRangeTombstoneList {
+ public:
+  /// Builds the fragmented list. `tombstones` may be in any order and may
+  /// overlap. Empty ranges (start >= end) are ignored.
+  explicit FragmentedRangeTombstoneList(std::vector<RangeTombstone> tombstones);
+
+  /// \return The largest sequence number of a tombstone that covers
+  ///         `user_key` and is visible at `upper_bound` (seq <= upper_bound),
+  ///         or 0 if there is none.
+  SequenceNumber MaxCoveringTombstoneSeqnum(const Slice& user_key,
+                                            SequenceNumber upper_bound) const;
+
+  /// \return true iff `user_key`@`seq` is deleted by a tombstone that is
+  ///         visible at `upper_bound`.
+  bool ShouldDelete(const Slice& user_key, SequenceNumber seq,
+                    SequenceNumber upper_bound) const {
+    return seq < MaxCoveringTombstoneSeqnum(user_key, upper_bound);
+  }
+
+  const std::vector<RangeTombstoneFragment>& fragments() const {
+    return fragments_;
+  }
+
+  const std::vector<SequenceNumber>& seqs() const { return seqs_; }
+
+  bool IsEmpty() const { return fragments_.empty(); }
+
+  /// \return The number of unfragmented tombstones the list was built from.
+  size_t num_unfragmented_tombstones() const {
+    return num_unfragmented_tombstones_;
+  }
+
+ private:
+  std::vector<RangeTombstoneFragment> fragments_;
+  std::vector<SequenceNumber> seqs_;
+  size_t num_unfragmented_tombstones_;
+};
+
+}  // namespace badger
@@ -0,0 +1,135 @@
+// A memtable façade that hash-partitions the key space across several
+// MemTables, each with its own arena, skiplist and writer lock, so writers to
+// different shards never contend.
+//
+// Thread safety
+// -------------
+//
+// All methods are thread-safe. Writes lock only the shard that owns the key
+// (DeleteRange() locks every shard in turn, since a range spans all of them).
+// Reads are lock-free with the same guarantees as MemTable.
+
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "cpp-badger/memtable/memtable.hh"
+#include "cpp-badger/util/slice.hh"
+
+namespace badger {
+
+class ShardedMemTable {
+  ShardedMemTable(const ShardedMemTable&) = delete;
+  ShardedMemTable& operator=(const ShardedMemTable&) = delete;
+
+ public:
+  static constexpr size_t kDefaultNumShards = 16;
+
+  /// \param num_shards Number of partitions; must be positive.
+  /// \param options Options applied to every shard. arena_block_size is per
+  ///                shard.
+  explicit ShardedMemTable(size_t num_shards = kDefaultNumShards,
+                           const MemTableOptions& options = MemTableOptions());
+
+  /// Same as MemTable::Add(). kTypeRangeDeletion is applied to every shard.
+  void Add(SequenceNumber seq, ValueType type, const Slice& key,
+           const Slice& value);
+  void Add(SequenceNumber seq, ValueType type, const SliceParts& key,
+           const SliceParts& value);
+
+  /// Same as MemTable::Update().
+  void Update(SequenceNumber seq, const Slice& key, const Slice& value);
+
+  /// Same as MemTable::Merge().
+  void Merge(SequenceNumber seq, const Slice& key, const Slice& operand);
+
+  /// Same as MemTable::DeleteRange(); the tombstone is added to every shard.
+  void DeleteRange(SequenceNumber seq, const Slice& begin, const Slice& end) {
+    Add(seq, kTypeRangeDeletion, begin, end);
+  }
+
+  /// Same as MemTable::Get(), routed to the shard that owns `key`.
+  LookupResult Get(const Slice& key, SequenceNumber seq,
+                   std::string* value) const;
+
+  size_t NumShards() const { return shards_.size(); }
+
+  /// \return The index of the shard that owns `key`.
+  size_t ShardIndex(const Slice& key) const;
+  size_t ShardIndex(const SliceParts& key) const;
+
+  /// \return The MemTable backing shard `i`. Writing to it directly bypasses
+  ///         the shard lock.
+  const MemTable& GetShard(size_t i) const { return *shards_[i]->mem; }
+
+  /// \return The number of point entries across all shards.
+  uint64_t NumEntries() const;
+
+  /// \return The arena bytes used by all shards.
+  size_t ApproximateMemoryUsage() const;
+
+  /// Presents the shards as a single stream in internal key order (user key
+  /// ascending, sequence number descending) by k-way merging the per-shard
+  /// MemTable::Iterators. Forward iteration only.
+  class Iterator {
+    // heap_ points into children_.
+    Iterator(const Iterator&) = delete;
+    Iterator& operator=(const Iterator&) = delete;
+
+   public:
+    Iterator(const ShardedMemTable* mem, SequenceNumber read_seq);
+
+    bool Valid() const { return !heap_.empty(); }
+
+    /// Positions at the first entry whose user key is >= `user_key`.
+    void Seek(const Slice& user_key);
+    void SeekToFirst();
+    void Next();
+
+    Slice key() const { return Current()->key(); }
+    SequenceNumber sequence() const { return Current()->sequence(); }
+    ValueType type() const { return Current()->type(); }
+    Slice value() const { return Current()->value(); }
+
+   private:
+    MemTable::Iterator* Current() const {
+      assert(Valid());
+      return heap_.front();
+    }
+
+    /// Rebuilds the heap from all valid child iterators.
+    void BuildHeap();
+
+    std::vector<MemTable::Iterator> children_;
+    /// Min-heap of the valid children, ordered by their current entry.
+    std::vector<MemTable::Iterator*> heap_;
+  };
+
+ private:
+  static constexpr size_t kCacheLineSize = 64;
+
+  /// Padded to a cache line so that writers locking neighbouring shards do
+  /// not false-share the mutexes.
+  struct alignas(kCacheLineSize) Shard {
+    explicit Shard(const MemTableOptions& options)
+        : mem(std::make_unique<MemTable>(options)) {}
+
+    std::mutex mutex;
+    std::unique_ptr<MemTable> mem;
+  };
+
+  template <typename Key>
+  Shard& GetShardFor(const Key& key) const {
+    return *shards_[ShardIndex(key)];
+  }
+
+  std::vector<std::unique_ptr<Shard>> shards_;
+};
+
+}  // namespace badger
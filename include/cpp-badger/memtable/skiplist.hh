@@ -33,11 +33,15 @@
 
 #include <stdlib.h>
 
+#include <algorithm>
 #include <atomic>
+#include <bit>
 #include <cassert>
 
 #include "cpp-badger/memtable/arena.hh"
+#include "cpp-badger/util/perf_context.hh"
 #include "cpp-badger/util/random.hh"
+#include "cpp-badger/util/statistics.hh"
 
 namespace badger {
 
@@ -76,6 +80,13 @@ class SkipList {
   // REQUIRES: nothing that compares equal to key is currently in the list.
   void Insert(const Key& key);
 
+  /// Records inserts and their latency in `stats`, which must outlive the
+  /// list; null stops recording. Node allocations are recorded by the
+  /// allocator's own statistics, if any.
+  ///
+  /// REQUIRES: external synchronization, as for Insert().
+  void SetStatistics(Statistics* stats) { stats_ = stats; }
+
   // Returns true iff an entry that compares equal to key is in the list.
   bool Contains(const Key& key) const;
 
@@ -135,14 +146,21 @@ class SkipList {
 
   Node* NewNode(const Key& key, int height);
   int RandomHeight();
-  bool Equal(const Key& a, const Key& b) const { return (compare_(a, b) == 0); }
+  /// compare_(), counted in the perf context.
+  int Compare(const Key& a, const Key& b) const {
+    BADGER_PERF_COUNTER_ADD(user_key_comparison_count, 1);
+
+    return compare_(a, b);
+  }
+
+  bool Equal(const Key& a, const Key& b) const { return (Compare(a, b) == 0); }
   bool LessThan(const Key& a, const Key& b) const {
-    return (compare_(a, b) < 0);
+    return (Compare(a, b) < 0);
   }
 
   // Return true if key is greater than the data stored in "n"
   bool KeyIsAfterNode(const Key& key, Node* n) const {
-    return (n != nullptr) && (compare_(n->key, key) < 0);
+    return (n != nullptr) && (Compare(n->key, key) < 0);
   }
 
   // Returns the earliest node with a key >= key.
@@ -161,7 +179,8 @@ class SkipList {
 
   const uint16_t kMaxHeight_;
   const uint16_t kBranching_;
-  const uint32_t kScaledInverseBranching_;
+  /// 2^32 / kBranching_: a height is promoted when a 32-bit draw is below it.
+  const uint64_t kScaledInverseBranching_;
 
   Comparator compare_;
   Allocator* allocator_;
@@ -178,6 +197,12 @@ class SkipList {
   /// insertion, in which case max_height_ and prev_height_ are 1.
   Node** prev_;
   int32_t prev_height_;
+
+  /// Used only by Insert(), which is externally synchronized, so it needs no
+  /// thread-local lookup.
+  RandomGenerator rnd_;
+
+  Statistics* stats_ = nullptr;
 };
 
 template <typename Key, class Comparator>
@@ -229,12 +254,13 @@ SkipList<Key, Comparator>::SkipList(const Comparator cmp, Allocator* allocator,
                                     int32_t branching_factor)
     : kMaxHeight_(static_cast<uint16_t>(max_height)),
       kBranching_(static_cast<uint16_t>(branching_factor)),
-      kScaledInverseBranching_((Random::kMaxNext + 1) / kBranching_),
+      kScaledInverseBranching_((uint64_t{1} << 32) / kBranching_),
       compare_(cmp),
       allocator_(allocator),
       head_(NewNode(0 /* any key will do */, max_height)),
       max_height_(1),
-      prev_height_(1) {
+      prev_height_(1),
+      rnd_(0xdeadbeef) {
   assert(max_height > 0 && kMaxHeight_ == static_cast<uint32_t>(max_height));
   assert(branching_factor > 0 &&
          kBranching_ == static_cast<uint32_t>(branching_factor));
@@ -279,6 +305,10 @@ uint64_t SkipList<Key, Comparator>::EstimateCount(const Key& key) const {
 
 template <typename Key, class Comparator>
 void SkipList<Key, Comparator>::Insert(const Key& key) {
+  BADGER_PERF_TIMER_GUARD(skiplist_insert_nanos);
+  StopWatch timer(stats_, kSkipListInsertNanos);
+  RecordTick(stats_, kSkipListInserts);
+
   // fast path for sequential insertion
   if (!KeyIsAfterNode(key, prev_[0]->NoBarrier_Next(0)) &&
       (prev_[0] == head_ || KeyIsAfterNode(key, prev_[0]))) {
@@ -423,13 +453,19 @@ typename SkipList<Key, Comparator>::Node* SkipList<Key, Comparator>::NewNode(
 
 template <typename Key, class Comparator>
 int SkipList<Key, Comparator>::RandomHeight() {
-  auto rnd = Random::GetTLSInstance();
-
   // Increase height with probability 1 in kBranching
   int height = 1;
 
-  while (height < kMaxHeight_ && rnd->Next() < kScaledInverseBranching_)
-    height++;
+  if (kBranching_ > 1 && std::has_single_bit(kBranching_)) {
+    // Each run of log2(kBranching) zero bits at the bottom of a draw is one
+    // more level; one draw and no branches.
+    const int bits_per_level = std::countr_zero(kBranching_);
+    height = std::min<int>(
+        kMaxHeight_, 1 + std::countr_zero(rnd_.Next()) / bits_per_level);
+  } else {
+    while (height < kMaxHeight_ && rnd_.Next32() < kScaledInverseBranching_)
+      height++;
+  }
 
   assert(height > 0);
   assert(height <= kMaxHeight_);
@@ -459,9 +495,11 @@ SkipList<Key, Comparator>::FindGreaterOrEqual(const Key& key) const {
     assert(x == head_ || KeyIsAfterNode(key, x));
 
     int cmp =
-        (next == nullptr || next == last_bigger) ? 1 : compare_(next->key, key);
+        (next == nullptr || next == last_bigger) ? 1 : Compare(next->key, key);
 
     if (cmp == 0 || (cmp > 0 && level == 0)) {
+      BADGER_PERF_COUNTER_ADD(skiplist_levels_traversed,
+                              GetMaxHeight() - level);
       return next;
     } else if (cmp < 0) {
       // Keep searching in this list
@@ -498,6 +536,7 @@ SkipList<Key, Comparator>::FindLessThan(const Key& key, Node** prev) const {
         prev[level] = x;
       }
       if (level == 0) {
+        BADGER_PERF_COUNTER_ADD(skiplist_levels_traversed, GetMaxHeight());
         return x;
       } else {
         // Switch to next list, reuse KeyIUsAfterNode() result
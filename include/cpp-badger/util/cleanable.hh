@@ -8,11 +8,16 @@
 
 #pragma once
 
+#include <cassert>
 #include <utility>
-#include <vector>
+
+#include "cpp-badger/util/perf_context.hh"
 
 namespace badger {
 
+/// Cleanups are kept in a singly linked list whose head is embedded in the
+/// object, so registering the first cleanup (the common case) does not
+/// allocate. A tail pointer lets DelegateCleanupsTo() splice lists in O(1).
 class Cleanable {
   Cleanable(Cleanable&) = delete;
   Cleanable& operator=(Cleanable&) = delete;
@@ -26,8 +31,8 @@ class Cleanable {
   using CleanupFunction = void (*)(void* arg1, void* arg2);
 
   Cleanable() = default;
-  Cleanable(Cleanable&& other) noexcept = default;
-  Cleanable& operator=(Cleanable&& other) noexcept = default;
+  Cleanable(Cleanable&& other) noexcept { *this = std::move(other); }
+  Cleanable& operator=(Cleanable&& other) noexcept;
 
   /// Executes all the registered cleanups.
   ~Cleanable() { DoCleanup(); }
@@ -45,10 +50,25 @@ class Cleanable {
   ///                 void* arg2)`.
   /// \param arg1 First argument to pass to the cleanup function.
   /// \param arg2 Second argument to pass to the cleanup function.
-  void RegisterCleanup(CleanupFunction function, void* arg1, void* arg2);
+  inline void RegisterCleanup(CleanupFunction function, void* arg1,
+                              void* arg2) {
+    assert(function != nullptr);
+
+    BADGER_PERF_COUNTER_ADD(cleanups_registered, 1);
+
+    if (HasCleanups()) {
+      RegisterCleanupSlow(function, arg1, arg2);
+      return;
+    }
+
+    cleanup_.function = function;
+    cleanup_.arg1 = arg1;
+    cleanup_.arg2 = arg2;
+  }
 
   /// Move the cleanups owned by this Cleanable to another Cleanable, adding to
-  /// any existing cleanups it has
+  /// any existing cleanups it has. Does not allocate if `other` has no
+  /// cleanups yet; otherwise allocates at most one list node.
   ///
   /// \param other Pointer to the target `Cleanable` that will take ownership
   ///              of the cleanups. After this call, this object no longer
@@ -60,46 +80,45 @@ class Cleanable {
 
   /// \return `true` if there is at least one cleanup function registered;
   ///         `false` otherwise.
-  inline bool HasCleanups() { return !cleanups_.empty(); }
+  inline bool HasCleanups() const { return cleanup_.function != nullptr; }
 
  protected:
   struct Cleanup {
-    Cleanup(const Cleanup&) = default;
-    Cleanup& operator=(const Cleanup&) = delete;
-
-    Cleanup() = default;
-    Cleanup(CleanupFunction func, void* a1, void* a2)
-        : function(func), arg1(a1), arg2(a2) {}
-    Cleanup(Cleanup&& other) noexcept
-        : function(std::exchange(other.function, nullptr)),
-          arg1(std::exchange(other.arg1, nullptr)),
-          arg2(std::exchange(other.arg2, nullptr)) {}
-
-    ~Cleanup() {
-      if (function != nullptr) (*function)(arg1, arg2);
-    }
+    CleanupFunction function = nullptr;
+    void* arg1 = nullptr;
+    void* arg2 = nullptr;
+    /// Heap-allocated, owned by the list.
+    Cleanup* next = nullptr;
+  };
 
-    Cleanup& operator=(Cleanup&& other) noexcept {
-      if (this != &other) {
-        function = std::exchange(other.function, nullptr);
-        arg1 = std::exchange(other.arg1, nullptr);
-        arg2 = std::exchange(other.arg2, nullptr);
-      }
+  /// The first cleanup; empty iff function is nullptr.
+  Cleanup cleanup_;
+  /// The last cleanup in the list; &cleanup_ when there are fewer than two.
+  Cleanup* tail_ = &cleanup_;
 
-      return *this;
+ private:
+  /// Performs all the cleanups and leaves the object empty. Making it private
+  /// to prevent misuse.
+  inline void DoCleanup() {
+    if (!HasCleanups()) return;
+
+    if (cleanup_.next != nullptr) {
+      DoCleanupSlow();
+      return;
     }
 
-    CleanupFunction function = nullptr;
-    void* arg1;
-    void* arg2;
-  };
+    // Clear first, so that the function may register new cleanups.
+    const Cleanup head = cleanup_;
+    cleanup_.function = nullptr;
+    head.function(head.arg1, head.arg2);
+  }
 
-  std::vector<Cleanup> cleanups_;
+  void DoCleanupSlow();
+  void RegisterCleanupSlow(CleanupFunction function, void* arg1, void* arg2);
 
- private:
-  /// Performs all the cleanups. It does not reset the pointers. Making it
-  /// private to prevent misuse.
-  inline void DoCleanup() { cleanups_.clear(); }
+  /// Takes the list of `other`, leaving `other` empty.
+  /// REQUIRES: this object has no cleanups.
+  void StealCleanups(Cleanable* other);
 };
 
 /// A copyable, reference-counted pointer to a simple Cleanable that only
@@ -174,6 +193,50 @@ class SharedCleanablePtr {
 
  private:
   struct Impl;
+
+ public:
+  /// Hands out copies of a SharedCleanablePtr to many Cleanables while taking
+  /// references from the shared count `batch_size` at a time, so that pinning
+  /// one block from thousands of results does not do one atomic op per
+  /// result. References that were not handed out are returned, again in one
+  /// atomic op, when the batch is destroyed.
+  class RefBatch {
+   public:
+    /// \param ptr The pointer to copy. It must outlive the batch.
+    /// \param batch_size Number of references to take per atomic op.
+    /// \param defer_unref If true, the copies are released through the
+    ///                    calling thread's deferred unref buffer (see
+    ///                    FlushDeferredUnrefs()) instead of one atomic op
+    ///                    each.
+    RefBatch(const SharedCleanablePtr& ptr, unsigned batch_size,
+             bool defer_unref = false);
+    ~RefBatch();
+
+    RefBatch(const RefBatch&) = delete;
+    RefBatch& operator=(const RefBatch&) = delete;
+
+    /// Same as SharedCleanablePtr::RegisterCopyWith().
+    void RegisterCopyWith(Cleanable* target);
+
+   private:
+    Impl* const ptr_;
+    const unsigned batch_size_;
+    const bool defer_unref_;
+    unsigned available_ = 0;
+  };
+
+  /// Releases the references queued by copies registered with `defer_unref`
+  /// on the calling thread. Each thread queues at most a few hundred such
+  /// references, coalesced per pointer; they are also released when the
+  /// queue fills up and when the thread exits. Cleanups that are only waiting
+  /// on queued references are delayed until then.
+  static void FlushDeferredUnrefs();
+
+ private:
+  class DeferredUnrefs;
+
+  static DeferredUnrefs& ThreadDeferredUnrefs();
+
   Impl* ptr_ = nullptr;
 };
 
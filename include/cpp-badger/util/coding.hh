@@ -0,0 +1,198 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+//
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+//
+// Endian-neutral encoding:
+// * Fixed-length numbers are encoded with least-significant byte first
+// * In addition we support variable length "varint" encoding
+// * Strings are encoded prefixed by their length in varint format
+
+#pragma once
+
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#include "cpp-badger/util/slice.hh"
+
+namespace badger {
+
+inline constexpr bool kLittleEndian =
+    std::endian::native == std::endian::little;
+
+/// The maximum length of a varint in bytes for 32 and 64 bits respectively.
+inline constexpr unsigned int kMaxVarint32Length = 5;
+inline constexpr unsigned int kMaxVarint64Length = 10;
+
+inline void EncodeFixed32(char* buf, uint32_t value) {
+  if constexpr (kLittleEndian) {
+    memcpy(buf, &value, sizeof(value));
+  } else {
+    buf[0] = static_cast<char>(value & 0xff);
+    buf[1] = static_cast<char>((value >> 8) & 0xff);
+    buf[2] = static_cast<char>((value >> 16) & 0xff);
+    buf[3] = static_cast<char>((value >> 24) & 0xff);
+  }
+}
+
+inline void EncodeFixed64(char* buf, uint64_t value) {
+  if constexpr (kLittleEndian) {
+    memcpy(buf, &value, sizeof(value));
+  } else {
+    for (int i = 0; i < 8; ++i)
+      buf[i] = static_cast<char>((value >> (8 * i)) & 0xff);
+  }
+}
+
+inline uint32_t DecodeFixed32(const char* ptr) {
+  if constexpr (kLittleEndian) {
+    uint32_t result;
+    memcpy(&result, ptr, sizeof(result));  // gcc optimizes this to a plain load
+
+    return result;
+  } else {
+    return ((static_cast<uint32_t>(static_cast<unsigned char>(ptr[0]))) |
+            (static_cast<uint32_t>(static_cast<unsigned char>(ptr[1])) << 8) |
+            (static_cast<uint32_t>(static_cast<unsigned char>(ptr[2])) << 16) |
+            (static_cast<uint32_t>(static_cast<unsigned char>(ptr[3])) << 24));
+  }
+}
+
+inline uint64_t DecodeFixed64(const char* ptr) {
+  if constexpr (kLittleEndian) {
+    uint64_t result;
+    memcpy(&result, ptr, sizeof(result));
+
+    return result;
+  } else {
+    uint64_t lo = DecodeFixed32(ptr);
+    uint64_t hi = DecodeFixed32(ptr + 4);
+
+    return (hi << 32) | lo;
+  }
+}
+
+inline void PutFixed32(std::string* dst, uint32_t value) {
+  char buf[sizeof(value)];
+  EncodeFixed32(buf, value);
+  dst->append(buf, sizeof(buf));
+}
+
+inline void PutFixed64(std::string* dst, uint64_t value) {
+  char buf[sizeof(value)];
+  EncodeFixed64(buf, value);
+  dst->append(buf, sizeof(buf));
+}
+
+/// Writes a varint32 into `dst`.
+///
+/// \return A pointer just past the last written byte.
+inline char* EncodeVarint32(char* dst, uint32_t v) {
+  static constexpr uint32_t B = 128;
+  auto* ptr = reinterpret_cast<unsigned char*>(dst);
+
+  while (v >= B) {
+    *(ptr++) = static_cast<unsigned char>(v | B);
+    v >>= 7;
+  }
+
+  *(ptr++) = static_cast<unsigned char>(v);
+
+  return reinterpret_cast<char*>(ptr);
+}
+
+inline void PutVarint32(std::string* dst, uint32_t v) {
+  char buf[kMaxVarint32Length];
+  char* ptr = EncodeVarint32(buf, v);
+  dst->append(buf, static_cast<size_t>(ptr - buf));
+}
+
+/// \return The number of bytes needed to varint encode `v`.
+inline int VarintLength(uint64_t v) {
+  int len = 1;
+
+  while (v >= 128) {
+    v >>= 7;
+    len++;
+  }
+
+  return len;
+}
+
+/// Internal routine for use by the fallback path of GetVarint32Ptr.
+inline const char* GetVarint32PtrFallback(const char* p, const char* limit,
+                                          uint32_t* value) {
+  uint32_t result = 0;
+
+  for (uint32_t shift = 0; shift <= 28 && p < limit; shift += 7) {
+    uint32_t byte = *(reinterpret_cast<const unsigned char*>(p));
+    p++;
+
+    if (byte & 128) {
+      // More bytes are present
+      result |= ((byte & 127) << shift);
+    } else {
+      result |= (byte << shift);
+      *value = result;
+
+      return p;
+    }
+  }
+
+  return nullptr;
+}
+
+/// Parses a varint32 from [p, limit).
+///
+/// \return A pointer just past the parsed value, or nullptr on error.
+inline const char* GetVarint32Ptr(const char* p, const char* limit,
+                                  uint32_t* value) {
+  if (p < limit) {
+    uint32_t result = *(reinterpret_cast<const unsigned char*>(p));
+
+    if ((result & 128) == 0) {
+      *value = result;
+      return p + 1;
+    }
+  }
+
+  return GetVarint32PtrFallback(p, limit, value);
+}
+
+/// Parses a varint32 from the front of `input` and advances past it.
+///
+/// \return true on success; false if `input` does not start with a varint.
+inline bool GetVarint32(Slice* input, uint32_t* value) {
+  const char* p = input->data();
+  const char* limit = p + input->size();
+  const char* q = GetVarint32Ptr(p, limit, value);
+
+  if (q == nullptr) return false;
+
+  *input = Slice(q, static_cast<size_t>(limit - q));
+
+  return true;
+}
+
+inline void PutLengthPrefixedSlice(std::string* dst, const Slice& value) {
+  PutVarint32(dst, static_cast<uint32_t>(value.size()));
+  dst->append(value.data(), value.size());
+}
+
+/// Decodes a length-prefixed slice starting at `data`. The input must be
+/// well formed; no bounds checking is done.
+inline Slice GetLengthPrefixedSlice(const char* data) {
+  uint32_t len = 0;
+  // +5: we assume "data" is not corrupted
+  const char* p = GetVarint32Ptr(data, data + kMaxVarint32Length, &len);
+
+  return Slice(p, len);
+}
+
+}  // namespace badger
@@ -0,0 +1,70 @@
+// An array with one element per CPU core, for counters that many threads
+// update and few read: a thread updates the element of the core it runs on,
+// so threads on different cores never write to the same cache line, and a
+// reader sums the elements.
+//
+// Thread safety
+// -------------
+//
+// The array itself is immutable after construction. A thread can migrate
+// between looking up its element and updating it, so two threads may update
+// the same element; the elements must be safe for that, typically atomics
+// updated with relaxed ordering.
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cassert>
+#include <cstddef>
+#include <memory>
+#include <thread>
+
+#if defined(__linux__)
+#include <sched.h>
+#endif
+
+namespace badger {
+
+template <typename T>
+class CoreLocalArray {
+ public:
+  /// One element per core, rounded up to a power of two.
+  CoreLocalArray()
+      : size_(std::bit_ceil(
+            std::max(1u, std::thread::hardware_concurrency()))),
+        data_(std::make_unique<T[]>(size_)) {}
+
+  size_t Size() const { return size_; }
+
+  /// \return The element of the core the calling thread runs on.
+  T* Access() const { return AccessAtCore(CurrentCore() & (size_ - 1)); }
+
+  /// REQUIRES: core < Size()
+  T* AccessAtCore(size_t core) const {
+    assert(core < size_);
+
+    return &data_[core];
+  }
+
+ private:
+  static size_t CurrentCore() {
+#if defined(__linux__)
+    // A vDSO call (or an rseq read) on recent kernels, a few nanoseconds.
+    const int cpu = sched_getcpu();
+    if (cpu >= 0) return static_cast<size_t>(cpu);
+#endif
+    // Otherwise spread threads over the elements round robin.
+    static std::atomic<size_t> next_thread{0};
+    static thread_local const size_t index =
+        next_thread.fetch_add(1, std::memory_order_relaxed);
+
+    return index;
+  }
+
+  const size_t size_;
+  const std::unique_ptr<T[]> data_;
+};
+
+}  // namespace badger
@@ -0,0 +1,74 @@
+// Kernels that hex-encode and decode into caller-provided buffers, the
+// building block of Slice::ToString(true) and Slice::DecodeHex().
+//
+// On x86-64 the fastest kernel supported by the CPU (AVX2 or SSE2) is picked
+// at runtime on first use; other targets use a table-driven loop.
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+
+namespace badger {
+
+/// Writes the lowercase hex encoding of the `n` bytes at `src`, 2 * n
+/// characters, to `dst`.
+using HexEncodeFunction = void (*)(const char* src, size_t n, char* dst);
+
+/// Decodes the `n` hex digits (either case) at `src` into n / 2 bytes at
+/// `dst`. Returns false if `n` is odd or `src` contains a character that is
+/// not a hex digit, in which case the contents of `dst` are unspecified.
+using HexDecodeFunction = bool (*)(const char* src, size_t n, char* dst);
+
+/// One table lookup per byte.
+void HexEncodeScalar(const char* src, size_t n, char* dst);
+bool HexDecodeScalar(const char* src, size_t n, char* dst);
+
+// SSE2 is baseline on x86-64 only; 32-bit builds must enable it explicitly.
+#if defined(__GNUC__) && \
+    (defined(__x86_64__) || (defined(__i386__) && defined(__SSE2__)))
+#define BADGER_HAVE_X86_HEX 1
+
+/// Encodes 16 bytes and decodes 32 digits at a time.
+void HexEncodeSSE2(const char* src, size_t n, char* dst);
+bool HexDecodeSSE2(const char* src, size_t n, char* dst);
+
+/// Encodes 32 bytes and decodes 64 digits at a time.
+/// REQUIRES: the CPU supports AVX2.
+void HexEncodeAVX2(const char* src, size_t n, char* dst);
+bool HexDecodeAVX2(const char* src, size_t n, char* dst);
+#endif
+
+/// \return The name of the kernels selected for this CPU, e.g. "avx2".
+const char* HexKernelName();
+
+namespace internal {
+
+/// Point to resolvers until the first call, then to the selected kernels.
+/// Constant-initialized, so they are safe to use from static initializers.
+extern std::atomic<HexEncodeFunction> hex_encode;
+extern std::atomic<HexDecodeFunction> hex_decode;
+
+}  // namespace internal
+
+/// Writes the lowercase hex encoding of the `n` bytes at `src` to `dst`.
+///
+/// \param dst Buffer of at least 2 * n bytes.
+inline void HexEncode(const char* src, size_t n, char* dst) {
+  if (n < 16) return HexEncodeScalar(src, n, dst);
+
+  internal::hex_encode.load(std::memory_order_relaxed)(src, n, dst);
+}
+
+/// Decodes the `n` hex digits at `src`; upper and lower case are accepted.
+///
+/// \param dst Buffer of at least n / 2 bytes.
+/// \return false if `n` is odd or `src` contains a character that is not a
+///         hex digit, in which case the contents of `dst` are unspecified.
+inline bool HexDecode(const char* src, size_t n, char* dst) {
+  if (n < 32) return HexDecodeScalar(src, n, dst);
+
+  return internal::hex_decode.load(std::memory_order_relaxed)(src, n, dst);
+}
+
+}  // namespace badger
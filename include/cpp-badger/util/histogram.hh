@@ -0,0 +1,99 @@
+// A histogram of 64-bit values, such as latencies in nanoseconds or sizes in
+// bytes, with log-linear buckets in the manner of HdrHistogram.
+//
+// Values below 16 get a bucket each; above that, every power of two is split
+// into 16 equal buckets. Any value fits, a bucket is found with a few bit
+// operations, and a percentile is off by at most 1/16 of its value.
+//
+// Thread safety
+// -------------
+//
+// None; callers must synchronize. Statistics records into per-core
+// histograms and merges them into one of these on snapshot.
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <limits>
+#include <string>
+
+namespace badger {
+
+class Histogram {
+ public:
+  static constexpr int kSubBucketBits = 4;
+  static constexpr int kSubBuckets = 1 << kSubBucketBits;
+  static constexpr int kNumBuckets = (64 - kSubBucketBits + 1) * kSubBuckets;
+
+  /// \return The index of the bucket that holds `value`.
+  static int BucketIndex(uint64_t value) {
+    if (value < kSubBuckets) return static_cast<int>(value);
+
+    const int shift = std::bit_width(value) - 1 - kSubBucketBits;
+
+    return ((shift + 1) << kSubBucketBits) +
+           static_cast<int>((value >> shift) & (kSubBuckets - 1));
+  }
+
+  /// \return The smallest value in bucket `i`; for i == kNumBuckets, 2^64
+  ///         wrapped to 0.
+  static uint64_t BucketLow(int i) {
+    if (i < kSubBuckets) return static_cast<uint64_t>(i);
+
+    const int shift = (i >> kSubBucketBits) - 1;
+
+    return static_cast<uint64_t>(kSubBuckets + (i & (kSubBuckets - 1)))
+           << shift;
+  }
+
+  void Add(uint64_t value) {
+    ++buckets_[BucketIndex(value)];
+    ++count_;
+    sum_ += value;
+    min_ = std::min(min_, value);
+    max_ = std::max(max_, value);
+  }
+
+  /// Adds the values of `other`.
+  void Merge(const Histogram& other);
+
+  /// Removes all values.
+  void Clear() { *this = Histogram(); }
+
+  uint64_t Count() const { return count_; }
+  uint64_t Sum() const { return sum_; }
+
+  /// \return The smallest value added, or 0 if none.
+  uint64_t Min() const { return count_ > 0 ? min_ : 0; }
+  uint64_t Max() const { return max_; }
+
+  /// \return The mean of the values, or 0 if none.
+  double Average() const {
+    return count_ > 0 ? static_cast<double>(sum_) / count_ : 0;
+  }
+
+  /// \return An estimate of the value below which `p` percent of the values
+  ///         fall, interpolated within its bucket and clamped to [Min(),
+  ///         Max()]; 0 if there are none.
+  double Percentile(double p) const;
+
+  uint64_t BucketCount(int i) const { return buckets_[i]; }
+
+  /// \return A one-line summary: count, average, min, max and the p50, p99
+  ///         and p99.9 percentiles.
+  std::string ToString() const;
+
+ private:
+  friend class Statistics;
+
+  std::array<uint64_t, kNumBuckets> buckets_{};
+  uint64_t count_ = 0;
+  uint64_t sum_ = 0;
+  uint64_t min_ = std::numeric_limits<uint64_t>::max();
+  uint64_t max_ = 0;
+};
+
+}  // namespace badger
@@ -0,0 +1,52 @@
+// A PinnableSlice whose PinSelf(const Slice&) copies into an inline buffer of
+// kInlineSize bytes, and larger values into a caller-provided Arena, so that
+// copying a value out on the read path never calls malloc.
+
+#pragma once
+
+#include <cstddef>
+
+#include "cpp-badger/memtable/arena.hh"
+#include "cpp-badger/util/slice.hh"
+
+namespace badger {
+
+template <size_t kInlineSize = 512>
+class InlinePinnableSlice : public PinnableSlice {
+ public:
+  /// \param arena If not nullptr, values larger than kInlineSize are copied
+  ///              into memory allocated from it, which must outlive every
+  ///              slice pinned to it. Otherwise they fall back to the
+  ///              std::string buffer.
+  explicit InlinePinnableSlice(Arena* arena = nullptr) : arena_(arena) {
+    InitScratch();
+  }
+
+  InlinePinnableSlice(InlinePinnableSlice&& other) : arena_(other.arena_) {
+    InitScratch();
+    PinnableSlice::operator=(std::move(other));
+  }
+
+  InlinePinnableSlice& operator=(InlinePinnableSlice&& other) {
+    PinnableSlice::operator=(std::move(other));
+
+    return *this;
+  }
+
+  static constexpr size_t inline_size() { return kInlineSize; }
+
+ private:
+  static char* AllocateFromArena(void* arena, size_t size) {
+    return static_cast<char*>(static_cast<Arena*>(arena)->Allocate(size, 1));
+  }
+
+  void InitScratch() {
+    SetScratch(inline_buf_, kInlineSize,
+               arena_ != nullptr ? &AllocateFromArena : nullptr, arena_);
+  }
+
+  Arena* arena_;
+  char inline_buf_[kInlineSize];
+};
+
+}  // namespace badger
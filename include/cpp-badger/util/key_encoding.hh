@@ -0,0 +1,221 @@
+// Order-preserving ("normalized") key encoding.
+//
+// Each Put*() appends a field whose encoding compares under memcmp the same
+// way the original values compare, and every encoding is prefix-free, so a
+// key built by appending several fields sorts bytewise exactly like the tuple
+// of its fields. Composite keys encoded this way can therefore be ordered by
+// Slice::Compare() alone, without a custom comparator.
+//
+// * Unsigned integers are stored big-endian.
+// * Signed integers are stored big-endian with the sign bit flipped.
+// * Floating point numbers have the sign bit flipped when positive and all
+//   bits flipped when negative. -0.0 is encoded as +0.0 and every NaN as one
+//   canonical NaN that sorts after +infinity.
+// * Strings have each 0x00 escaped as 0x00 0xFF and end with 0x00 0x01.
+// * Timestamps are signed nanoseconds since the epoch.
+//
+// Get*() decode one field from the front of a Slice and advance it, returning
+// false on malformed input.
+
+#pragma once
+
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <string>
+
+#include "cpp-badger/util/slice.hh"
+
+namespace badger {
+
+namespace internal {
+
+inline void EncodeBigEndian(char* buf, uint64_t value, size_t n) {
+  for (size_t i = 0; i < n; ++i)
+    buf[i] = static_cast<char>(value >> (8 * (n - 1 - i)));
+}
+
+inline uint64_t DecodeBigEndian(const char* buf, size_t n) {
+  uint64_t value = 0;
+
+  for (size_t i = 0; i < n; ++i)
+    value = (value << 8) | static_cast<uint8_t>(buf[i]);
+
+  return value;
+}
+
+inline void PutBigEndian(std::string* dst, uint64_t value, size_t n) {
+  char buf[sizeof(uint64_t)];
+  EncodeBigEndian(buf, value, n);
+  dst->append(buf, n);
+}
+
+inline bool GetBigEndian(Slice* input, uint64_t* value, size_t n) {
+  if (input->size() < n) return false;
+
+  *value = DecodeBigEndian(input->data(), n);
+  input->RemovePrefix(n);
+
+  return true;
+}
+
+inline constexpr uint64_t kSignBit64 = uint64_t{1} << 63;
+inline constexpr uint32_t kSignBit32 = uint32_t{1} << 31;
+
+/// String escape sequences; see the file comment.
+inline constexpr char kEscape = '\x00';
+inline constexpr char kEscapedZero = '\xff';
+inline constexpr char kTerminator = '\x01';
+
+}  // namespace internal
+
+inline void PutOrderedUint32(std::string* dst, uint32_t value) {
+  internal::PutBigEndian(dst, value, sizeof(value));
+}
+
+inline void PutOrderedUint64(std::string* dst, uint64_t value) {
+  internal::PutBigEndian(dst, value, sizeof(value));
+}
+
+inline void PutOrderedInt32(std::string* dst, int32_t value) {
+  PutOrderedUint32(dst, static_cast<uint32_t>(value) ^ internal::kSignBit32);
+}
+
+inline void PutOrderedInt64(std::string* dst, int64_t value) {
+  PutOrderedUint64(dst, static_cast<uint64_t>(value) ^ internal::kSignBit64);
+}
+
+inline void PutOrderedDouble(std::string* dst, double value) {
+  if (value == 0) value = 0.0;
+  if (std::isnan(value)) value = std::numeric_limits<double>::quiet_NaN();
+
+  const uint64_t bits = std::bit_cast<uint64_t>(value);
+  const bool negative = (bits & internal::kSignBit64) != 0;
+  PutOrderedUint64(dst, negative ? ~bits : bits ^ internal::kSignBit64);
+}
+
+inline void PutOrderedFloat(std::string* dst, float value) {
+  if (value == 0) value = 0.0f;
+  if (std::isnan(value)) value = std::numeric_limits<float>::quiet_NaN();
+
+  const uint32_t bits = std::bit_cast<uint32_t>(value);
+  const bool negative = (bits & internal::kSignBit32) != 0;
+  PutOrderedUint32(dst, negative ? ~bits : bits ^ internal::kSignBit32);
+}
+
+inline void PutOrderedString(std::string* dst, const Slice& value) {
+  const char* p = value.data();
+  const char* limit = p + value.size();
+
+  while (p < limit) {
+    const char* zero =
+        static_cast<const char*>(memchr(p, internal::kEscape, limit - p));
+
+    if (zero == nullptr) {
+      dst->append(p, limit - p);
+      break;
+    }
+
+    dst->append(p, zero - p);
+    dst->push_back(internal::kEscape);
+    dst->push_back(internal::kEscapedZero);
+    p = zero + 1;
+  }
+
+  dst->push_back(internal::kEscape);
+  dst->push_back(internal::kTerminator);
+}
+
+inline void PutOrderedTimestamp(std::string* dst,
+                                std::chrono::system_clock::time_point value) {
+  PutOrderedInt64(dst, std::chrono::duration_cast<std::chrono::nanoseconds>(
+                           value.time_since_epoch())
+                           .count());
+}
+
+inline bool GetOrderedUint32(Slice* input, uint32_t* value) {
+  uint64_t v;
+
+  if (!internal::GetBigEndian(input, &v, sizeof(*value))) return false;
+
+  *value = static_cast<uint32_t>(v);
+
+  return true;
+}
+
+inline bool GetOrderedUint64(Slice* input, uint64_t* value) {
+  return internal::GetBigEndian(input, value, sizeof(*value));
+}
+
+inline bool GetOrderedInt32(Slice* input, int32_t* value) {
+  uint32_t v;
+
+  if (!GetOrderedUint32(input, &v)) return false;
+
+  *value = static_cast<int32_t>(v ^ internal::kSignBit32);
+
+  return true;
+}
+
+inline bool GetOrderedInt64(Slice* input, int64_t* value) {
+  uint64_t v;
+
+  if (!GetOrderedUint64(input, &v)) return false;
+
+  *value = static_cast<int64_t>(v ^ internal::kSignBit64);
+
+  return true;
+}
+
+inline bool GetOrderedDouble(Slice* input, double* value) {
+  uint64_t v;
+
+  if (!GetOrderedUint64(input, &v)) return false;
+
+  *value = std::bit_cast<double>((v & internal::kSignBit64)
+                                     ? v ^ internal::kSignBit64
+                                     : ~v);
+
+  return true;
+}
+
+inline bool GetOrderedFloat(Slice* input, float* value) {
+  uint32_t v;
+
+  if (!GetOrderedUint32(input, &v)) return false;
+
+  *value = std::bit_cast<float>((v & internal::kSignBit32)
+                                    ? v ^ internal::kSignBit32
+                                    : ~v);
+
+  return true;
+}
+
+/// Decodes a string field into `value`, replacing its contents.
+bool GetOrderedString(Slice* input, std::string* value);
+
+/// Decodes a string field into `value`. When the string contains no 0x00
+/// bytes, `value` is pinned to the memory of `input` without copying, so that
+/// memory must outlive it; otherwise the string is unescaped into the buffer
+/// of `value`.
+///
+/// REQUIRES: `value` is not pinned.
+bool GetOrderedString(Slice* input, PinnableSlice* value);
+
+inline bool GetOrderedTimestamp(Slice* input,
+                                std::chrono::system_clock::time_point* value) {
+  int64_t nanos;
+
+  if (!GetOrderedInt64(input, &nanos)) return false;
+
+  *value = std::chrono::system_clock::time_point(
+      std::chrono::duration_cast<std::chrono::system_clock::duration>(
+          std::chrono::nanoseconds(nanos)));
+
+  return true;
+}
+
+}  // namespace badger
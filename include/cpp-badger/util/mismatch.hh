@@ -0,0 +1,100 @@
+// Kernels that locate the first differing byte of two buffers, the building
+// block of Slice::Compare() and Slice::DifferenceOffset().
+//
+// On x86-64 the fastest kernel supported by the CPU (AVX2 or SSE2) is picked
+// at runtime on first use; other targets use a portable word-at-a-time loop.
+
+#pragma once
+
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace badger {
+
+/// Each kernel returns the index of the first byte at which `a` and `b`
+/// differ, or `n` if the first `n` bytes are equal.
+using MismatchFunction = size_t (*)(const char* a, const char* b, size_t n);
+
+/// Compares 8 bytes at a time using plain integer loads.
+size_t FindFirstMismatchScalar(const char* a, const char* b, size_t n);
+
+// SSE2 is baseline on x86-64 only; 32-bit builds must enable it explicitly.
+#if defined(__GNUC__) && \
+    (defined(__x86_64__) || (defined(__i386__) && defined(__SSE2__)))
+#define BADGER_HAVE_X86_MISMATCH 1
+
+/// Compares 16 bytes at a time (pcmpeqb/pmovmskb).
+size_t FindFirstMismatchSSE2(const char* a, const char* b, size_t n);
+
+/// Compares 32 bytes at a time. REQUIRES: the CPU supports AVX2.
+size_t FindFirstMismatchAVX2(const char* a, const char* b, size_t n);
+#endif
+
+/// \return The name of the kernel selected for this CPU, e.g. "avx2".
+const char* MismatchKernelName();
+
+namespace internal {
+
+/// \return The index of the lowest-addressed nonzero byte of `x`, the XOR of
+///         two words loaded from memory.
+template <typename T>
+inline size_t FirstNonZeroByte(T x) {
+  if constexpr (std::endian::native == std::endian::little)
+    return std::countr_zero(x) / 8;
+  else
+    return std::countl_zero(x) / 8;
+}
+
+template <typename T>
+inline T Load(const char* p) {
+  T v;
+  memcpy(&v, p, sizeof(v));
+
+  return v;
+}
+
+/// Handles n < 16 with at most two overlapping word loads per buffer, which
+/// is cheaper than an indirect call for the short keys that dominate.
+inline size_t FindFirstMismatchShort(const char* a, const char* b, size_t n) {
+  if (n >= 8) {
+    uint64_t x = Load<uint64_t>(a) ^ Load<uint64_t>(b);
+    if (x != 0) return FirstNonZeroByte(x);
+
+    // Everything before n - 8 is known to be equal.
+    x = Load<uint64_t>(a + n - 8) ^ Load<uint64_t>(b + n - 8);
+    return x != 0 ? n - 8 + FirstNonZeroByte(x) : n;
+  }
+
+  if (n >= 4) {
+    uint32_t x = Load<uint32_t>(a) ^ Load<uint32_t>(b);
+    if (x != 0) return FirstNonZeroByte(x);
+
+    x = Load<uint32_t>(a + n - 4) ^ Load<uint32_t>(b + n - 4);
+    return x != 0 ? n - 4 + FirstNonZeroByte(x) : n;
+  }
+
+  for (size_t i = 0; i < n; ++i)
+    if (a[i] != b[i]) return i;
+
+  return n;
+}
+
+/// Points to a resolver until the first call, then to the selected kernel.
+/// Constant-initialized, so it is safe to use from static initializers.
+extern std::atomic<MismatchFunction> find_first_mismatch;
+
+}  // namespace internal
+
+/// \return The index of the first byte at which `a` and `b` differ, or `n` if
+///         the first `n` bytes are equal.
+inline size_t FindFirstMismatch(const char* a, const char* b, size_t n) {
+  if (n < 16) return internal::FindFirstMismatchShort(a, b, n);
+
+  return internal::find_first_mismatch.load(std::memory_order_relaxed)(a, b,
+                                                                         n);
+}
+
+}  // namespace badger
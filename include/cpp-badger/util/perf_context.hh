@@ -0,0 +1,133 @@
+// Per-thread counters and timers of what an operation did, to tell where a
+// slow operation spent its time:
+//
+//   SetPerfLevel(PerfLevel::kEnableTime);
+//   GetPerfContext()->Reset();
+//   mem.Get(key, seq, &value);
+//   fprintf(stderr, "%s\n", GetPerfContext()->ToString(true).c_str());
+//
+// Unlike Statistics, which aggregates over all threads, the context belongs
+// to the calling thread and counts only what that thread does.
+//
+// Instrumentation points use BADGER_PERF_COUNTER_ADD() and
+// BADGER_PERF_TIMER_GUARD(). With the default kDisable level each costs a
+// thread-local load and a predicted branch; built with BADGER_NPERF_CONTEXT
+// defined (the CMake option BADGER_PERF_CONTEXT=OFF) they compile to
+// nothing.
+//
+// Thread safety
+// -------------
+//
+// The level and the context are thread-local, so they need no
+// synchronization. Work that a thread hands to a ThreadPool is counted in the
+// worker's context, not the caller's.
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+namespace badger {
+
+enum class PerfLevel : uint8_t {
+  /// Nothing is recorded.
+  kDisable = 0,
+  /// Counters only.
+  kEnableCount = 1,
+  /// Counters and timers. A timer reads the clock twice, tens of
+  /// nanoseconds.
+  kEnableTime = 2,
+};
+
+struct PerfContext {
+  /// Keys compared by skiplists.
+  uint64_t user_key_comparison_count = 0;
+  /// Levels that skiplist searches descended through.
+  uint64_t skiplist_levels_traversed = 0;
+  /// Bytes requested from arenas.
+  uint64_t arena_bytes_allocated = 0;
+  /// Cleanups registered with Cleanable objects.
+  uint64_t cleanups_registered = 0;
+  /// Tasks handed to thread pools.
+  uint64_t threadpool_tasks_scheduled = 0;
+  /// Point lookups in memtables.
+  uint64_t get_from_memtable_count = 0;
+  /// Blocks read by table readers, and their bytes.
+  uint64_t block_read_count = 0;
+  uint64_t block_read_bytes = 0;
+
+  /// Timers, in nanoseconds; only with kEnableTime.
+  uint64_t skiplist_insert_nanos = 0;
+  uint64_t get_from_memtable_nanos = 0;
+  /// Time spent in ThreadPool::Schedule(), including waiting for its lock.
+  uint64_t threadpool_schedule_nanos = 0;
+  uint64_t block_read_nanos = 0;
+
+  /// Sets every counter and timer to zero.
+  void Reset() { *this = PerfContext(); }
+
+  /// \return "name = value" pairs separated by ", ".
+  std::string ToString(bool exclude_zero_counters = false) const;
+};
+
+/// The calling thread's level and context. Use the functions below; these
+/// are exposed for the macros.
+extern thread_local PerfLevel perf_level;
+extern thread_local PerfContext perf_context;
+
+/// Sets the calling thread's level.
+void SetPerfLevel(PerfLevel level);
+PerfLevel GetPerfLevel();
+
+/// \return The calling thread's context.
+PerfContext* GetPerfContext();
+
+/// Adds the nanoseconds between its construction and destruction to a
+/// timer, if the level at construction is kEnableTime.
+class PerfStepTimer {
+  PerfStepTimer(const PerfStepTimer&) = delete;
+  PerfStepTimer& operator=(const PerfStepTimer&) = delete;
+
+ public:
+  explicit PerfStepTimer(uint64_t* metric)
+      : metric_(perf_level >= PerfLevel::kEnableTime ? metric : nullptr) {
+    if (metric_ != nullptr) start_ = std::chrono::steady_clock::now();
+  }
+
+  ~PerfStepTimer() {
+    if (metric_ == nullptr) return;
+
+    *metric_ += static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start_)
+            .count());
+  }
+
+ private:
+  uint64_t* const metric_;
+  std::chrono::steady_clock::time_point start_;
+};
+
+}  // namespace badger
+
+#if defined(BADGER_NPERF_CONTEXT)
+
+#define BADGER_PERF_COUNTER_ADD(metric, value) static_cast<void>(0)
+#define BADGER_PERF_TIMER_GUARD(metric) static_cast<void>(0)
+
+#else
+
+/// Adds `value` to the counter `metric` of the calling thread's context.
+#define BADGER_PERF_COUNTER_ADD(metric, value)                       \
+  do {                                                               \
+    if (::badger::perf_level >= ::badger::PerfLevel::kEnableCount)   \
+      ::badger::perf_context.metric += static_cast<uint64_t>(value); \
+  } while (0)
+
+/// Times the rest of the enclosing scope into the timer `metric`.
+#define BADGER_PERF_TIMER_GUARD(metric)             \
+  ::badger::PerfStepTimer perf_step_timer_##metric( \
+      &::badger::perf_context.metric)
+
+#endif
@@ -26,6 +26,8 @@
 #include <string_view>
 
 #include "cpp-badger/util/cleanable.hh"
+#include "cpp-badger/util/hex.hh"
+#include "cpp-badger/util/mismatch.hh"
 
 namespace badger {
 
@@ -116,7 +118,7 @@ class Slice {
 
   /// Returns a string containing a copy of the referenced data.
   /// If `hex` is true, the string will be hex-encoded, doubling its length
-  /// (characters 0-9, A-F).
+  /// (characters 0-9, a-f).
   ///
   /// \param hex If true, output the data in hexadecimal representation;
   ///            otherwise, output raw data.
@@ -129,17 +131,36 @@ class Slice {
     return std::string_view(data_, size_);
   }
 
+  /// Writes the hex encoding of the referenced data, as produced by
+  /// ToString(true), to a caller-provided buffer.
+  ///
+  /// \param dst Buffer of at least 2 * size() bytes.
+  /// \return A pointer just past the last character written.
+  char* EncodeHex(char* dst) const {
+    HexEncode(data_, size_, dst);
+
+    return dst + 2 * size_;
+  }
+
   /// Decodes the current slice, interpreted as a hexadecimal string,
   /// into `result`. The slice is expected to contain an even number of
-  /// hexadecimal characters (0-9, A-F), and lowercase letters (a-f) are also
+  /// hexadecimal characters (0-9, a-f), and uppercase letters (A-F) are also
   /// accepted. If the slice is not a valid hex string (e.g., not produced by
   /// `Slice::ToString(true)`), decoding fails.
   ///
   /// \param result Reference to a std::string where the decoded bytes will be
-  ///               stored.
+  ///               stored. Cleared if decoding fails.
   /// \return true if decoding was successful; false otherwise.
   bool DecodeHex(std::string& result) const;
 
+  /// Same as DecodeHex(std::string&), but decodes into a caller-provided
+  /// buffer.
+  ///
+  /// \param dst Buffer of at least size() / 2 bytes. Its contents are
+  ///            unspecified if decoding fails.
+  /// \return true if decoding was successful; false otherwise.
+  bool DecodeHex(char* dst) const { return HexDecode(data_, size_, dst); }
+
   /// Performs a three-way comparison between this slice and another
   /// slice `b`. Returns a value indicating their relative order:
   ///   - <  0 if "*this" <  `b`
@@ -225,6 +246,10 @@ class OptSlice {
 /// used to avoid memcpy by having the PinnableSlice object referring to the
 /// data that is locked in the memory and release them after the data is
 /// consumed.
+///
+/// PinSelf(const Slice&) copies into a std::string, which allocates for values
+/// beyond the SSO limit. Subclasses such as InlinePinnableSlice can provide a
+/// scratch buffer and an allocator that are tried first.
 class PinnableSlice : public Slice, public Cleanable {
  public:
   PinnableSlice() { buf_ = &self_space_; }
@@ -257,17 +282,30 @@ class PinnableSlice : public Slice, public Cleanable {
     if (cleanable != nullptr) cleanable->DelegateCleanupsTo(this);
   }
 
+  /// Copies `slice` into memory owned by this object: the scratch buffer if
+  /// it fits, else memory from the scratch allocator, else the std::string
+  /// buffer.
   inline void PinSelf(const Slice& slice) {
     assert(!pinned_);
 
+    if (char* p = AcquireScratch(slice.size())) {
+      // `slice` may point into the current contents.
+      memmove(p, slice.data(), slice.size());
+      data_ = p;
+      size_ = slice.size();
+      return;
+    }
+
     buf_->assign(slice.data(), slice.size());
-    data_ = buf_->data();
-    size_ = buf_->size();
+    PinSelf();
   }
 
+  /// Points this slice at the std::string buffer, e.g. after filling it
+  /// through GetSelf().
   inline void PinSelf() {
     assert(!pinned_);
 
+    self_storage_ = SelfStorage::kString;
     data_ = buf_->data();
     size_ = buf_->size();
   }
@@ -275,7 +313,7 @@ class PinnableSlice : public Slice, public Cleanable {
   void RemoveSuffix(size_t n) {
     assert(n <= size());
 
-    if (pinned_)
+    if (pinned_ || self_storage_ != SelfStorage::kString)
       size_ -= n;
     else {
       buf_->erase(size() - n, n);
@@ -286,7 +324,7 @@ class PinnableSlice : public Slice, public Cleanable {
   void RemovePrefix(size_t n) {
     assert(n <= size());
 
-    if (pinned_) {
+    if (pinned_ || self_storage_ != SelfStorage::kString) {
       data_ += n;
       size_ -= n;
     } else {
@@ -305,15 +343,110 @@ class PinnableSlice : public Slice, public Cleanable {
 
   inline bool IsPinned() const { return pinned_; }
 
+ protected:
+  /// Returns memory for `size` bytes, or nullptr to decline.
+  using ScratchAllocator = char* (*)(void* arg, size_t size);
+
+  /// Makes PinSelf(const Slice&) copy values of up to `capacity` bytes into
+  /// `buf`, and larger values into memory from `allocator` (if not nullptr)
+  /// before falling back to the std::string buffer. Memory from `allocator`
+  /// is never freed by this object.
+  void SetScratch(char* buf, size_t capacity, ScratchAllocator allocator,
+                  void* allocator_arg) {
+    scratch_ = buf;
+    scratch_capacity_ = capacity;
+    allocator_ = allocator;
+    allocator_arg_ = allocator_arg;
+  }
+
  private:
+  /// Where the contents of an unpinned slice live.
+  enum class SelfStorage : uint8_t { kString, kScratch, kAllocated };
+
+  char* AcquireScratch(size_t size) {
+    if (scratch_ != nullptr && size <= scratch_capacity_) {
+      self_storage_ = SelfStorage::kScratch;
+      return scratch_;
+    }
+
+    if (allocator_ != nullptr) {
+      if (char* p = allocator_(allocator_arg_, size)) {
+        self_storage_ = SelfStorage::kAllocated;
+        return p;
+      }
+    }
+
+    return nullptr;
+  }
+
   std::string self_space_;
-  std::string* buf_;
+  std::string* buf_ = &self_space_;
   bool pinned_ = false;
+  SelfStorage self_storage_ = SelfStorage::kString;
+
+  char* scratch_ = nullptr;
+  size_t scratch_capacity_ = 0;
+  ScratchAllocator allocator_ = nullptr;
+  void* allocator_arg_ = nullptr;
 };
 
 /// A set of Slices that are virtually concatenated together.  'parts' points
 /// to an array of Slices.  The number of elements in the array is 'num_parts'.
+///
+/// Like Slice, SliceParts does not own the data. It can be compared, hashed
+/// (see hash.hh) and written (e.g. MemTable::Add()) without first being
+/// concatenated into a contiguous buffer; use CopyTo() or AppendTo() when
+/// that is really required.
 struct SliceParts {
+  SliceParts() = default;
+  SliceParts(const Slice* _parts, int _num_parts)
+      : parts(_parts), num_parts(_num_parts) {}
+
+  /// \return The total length of all the parts.
+  size_t size() const {
+    size_t n = 0;
+
+    for (int i = 0; i < num_parts; ++i) n += parts[i].size();
+
+    return n;
+  }
+
+  /// \return true iff the concatenation of the parts is empty.
+  bool IsEmpty() const { return size() == 0; }
+
+  /// Same as Slice::Compare(), with this being the concatenation of the
+  /// parts.
+  ///
+  /// \param b The slice to compare against.
+  /// \return Negative, zero, or positive as for Slice::Compare().
+  int Compare(const Slice& b) const;
+
+  /// Copies the concatenation of the parts to `dst`.
+  ///
+  /// \param dst Destination buffer of at least size() bytes.
+  /// \return A pointer just past the last byte written.
+  char* CopyTo(char* dst) const {
+    for (int i = 0; i < num_parts; ++i) {
+      if (parts[i].size() == 0) continue;
+
+      memcpy(dst, parts[i].data(), parts[i].size());
+      dst += parts[i].size();
+    }
+
+    return dst;
+  }
+
+  /// Appends the concatenation of the parts to `dst`.
+  void AppendTo(std::string* dst) const;
+
+  /// \return A string containing a copy of the concatenation of the parts.
+  std::string ToString() const {
+    std::string result;
+    AppendTo(&result);
+
+    return result;
+  }
+
   const Slice* parts = nullptr;
   int num_parts = 0;
 };
@@ -325,30 +458,35 @@ inline bool operator==(const Slice& x, const Slice& y) {
 
 inline bool operator!=(const Slice& x, const Slice& y) { return !(x == y); }
 
+inline bool operator==(const SliceParts& x, const Slice& y) {
+  return x.size() == y.size() && x.Compare(y) == 0;
+}
+
+inline bool operator!=(const SliceParts& x, const Slice& y) {
+  return !(x == y);
+}
+
 inline int Slice::Compare(const Slice& b) const {
   assert(data_ != nullptr && b.data_ != nullptr);
 
   const size_t min_len = (size_ < b.size_) ? size_ : b.size_;
-  int r = memcmp(data_, b.data_, min_len);
+  const size_t off = FindFirstMismatch(data_, b.data_, min_len);
 
-  if (r == 0) {
-    if (size_ < b.size_)
-      r = -1;
-    else if (size_ > b.size_)
-      r = +1;
-  }
+  if (off < min_len)
+    return static_cast<uint8_t>(data_[off]) < static_cast<uint8_t>(b.data_[off])
+               ? -1
+               : +1;
+
+  if (size_ < b.size_) return -1;
+  if (size_ > b.size_) return +1;
 
-  return r;
+  return 0;
 }
 
 inline size_t Slice::DifferenceOffset(const Slice& b) const {
-  size_t off = 0;
   const size_t len = (size_ < b.size_) ? size_ : b.size_;
 
-  for (; off < len; off++)
-    if (data_[off] != b.data_[off]) break;
-
-  return off;
+  return FindFirstMismatch(data_, b.data_, len);
 }
 
 }  // namespace badger
\ No newline at end of file
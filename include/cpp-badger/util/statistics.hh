@@ -0,0 +1,160 @@
+// A registry of tickers (event counters) and histograms (value
+// distributions, mostly latencies) that hot paths record into for a few
+// nanoseconds each.
+//
+// Components take an optional Statistics* and record through RecordTick(),
+// RecordInHistogram() and StopWatch, which do nothing when it is null, so
+// statistics cost one branch unless enabled. Each ticker and histogram is
+// sharded per core (see CoreLocalArray): recording is a relaxed atomic add
+// to a cache line that other cores rarely touch, and reading sums the
+// shards.
+//
+// Thread safety
+// -------------
+//
+// All methods are thread-safe. Snapshot() is not atomic with respect to
+// concurrent recording: it may include part of what is recorded while it
+// runs. Likewise Reset() may lose values recorded concurrently.
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+#include "cpp-badger/util/core_local.hh"
+#include "cpp-badger/util/histogram.hh"
+
+namespace badger {
+
+/// Event counters. Keep TickerName() in sync.
+enum Ticker : uint32_t {
+  kSkipListInserts = 0,
+  kArenaAllocations,
+  kArenaAllocatedBytes,
+  kArenaNewBlocks,
+  kThreadPoolTasksScheduled,
+  kThreadPoolTasksRun,
+  kTickerMax,
+};
+
+/// Value distributions. Keep HistogramName() in sync.
+enum HistogramType : uint32_t {
+  kSkipListInsertNanos = 0,
+  kArenaAllocationBytes,
+  /// Time tasks wait in the queue before a worker picks them up.
+  kThreadPoolQueueNanos,
+  kHistogramMax,
+};
+
+/// \return A dotted name such as "arena.allocations", for dumps.
+const char* TickerName(Ticker ticker);
+const char* HistogramName(HistogramType type);
+
+/// The value of every ticker and histogram at some point.
+struct StatisticsSnapshot {
+  std::array<uint64_t, kTickerMax> tickers{};
+  std::array<Histogram, kHistogramMax> histograms;
+
+  /// Adds the tickers and histograms of `other`, e.g. of another process or
+  /// registry.
+  void Merge(const StatisticsSnapshot& other);
+
+  /// \return One line per ticker and per non-empty histogram.
+  std::string ToString() const;
+
+  /// \return A JSON object with the tickers by name and, for each
+  ///         histogram, its count, sum, min, max, average and p50, p95, p99
+  ///         and p99.9.
+  std::string ToJson() const;
+};
+
+class Statistics {
+  Statistics(const Statistics&) = delete;
+  Statistics& operator=(const Statistics&) = delete;
+
+ public:
+  Statistics() = default;
+
+  void RecordTick(Ticker ticker, uint64_t count = 1) {
+    cores_.Access()->tickers[ticker].fetch_add(count,
+                                               std::memory_order_relaxed);
+  }
+
+  void RecordInHistogram(HistogramType type, uint64_t value);
+
+  uint64_t GetTickerCount(Ticker ticker) const;
+
+  /// \return The merged per-core histogram of `type`.
+  Histogram GetHistogram(HistogramType type) const;
+
+  StatisticsSnapshot Snapshot() const;
+
+  /// Sets every ticker and histogram back to zero.
+  void Reset();
+
+  std::string ToString() const { return Snapshot().ToString(); }
+  std::string ToJson() const { return Snapshot().ToJson(); }
+
+ private:
+  struct AtomicHistogram {
+    std::atomic<uint64_t> buckets[Histogram::kNumBuckets];
+    std::atomic<uint64_t> sum;
+    std::atomic<uint64_t> min{UINT64_MAX};
+    std::atomic<uint64_t> max;
+  };
+
+  struct alignas(64) CoreStats {
+    std::atomic<uint64_t> tickers[kTickerMax];
+    AtomicHistogram histograms[kHistogramMax];
+  };
+
+  /// Adds core `core`'s share of `type` to `*histogram`.
+  void MergeCore(size_t core, HistogramType type, Histogram* histogram) const;
+
+  CoreLocalArray<CoreStats> cores_;
+};
+
+/// Same as stats->RecordTick(), if `stats` is not null.
+inline void RecordTick(Statistics* stats, Ticker ticker, uint64_t count = 1) {
+  if (stats != nullptr) stats->RecordTick(ticker, count);
+}
+
+/// Same as stats->RecordInHistogram(), if `stats` is not null.
+inline void RecordInHistogram(Statistics* stats, HistogramType type,
+                              uint64_t value) {
+  if (stats != nullptr) stats->RecordInHistogram(type, value);
+}
+
+/// Records the nanoseconds between its construction and destruction in a
+/// histogram of `stats`. Reads no clock if `stats` is null.
+class StopWatch {
+  StopWatch(const StopWatch&) = delete;
+  StopWatch& operator=(const StopWatch&) = delete;
+
+ public:
+  StopWatch(Statistics* stats, HistogramType type)
+      : stats_(stats), type_(type) {
+    if (stats_ != nullptr) start_ = std::chrono::steady_clock::now();
+  }
+
+  ~StopWatch() {
+    if (stats_ == nullptr) return;
+
+    const auto elapsed = std::chrono::steady_clock::now() - start_;
+    stats_->RecordInHistogram(
+        type_, static_cast<uint64_t>(
+                   std::chrono::duration_cast<std::chrono::nanoseconds>(
+                       elapsed)
+                       .count()));
+  }
+
+ private:
+  Statistics* const stats_;
+  const HistogramType type_;
+  std::chrono::steady_clock::time_point start_;
+};
+
+}  // namespace badger
@@ -1,12 +1,17 @@
 #pragma once
 
+#include <chrono>
 #include <condition_variable>
 #include <deque>
 #include <functional>
 #include <mutex>
+#include <stdexcept>
 #include <thread>
 #include <vector>
 
+#include "cpp-badger/util/perf_context.hh"
+#include "cpp-badger/util/statistics.hh"
+
 namespace badger {
 
 class Executor {
@@ -26,7 +31,10 @@ class ThreadPool : public Executor {
  public:
   using Task = std::function<void()>;
 
-  explicit ThreadPool(int num_threads) {
+  /// \param stats If not null, records scheduled and finished tasks and how
+  ///              long tasks wait for a worker; must outlive the pool.
+  explicit ThreadPool(int num_threads, Statistics* stats = nullptr)
+      : stats_(stats) {
     if (num_threads <= 0)
       throw std::invalid_argument("num_threads must be > 0");
 
@@ -42,13 +50,20 @@ class ThreadPool : public Executor {
   ~ThreadPool() override { Shutdown(); }
 
   void Schedule(std::function<void()> fn) override {
+    BADGER_PERF_TIMER_GUARD(threadpool_schedule_nanos);
+    BADGER_PERF_COUNTER_ADD(threadpool_tasks_scheduled, 1);
+
     {
       std::unique_lock<std::mutex> lock(tasks_mtx_);
       if (shutdown_) throw std::runtime_error("ThreadPool has been shut down");
 
-      task_queue_.push_back(std::move(fn));
+      const Clock::time_point enqueued =
+          stats_ != nullptr ? Clock::now() : Clock::time_point();
+      task_queue_.push_back({std::move(fn), enqueued});
     }
 
+    RecordTick(stats_, kThreadPoolTasksScheduled);
+
     tasks_cv_.notify_one();
   }
 
@@ -65,9 +80,17 @@ class ThreadPool : public Executor {
   }
 
  private:
+  using Clock = std::chrono::steady_clock;
+
+  struct QueuedTask {
+    Task fn;
+    /// When Schedule() queued the task; only set with statistics.
+    Clock::time_point enqueued;
+  };
+
   void WorkerLoop() {
     while (true) {
-      std::function<void()> task;
+      QueuedTask task;
 
       {
         std::unique_lock<std::mutex> lock(tasks_mtx_);
@@ -80,7 +103,17 @@ class ThreadPool : public Executor {
         task_queue_.pop_front();
       }
 
-      task();
+      if (stats_ != nullptr) {
+        const auto waited = Clock::now() - task.enqueued;
+        stats_->RecordInHistogram(
+            kThreadPoolQueueNanos,
+            static_cast<uint64_t>(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(waited)
+                    .count()));
+      }
+
+      task.fn();
+      RecordTick(stats_, kThreadPoolTasksRun);
     }
   }
 
@@ -88,7 +121,8 @@ class ThreadPool : public Executor {
   std::mutex tasks_mtx_;
   std::condition_variable tasks_cv_;
   std::vector<std::thread> workers_;
-  std::deque<Task> task_queue_;
+  std::deque<QueuedTask> task_queue_;
+  Statistics* const stats_;
 };
 
 }  // namespace badger
\ No newline at end of file
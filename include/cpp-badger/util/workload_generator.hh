@@ -0,0 +1,211 @@
+// Key and value-size generators for benchmarks and stress tests, after the
+// request distributions of YCSB and db_bench.
+//
+// Every generator owns a RandomGenerator, so a generator built with the same
+// arguments and seed always produces the same sequence; give each thread its
+// own generator with a different seed. Keys are indexes in [0, num_keys),
+// which callers format as they like.
+//
+// All draws are O(1) and take a few to a few tens of nanoseconds, so that
+// they don't distort the memtable and arena benchmarks they drive.
+// ZipfianGenerator in particular needs no table of zeta values; it samples
+// by rejection-inversion (Hörmann and Derflinger, "Rejection-inversion to
+// generate variates from monotone discrete distributions", 1996), so its
+// setup is O(1) too and the number of keys may change between draws.
+
+#pragma once
+
+#include <cstdint>
+
+#include "cpp-badger/util/random.hh"
+
+namespace badger {
+
+/// A source of key indexes.
+class KeyGenerator {
+ public:
+  virtual ~KeyGenerator() = default;
+
+  /// \return A key index in [0, NumKeys()).
+  virtual uint64_t Next() = 0;
+
+  virtual uint64_t NumKeys() const = 0;
+};
+
+/// Every key equally likely.
+class UniformGenerator : public KeyGenerator {
+ public:
+  UniformGenerator(uint64_t num_keys, uint64_t seed)
+      : num_keys_(num_keys), rnd_(seed) {}
+
+  uint64_t Next() override { return rnd_.Uniform(num_keys_); }
+  uint64_t NumKeys() const override { return num_keys_; }
+
+ private:
+  uint64_t num_keys_;
+  RandomGenerator rnd_;
+};
+
+/// Key i has probability proportional to 1 / (i + 1)^theta, so key 0 is the
+/// most popular. YCSB uses theta = 0.99.
+class ZipfianGenerator : public KeyGenerator {
+ public:
+  static constexpr double kDefaultTheta = 0.99;
+
+  /// REQUIRES: num_keys > 0, theta > 0
+  ZipfianGenerator(uint64_t num_keys, double theta, uint64_t seed);
+
+  uint64_t Next() override;
+  uint64_t NumKeys() const override { return num_keys_; }
+
+  /// Changes the number of keys in O(1).
+  void SetNumKeys(uint64_t num_keys);
+
+  double Theta() const { return theta_; }
+
+ private:
+  /// The density the sampler inverts, x^-theta.
+  double H(double x) const;
+  /// Its integral, and the inverse of that.
+  double HIntegral(double x) const;
+  double HIntegralInverse(double x) const;
+
+  uint64_t num_keys_;
+  double theta_;
+  double h_integral_x1_;
+  double h_integral_num_keys_;
+  double s_;
+  RandomGenerator rnd_;
+};
+
+/// Zipfian popularity, but with the popular keys scattered over the key
+/// space instead of clustered at the start: the rank drawn from a
+/// ZipfianGenerator is hashed to a key. Like YCSB's, the mapping is not a
+/// permutation, so a few keys are never drawn.
+class ScrambledZipfianGenerator : public KeyGenerator {
+ public:
+  ScrambledZipfianGenerator(uint64_t num_keys, double theta, uint64_t seed)
+      : zipf_(num_keys, theta, seed) {}
+
+  uint64_t Next() override;
+  uint64_t NumKeys() const override { return zipf_.NumKeys(); }
+
+ private:
+  ZipfianGenerator zipf_;
+};
+
+/// Zipfian over recency: the most recently inserted key (the last index) is
+/// the most popular. Call SetNumKeys() as keys are inserted.
+class LatestGenerator : public KeyGenerator {
+ public:
+  LatestGenerator(uint64_t num_keys, double theta, uint64_t seed)
+      : zipf_(num_keys, theta, seed) {}
+
+  uint64_t Next() override { return zipf_.NumKeys() - 1 - zipf_.Next(); }
+  uint64_t NumKeys() const override { return zipf_.NumKeys(); }
+
+  void SetNumKeys(uint64_t num_keys) { zipf_.SetNumKeys(num_keys); }
+
+ private:
+  ZipfianGenerator zipf_;
+};
+
+/// A fraction `hot_op_fraction` of draws go uniformly to the first
+/// `hot_set_fraction` of the keys, the rest uniformly to the others.
+class HotspotGenerator : public KeyGenerator {
+ public:
+  /// REQUIRES: num_keys > 0, both fractions in [0, 1]
+  HotspotGenerator(uint64_t num_keys, double hot_set_fraction,
+                   double hot_op_fraction, uint64_t seed);
+
+  uint64_t Next() override;
+  uint64_t NumKeys() const override { return num_keys_; }
+
+ private:
+  uint64_t num_keys_;
+  uint64_t hot_keys_;
+  /// hot_op_fraction scaled to 2^64, compared against a raw draw.
+  uint64_t hot_op_threshold_;
+  RandomGenerator rnd_;
+};
+
+/// Exponentially decaying popularity from key 0, parameterized like YCSB:
+/// `percentile` percent of the draws fall in the first `range_fraction` of
+/// the keys.
+class ExponentialGenerator : public KeyGenerator {
+ public:
+  static constexpr double kDefaultPercentile = 95;
+  static constexpr double kDefaultRangeFraction = 0.8571428571;
+
+  /// REQUIRES: num_keys > 0, 0 < percentile < 100, range_fraction > 0
+  ExponentialGenerator(uint64_t num_keys, double percentile,
+                       double range_fraction, uint64_t seed);
+
+  uint64_t Next() override;
+  uint64_t NumKeys() const override { return num_keys_; }
+
+ private:
+  uint64_t num_keys_;
+  /// The mean draw is 1 / gamma_.
+  double gamma_;
+  RandomGenerator rnd_;
+};
+
+/// Value sizes, as db_bench's value_size_distribution_type and mixgraph's
+/// value size model.
+class ValueSizeGenerator {
+ public:
+  enum class Distribution {
+    kFixed,
+    kUniform,
+    kNormal,
+    /// Generalized Pareto: heavy tailed, as measured in production
+    /// key-value workloads (Cao et al., FAST '20).
+    kPareto,
+  };
+
+  /// Always `size`.
+  static ValueSizeGenerator Fixed(uint32_t size);
+
+  /// Uniform in [min, max].
+  static ValueSizeGenerator Uniform(uint32_t min, uint32_t max,
+                                    uint64_t seed);
+
+  /// Normal with the given mean and standard deviation, clamped to
+  /// [min, max].
+  static ValueSizeGenerator Normal(double mean, double stddev, uint32_t min,
+                                   uint32_t max, uint64_t seed);
+
+  /// Generalized Pareto with location `min`, scale `sigma` and shape `k`
+  /// (mixgraph's defaults are sigma = 226.409, k = 0.923), clamped to
+  /// `max`.
+  static ValueSizeGenerator Pareto(double sigma, double k, uint32_t min,
+                                   uint32_t max, uint64_t seed);
+
+  uint32_t Next();
+
+  Distribution GetDistribution() const { return distribution_; }
+
+ private:
+  ValueSizeGenerator(Distribution distribution, double a, double b,
+                     uint32_t min, uint32_t max, uint64_t seed)
+      : distribution_(distribution),
+        a_(a),
+        b_(b),
+        min_(min),
+        max_(max),
+        rnd_(seed) {}
+
+  uint32_t Clamp(double size) const;
+
+  Distribution distribution_;
+  /// Distribution parameters: mean and standard deviation for kNormal,
+  /// sigma and k for kPareto.
+  double a_;
+  double b_;
+  uint32_t min_;
+  uint32_t max_;
+  RandomGenerator rnd_;
+};
+
+}  // namespace badger
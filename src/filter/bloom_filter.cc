@@ -0,0 +1,297 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+
+#include "cpp-badger/filter/bloom_filter.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "cpp-badger/util/coding.hh"
+
+#ifdef BADGER_HAVE_X86_BLOOM
+#include <immintrin.h>
+#endif
+
+namespace badger {
+
+namespace {
+
+/// kProbeMultiplier to the power `k`; probe k of a key is its probe hash
+/// times this.
+constexpr uint32_t ProbeMultiplierPower(int k) {
+  uint32_t power = 1;
+  for (int i = 0; i < k; ++i) power *= BloomFilter::kProbeMultiplier;
+
+  return power;
+}
+
+/// Keys whose lines are prefetched together by the batched queries. Enough
+/// to cover the latency of a miss, but few enough that the lines are still
+/// in L1 when they are tested.
+constexpr size_t kProbeBatch = 32;
+
+BloomProbeFunction SelectProbeKernel() {
+#ifdef BADGER_HAVE_X86_BLOOM
+  if (__builtin_cpu_supports("avx2")) return BloomProbeAVX2;
+#endif
+
+  return BloomProbeScalar;
+}
+
+void ResolveAndProbe(const uint8_t* const* lines,
+                     const uint32_t* probe_hashes, size_t n, int num_probes,
+                     bool* out) {
+  BloomProbeFunction kernel = SelectProbeKernel();
+  internal::bloom_probe.store(kernel, std::memory_order_relaxed);
+
+  kernel(lines, probe_hashes, n, num_probes, out);
+}
+
+}  // namespace
+
+namespace internal {
+
+std::atomic<BloomProbeFunction> bloom_probe{ResolveAndProbe};
+
+}  // namespace internal
+
+void BloomProbeScalar(const uint8_t* const* lines,
+                      const uint32_t* probe_hashes, size_t n, int num_probes,
+                      bool* out) {
+  for (size_t i = 0; i < n; ++i) {
+    const uint8_t* line = lines[i];
+    uint32_t h = probe_hashes[i];
+    bool match = true;
+
+    for (int p = 0; p < num_probes && match; ++p) {
+      const uint32_t bit = BloomFilter::ProbeBit(h);
+      match = (line[bit >> 3] & (1u << (bit & 7))) != 0;
+      h *= BloomFilter::kProbeMultiplier;
+    }
+
+    out[i] = match;
+  }
+}
+
+#ifdef BADGER_HAVE_X86_BLOOM
+
+// On little-endian x86, bit i of the line is bit i % 32 of 32-bit word
+// i / 32, so a probe is a word lookup and a variable shift.
+__attribute__((target("avx2"))) void BloomProbeAVX2(
+    const uint8_t* const* lines, const uint32_t* probe_hashes, size_t n,
+    int num_probes, bool* out) {
+  const __m256i powers = _mm256_setr_epi32(
+      static_cast<int>(ProbeMultiplierPower(0)),
+      static_cast<int>(ProbeMultiplierPower(1)),
+      static_cast<int>(ProbeMultiplierPower(2)),
+      static_cast<int>(ProbeMultiplierPower(3)),
+      static_cast<int>(ProbeMultiplierPower(4)),
+      static_cast<int>(ProbeMultiplierPower(5)),
+      static_cast<int>(ProbeMultiplierPower(6)),
+      static_cast<int>(ProbeMultiplierPower(7)));
+  const __m256i next_eight =
+      _mm256_set1_epi32(static_cast<int>(ProbeMultiplierPower(8)));
+  const __m256i lane_index = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+  const __m256i one = _mm256_set1_epi32(1);
+  const __m256i low5 = _mm256_set1_epi32(31);
+
+  for (size_t i = 0; i < n; ++i) {
+    const auto* line = reinterpret_cast<const __m256i*>(lines[i]);
+    const __m256i lo = _mm256_loadu_si256(line);
+    const __m256i hi = _mm256_loadu_si256(line + 1);
+    // The probe hashes of probes 0-7, one per lane.
+    __m256i h = _mm256_mullo_epi32(
+        _mm256_set1_epi32(static_cast<int>(probe_hashes[i])), powers);
+    bool match = true;
+
+    for (int left = num_probes; left > 0 && match; left -= 8) {
+      // Bits 31-23 are the bit position: 31-28 the word, 27-23 the bit in
+      // it. Bit 31 picks the half of the line.
+      const __m256i word_index = _mm256_srli_epi32(h, 28);
+      const __m256i words =
+          _mm256_blendv_epi8(_mm256_permutevar8x32_epi32(lo, word_index),
+                             _mm256_permutevar8x32_epi32(hi, word_index),
+                             _mm256_srai_epi32(h, 31));
+      const __m256i bit = _mm256_sllv_epi32(
+          one, _mm256_and_si256(_mm256_srli_epi32(h, 23), low5));
+      const __m256i active =
+          _mm256_cmpgt_epi32(_mm256_set1_epi32(left), lane_index);
+
+      match = _mm256_testz_si256(_mm256_andnot_si256(words, bit), active);
+      h = _mm256_mullo_epi32(h, next_eight);
+    }
+
+    out[i] = match;
+  }
+}
+
+#endif  // BADGER_HAVE_X86_BLOOM
+
+const char* BloomProbeKernelName() {
+  BloomProbeFunction kernel = SelectProbeKernel();
+
+#ifdef BADGER_HAVE_X86_BLOOM
+  if (kernel == BloomProbeAVX2) return "avx2";
+#endif
+
+  return kernel == BloomProbeScalar ? "scalar" : "unknown";
+}
+
+int BloomFilter::ChooseNumProbes(int millibits_per_key) {
+  // Since the bits of a key all land in one line, lines that receive more
+  // keys than average fill up, and the best number of probes is lower than
+  // for a standard Bloom filter. Found by simulation (RocksDB).
+  if (millibits_per_key <= 2080) return 1;
+  if (millibits_per_key <= 3580) return 2;
+  if (millibits_per_key <= 5100) return 3;
+  if (millibits_per_key <= 6640) return 4;
+  if (millibits_per_key <= 8300) return 5;
+  if (millibits_per_key <= 10070) return 6;
+  if (millibits_per_key <= 11720) return 7;
+  if (millibits_per_key <= 14001) return 8;
+  if (millibits_per_key <= 16050) return 9;
+  if (millibits_per_key <= 18300) return 10;
+  if (millibits_per_key <= 22001) return 11;
+  if (millibits_per_key <= 25501) return 12;
+  if (millibits_per_key > 50000) return kMaxProbes;
+
+  return (millibits_per_key - 1) / 2000 - 1;
+}
+
+double BloomFilter::EstimatedFpRate(size_t num_keys, size_t num_lines,
+                                    int num_probes) {
+  if (num_lines == 0) return num_keys == 0 ? 0 : 1;
+
+  // The number of keys in the line a query lands in is Poisson distributed;
+  // sum the rate of a standard filter of one line over it.
+  const double keys_per_line = static_cast<double>(num_keys) / num_lines;
+  const double line_bits = kLineSize * 8;
+  const auto max_keys = static_cast<int>(
+      keys_per_line + 12 * std::sqrt(keys_per_line) + 12);
+  double p = std::exp(-keys_per_line);
+  double rate = 0;
+
+  for (int k = 0; k <= max_keys; ++k) {
+    const double bit_set = 1 - std::pow(1 - 1 / line_bits, num_probes * k);
+    rate += p * std::pow(bit_set, num_probes);
+    p *= keys_per_line / (k + 1);
+  }
+
+  return rate;
+}
+
+BloomFilterBuilder::BloomFilterBuilder(double bits_per_key)
+    : millibits_per_key_(
+          static_cast<int>(std::clamp(bits_per_key, 1.0, 100.0) * 1000 + 0.5)) {
+}
+
+size_t BloomFilterBuilder::NumLines() const {
+  const size_t line_millibits = BloomFilter::kLineSize * 8 * 1000;
+  const size_t millibits = hashes_.size() * millibits_per_key_;
+
+  return std::min<size_t>((millibits + line_millibits - 1) / line_millibits,
+                          std::numeric_limits<uint32_t>::max());
+}
+
+size_t BloomFilterBuilder::EstimatedSize() const {
+  return NumLines() * BloomFilter::kLineSize + BloomFilter::kTrailerSize;
+}
+
+void BloomFilterBuilder::Finish(std::string* out) {
+  // Hashes this far ahead have their lines prefetched, which pays off once
+  // the filter outgrows the cache.
+  constexpr size_t kPrefetchDistance = 8;
+
+  const auto num_lines = static_cast<uint32_t>(NumLines());
+  const int num_probes = BloomFilter::ChooseNumProbes(millibits_per_key_);
+  const size_t offset = out->size();
+  out->resize(offset + EstimatedSize());
+
+  auto* lines = reinterpret_cast<uint8_t*>(out->data() + offset);
+  auto line_of = [&](uint64_t hash) {
+    return lines + fast_range32(static_cast<uint32_t>(hash), num_lines) *
+                       BloomFilter::kLineSize;
+  };
+
+  for (size_t i = 0; i < hashes_.size(); ++i) {
+    if (i + kPrefetchDistance < hashes_.size())
+      __builtin_prefetch(line_of(hashes_[i + kPrefetchDistance]), 1);
+
+    uint8_t* line = line_of(hashes_[i]);
+    uint32_t h = static_cast<uint32_t>(hashes_[i] >> 32);
+    for (int p = 0; p < num_probes; ++p) {
+      const uint32_t bit = BloomFilter::ProbeBit(h);
+      line[bit >> 3] |= static_cast<uint8_t>(1u << (bit & 7));
+      h *= BloomFilter::kProbeMultiplier;
+    }
+  }
+
+  char* trailer = out->data() + out->size() - BloomFilter::kTrailerSize;
+  EncodeFixed32(trailer, num_lines);
+  trailer[4] = static_cast<char>(num_probes);
+  trailer[7] = static_cast<char>(kBloomFilterMarker);
+
+  hashes_.clear();
+}
+
+BloomFilterReader::BloomFilterReader(const Slice& contents) {
+  if (contents.size() < BloomFilter::kTrailerSize) return;
+
+  const char* trailer =
+      contents.data() + contents.size() - BloomFilter::kTrailerSize;
+  const uint32_t num_lines = DecodeFixed32(trailer);
+  const int num_probes = static_cast<uint8_t>(trailer[4]);
+
+  if (static_cast<uint8_t>(trailer[7]) != kBloomFilterMarker ||
+      num_probes < 1 || num_probes > BloomFilter::kMaxProbes ||
+      contents.size() - BloomFilter::kTrailerSize !=
+          uint64_t{num_lines} * BloomFilter::kLineSize) {
+    return;
+  }
+
+  lines_ = reinterpret_cast<const uint8_t*>(contents.data());
+  num_lines_ = num_lines;
+  num_probes_ = num_probes;
+  valid_ = true;
+}
+
+void BloomFilterReader::MayContain(const Slice* keys, size_t n,
+                                   bool* out) const {
+  uint64_t hashes[kProbeBatch];
+
+  for (size_t i = 0; i < n; i += kProbeBatch) {
+    const size_t batch = std::min(n - i, kProbeBatch);
+    HashBatch(keys + i, batch, hashes);
+    MayContainHashes(hashes, batch, out + i);
+  }
+}
+
+void BloomFilterReader::MayContainHashes(const uint64_t* hashes, size_t n,
+                                         bool* out) const {
+  if (num_lines_ == 0) {
+    std::fill_n(out, n, !valid_);
+    return;
+  }
+
+  const BloomProbeFunction probe =
+      internal::bloom_probe.load(std::memory_order_relaxed);
+  const uint8_t* lines[kProbeBatch];
+  uint32_t probe_hashes[kProbeBatch];
+
+  for (size_t i = 0; i < n; i += kProbeBatch) {
+    const size_t batch = std::min(n - i, kProbeBatch);
+
+    for (size_t j = 0; j < batch; ++j) {
+      lines[j] = Line(hashes[i + j]);
+      __builtin_prefetch(lines[j]);
+      probe_hashes[j] = static_cast<uint32_t>(hashes[i + j] >> 32);
+    }
+
+    probe(lines, probe_hashes, batch, num_probes_, out + i);
+  }
+}
+
+}  // namespace badger
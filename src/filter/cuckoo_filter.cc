@@ -0,0 +1,107 @@
+#include "cpp-badger/filter/cuckoo_filter.hh"
+
+#include <algorithm>
+#include <utility>
+
+namespace badger {
+
+CuckooFilter::CuckooFilter(Arena* arena, size_t capacity) : rnd_(301) {
+  const auto slots =
+      static_cast<size_t>(static_cast<double>(capacity) / kMaxLoadFactor);
+  num_buckets_ =
+      std::max<size_t>((slots + kSlotsPerBucket - 1) / kSlotsPerBucket, 1);
+
+  // Cache-line aligned, so that no bucket straddles two lines.
+  buckets_ = static_cast<uint64_t*>(
+      arena->Allocate(num_buckets_ * sizeof(uint64_t), 64));
+  std::fill_n(buckets_, num_buckets_, 0);
+}
+
+bool CuckooFilter::TryPut(size_t i, uint16_t fp) {
+  for (int s = 0; s < kSlotsPerBucket; ++s) {
+    if (GetSlot(buckets_[i], s) == 0) {
+      SetSlot(&buckets_[i], s, fp);
+      return true;
+    }
+  }
+
+  return false;
+}
+
+bool CuckooFilter::TryRemove(size_t i, uint16_t fp) {
+  for (int s = 0; s < kSlotsPerBucket; ++s) {
+    if (GetSlot(buckets_[i], s) == fp) {
+      SetSlot(&buckets_[i], s, 0);
+      return true;
+    }
+  }
+
+  return false;
+}
+
+bool CuckooFilter::Place(size_t i, uint16_t fp) {
+  if (TryPut(i, fp) || TryPut(AltBucket(i, fp), fp)) return true;
+
+  // Both buckets are full: evict an entry and move it to its other bucket,
+  // and so on, until an entry lands in a free slot. An entry that can move
+  // straight to a free slot is preferred, which keeps the walks short even
+  // near full occupancy; otherwise the victim is random.
+  i = rnd_.OneIn(2) ? i : AltBucket(i, fp);
+  for (int kick = 0; kick < kMaxKicks; ++kick) {
+    for (int s = 0; s < kSlotsPerBucket; ++s) {
+      const uint16_t other = GetSlot(buckets_[i], s);
+      if (TryPut(AltBucket(i, other), other)) {
+        SetSlot(&buckets_[i], s, fp);
+        return true;
+      }
+    }
+
+    const int s = static_cast<int>(rnd_.Uniform(kSlotsPerBucket));
+    const uint16_t evicted = GetSlot(buckets_[i], s);
+    SetSlot(&buckets_[i], s, fp);
+    fp = evicted;
+    i = AltBucket(i, fp);
+
+    if (TryPut(i, fp)) return true;
+  }
+
+  // Keep the last evicted entry aside, so that no key goes missing.
+  victim_fp_ = fp;
+  victim_bucket_ = i;
+
+  return false;
+}
+
+bool CuckooFilter::AddKeyHash(uint64_t hash) {
+  // Deletes may have made room for the victim by now.
+  if (victim_fp_ != 0) {
+    const uint16_t victim = victim_fp_;
+    victim_fp_ = 0;
+    if (!Place(victim_bucket_, victim)) return false;
+  }
+
+  ++size_;
+
+  return Place(fast_range64(hash, num_buckets_), Fingerprint(hash));
+}
+
+bool CuckooFilter::DeleteKeyHash(uint64_t hash) {
+  const uint16_t fp = Fingerprint(hash);
+  const size_t i1 = fast_range64(hash, num_buckets_);
+  const size_t i2 = AltBucket(i1, fp);
+
+  if (TryRemove(i1, fp) || TryRemove(i2, fp)) {
+    --size_;
+    return true;
+  }
+
+  if (victim_fp_ == fp && (victim_bucket_ == i1 || victim_bucket_ == i2)) {
+    victim_fp_ = 0;
+    --size_;
+    return true;
+  }
+
+  return false;
+}
+
+}  // namespace badger
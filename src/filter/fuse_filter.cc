@@ -0,0 +1,357 @@
+#include "cpp-badger/filter/fuse_filter.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <exception>
+#include <latch>
+#include <stdexcept>
+
+namespace badger {
+
+FuseFilter::Geometry::Geometry(size_t num_keys) {
+  if (num_keys == 0) return;
+
+  // From the reference implementation: longer segments for more keys, and
+  // a little more space for small key sets, which peel less reliably.
+  const double n = static_cast<double>(num_keys);
+  const int length_bits =
+      static_cast<int>(std::floor(std::log(n) / std::log(3.33) + 2.25));
+  segment_length = std::min(uint32_t{1} << length_bits, kMaxSegmentLength);
+
+  const double size_factor =
+      num_keys <= 1
+          ? 0
+          : std::max(1.125, 0.875 + 0.25 * std::log(1000000.0) / std::log(n));
+  const auto capacity = static_cast<size_t>(std::round(n * size_factor));
+  const size_t min_segments = (capacity + segment_length - 1) / segment_length;
+  segment_count = static_cast<uint32_t>(std::max<size_t>(min_segments, 3) - 2);
+}
+
+namespace {
+
+uint64_t SplitMix64(uint64_t* state) {
+  uint64_t z = (*state += 0x9e3779b97f4a7c15ULL);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+
+  return z ^ (z >> 31);
+}
+
+// The number of seeds a shard tries before giving up. With distinct keys a
+// seed fails with a probability well under 1%.
+constexpr int kMaxAttempts = 100;
+
+// Fills `cells` for the `n` key hashes at `keys`, which must all belong to
+// one shard, and returns the seed that worked. Follows the reference
+// binary_fuse8_populate(). Sorts and deduplicates `keys` if repeated hashes
+// get in the way.
+uint64_t BuildShard(uint64_t* keys, size_t n,
+                    const FuseFilter::Geometry& geometry, uint64_t seed_state,
+                    uint8_t* cells) {
+  const size_t num_cells = geometry.NumCells();
+  std::fill_n(cells, num_cells, 0);
+  if (n == 0) return 0;
+
+  // Mixed hashes in an order that visits the cells roughly sequentially, and
+  // then in peeling order; 0 marks an empty slot.
+  std::vector<uint64_t> order(n + 1);
+  // Which of its three cells each peeled key was peeled from.
+  std::vector<uint8_t> peeled_from(n);
+  // Per cell: 4 * the number of keys that map to it, XORed with the index
+  // (0, 1, 2) of the cell within each key's triple.
+  std::vector<uint8_t> count(num_cells);
+  // Per cell: the XOR of the hashes of the keys that map to it.
+  std::vector<uint64_t> xor_hash(num_cells);
+  std::vector<uint32_t> queue(num_cells);
+
+  int block_bits = 1;
+  while ((size_t{1} << block_bits) < geometry.segment_count) ++block_bits;
+  const size_t num_blocks = size_t{1} << block_bits;
+  std::vector<size_t> start_pos(num_blocks);
+  bool deduplicated = false;
+
+  for (int attempt = 0; attempt < kMaxAttempts; ++attempt) {
+    const uint64_t seed = SplitMix64(&seed_state);
+
+    std::fill_n(order.begin(), n, 0);
+    order[n] = 1;  // Sentinel
+    std::fill(count.begin(), count.end(), 0);
+    std::fill(xor_hash.begin(), xor_hash.end(), 0);
+
+    for (size_t b = 0; b < num_blocks; ++b)
+      start_pos[b] = (b * n) >> block_bits;
+
+    for (size_t i = 0; i < n; ++i) {
+      const uint64_t h = FuseFilter::Mix(keys[i], seed);
+      size_t block = h >> (64 - block_bits);
+      while (order[start_pos[block]] != 0)
+        block = (block + 1) & (num_blocks - 1);
+      order[start_pos[block]++] = h;
+    }
+
+    size_t duplicates = 0;
+    bool error = false;
+    for (size_t i = 0; i < n; ++i) {
+      const uint64_t h = order[i];
+      const FuseFilter::Cells c = FuseFilter::GetCells(
+          h, geometry.segment_length, geometry.segment_count);
+
+      count[c.h0] += 4;
+      xor_hash[c.h0] ^= h;
+      count[c.h1] = static_cast<uint8_t>((count[c.h1] + 4) ^ 1);
+      xor_hash[c.h1] ^= h;
+      count[c.h2] = static_cast<uint8_t>((count[c.h2] + 4) ^ 2);
+      xor_hash[c.h2] ^= h;
+
+      // A repeated hash cancels out of xor_hash and leaves a count of two
+      // keys; take it out again.
+      if ((xor_hash[c.h0] & xor_hash[c.h1] & xor_hash[c.h2]) == 0 &&
+          ((xor_hash[c.h0] == 0 && count[c.h0] == 8) ||
+           (xor_hash[c.h1] == 0 && count[c.h1] == 8) ||
+           (xor_hash[c.h2] == 0 && count[c.h2] == 8))) {
+        ++duplicates;
+        count[c.h0] -= 4;
+        xor_hash[c.h0] ^= h;
+        count[c.h1] = static_cast<uint8_t>((count[c.h1] - 4) ^ 1);
+        xor_hash[c.h1] ^= h;
+        count[c.h2] = static_cast<uint8_t>((count[c.h2] - 4) ^ 2);
+        xor_hash[c.h2] ^= h;
+      }
+
+      // More than 63 keys in one cell overflow the count.
+      error |= count[c.h0] < 4 || count[c.h1] < 4 || count[c.h2] < 4;
+    }
+    if (error) continue;
+
+    // Peel: repeatedly take a cell that only one key maps to, and remove
+    // that key from its other two cells.
+    size_t queue_size = 0;
+    for (uint32_t i = 0; i < num_cells; ++i) {
+      queue[queue_size] = i;
+      queue_size += (count[i] >> 2) == 1;
+    }
+
+    size_t num_peeled = 0;
+    while (queue_size > 0) {
+      const uint32_t index = queue[--queue_size];
+      if ((count[index] >> 2) != 1) continue;
+
+      const uint64_t h = xor_hash[index];
+      const FuseFilter::Cells c = FuseFilter::GetCells(
+          h, geometry.segment_length, geometry.segment_count);
+      const uint32_t triple[5] = {c.h0, c.h1, c.h2, c.h0, c.h1};
+      const uint8_t found = count[index] & 3;
+      peeled_from[num_peeled] = found;
+      order[num_peeled++] = h;
+
+      for (int k = 1; k <= 2; ++k) {
+        const uint32_t other = triple[found + k];
+        queue[queue_size] = other;
+        queue_size += (count[other] >> 2) == 2;
+        count[other] =
+            static_cast<uint8_t>((count[other] - 4) ^ ((found + k) % 3));
+        xor_hash[other] ^= h;
+      }
+    }
+
+    if (num_peeled + duplicates == n) {
+      // Assign in reverse peeling order, so that each key's cell is set
+      // after the cells it depends on.
+      for (size_t i = num_peeled; i-- > 0;) {
+        const uint64_t h = order[i];
+        const FuseFilter::Cells c = FuseFilter::GetCells(
+            h, geometry.segment_length, geometry.segment_count);
+        const uint32_t triple[5] = {c.h0, c.h1, c.h2, c.h0, c.h1};
+        const uint8_t found = peeled_from[i];
+        cells[triple[found]] = FuseFilter::Fingerprint(h) ^
+                               cells[triple[found + 1]] ^
+                               cells[triple[found + 2]];
+      }
+
+      return seed;
+    }
+
+    // Repeated hashes that were not caught above can never be peeled, so
+    // get rid of them before trying the next seed.
+    if (!deduplicated) {
+      std::sort(keys, keys + n);
+      n = std::unique(keys, keys + n) - keys;
+      deduplicated = true;
+    }
+  }
+
+  throw std::runtime_error("fuse filter construction failed");
+}
+
+size_t NumShardsFor(size_t num_keys) {
+  return (num_keys + FuseFilter::kMaxShardKeys - 1) / FuseFilter::kMaxShardKeys;
+}
+
+size_t SerializedSize(size_t num_shards, const FuseFilter::Geometry& geometry) {
+  return num_shards * (geometry.NumCells() + sizeof(uint64_t)) +
+         FuseFilter::kTrailerSize;
+}
+
+// Keys whose cells are prefetched together by the batched queries.
+constexpr size_t kProbeBatch = 32;
+
+}  // namespace
+
+std::vector<size_t> FuseFilterBuilder::ShardSizes(size_t num_shards) const {
+  std::vector<size_t> sizes(num_shards);
+  for (uint64_t h : hashes_) ++sizes[fast_range64(h, num_shards)];
+
+  return sizes;
+}
+
+size_t FuseFilterBuilder::EstimatedSize() const {
+  const size_t num_shards = NumShardsFor(hashes_.size());
+  const std::vector<size_t> sizes = ShardSizes(num_shards);
+  const size_t max_size =
+      sizes.empty() ? 0 : *std::max_element(sizes.begin(), sizes.end());
+
+  return SerializedSize(num_shards, FuseFilter::Geometry(max_size));
+}
+
+void FuseFilterBuilder::Finish(std::string* out, Executor* executor) {
+  const size_t num_shards = NumShardsFor(hashes_.size());
+  const std::vector<size_t> sizes = ShardSizes(num_shards);
+  const size_t max_size =
+      sizes.empty() ? 0 : *std::max_element(sizes.begin(), sizes.end());
+  const FuseFilter::Geometry geometry(max_size);
+
+  // Group the hashes by shard.
+  std::vector<size_t> begin(num_shards + 1);
+  for (size_t s = 0; s < num_shards; ++s) begin[s + 1] = begin[s] + sizes[s];
+  std::vector<uint64_t> grouped(hashes_.size());
+  {
+    std::vector<size_t> pos(begin.begin(), begin.end() - 1);
+    for (uint64_t h : hashes_) grouped[pos[fast_range64(h, num_shards)]++] = h;
+  }
+  hashes_.clear();
+  hashes_.shrink_to_fit();
+
+  const size_t offset = out->size();
+  out->resize(offset + SerializedSize(num_shards, geometry));
+  auto* cells = reinterpret_cast<uint8_t*>(out->data() + offset);
+  char* seeds = out->data() + offset + num_shards * geometry.NumCells();
+
+  std::vector<std::exception_ptr> errors(num_shards);
+  auto build = [&](size_t s) {
+    try {
+      const uint64_t seed =
+          BuildShard(grouped.data() + begin[s], sizes[s], geometry,
+                     0x726b2b9d438b9d4dULL ^ s,
+                     cells + s * geometry.NumCells());
+      EncodeFixed64(seeds + 8 * s, seed);
+    } catch (...) {
+      errors[s] = std::current_exception();
+    }
+  };
+
+  if (executor == nullptr || num_shards <= 1) {
+    for (size_t s = 0; s < num_shards; ++s) build(s);
+  } else {
+    std::latch done(static_cast<std::ptrdiff_t>(num_shards));
+    for (size_t s = 0; s < num_shards; ++s) {
+      executor->Schedule([&build, &done, s] {
+        build(s);
+        done.count_down();
+      });
+    }
+    done.wait();
+  }
+
+  for (const auto& error : errors)
+    if (error) std::rethrow_exception(error);
+
+  char* trailer = out->data() + out->size() - FuseFilter::kTrailerSize;
+  EncodeFixed32(trailer, static_cast<uint32_t>(num_shards));
+  EncodeFixed32(trailer + 4, geometry.segment_length);
+  EncodeFixed32(trailer + 8, geometry.segment_count);
+  trailer[15] = static_cast<char>(kFuseFilterMarker);
+}
+
+FuseFilterReader::FuseFilterReader(const Slice& contents) {
+  if (contents.size() < FuseFilter::kTrailerSize) return;
+
+  const char* trailer =
+      contents.data() + contents.size() - FuseFilter::kTrailerSize;
+  const uint32_t num_shards = DecodeFixed32(trailer);
+  const FuseFilter::Geometry geometry(DecodeFixed32(trailer + 4),
+                                      DecodeFixed32(trailer + 8));
+  const uint32_t length = geometry.segment_length;
+
+  if (static_cast<uint8_t>(trailer[15]) != kFuseFilterMarker ||
+      length == 0 || (length & (length - 1)) != 0 ||
+      length > FuseFilter::kMaxSegmentLength ||
+      geometry.segment_count == 0 ||
+      geometry.segment_count > contents.size() ||
+      (num_shards > 0 &&
+       geometry.NumCells() > contents.size() / num_shards) ||
+      contents.size() != SerializedSize(num_shards, geometry)) {
+    return;
+  }
+
+  cells_ = reinterpret_cast<const uint8_t*>(contents.data());
+  seeds_ = contents.data() + num_shards * geometry.NumCells();
+  cells_per_shard_ = geometry.NumCells();
+  num_shards_ = num_shards;
+  segment_length_ = geometry.segment_length;
+  segment_count_ = geometry.segment_count;
+  valid_ = true;
+}
+
+void FuseFilterReader::MayContain(const Slice* keys, size_t n,
+                                  bool* out) const {
+  uint64_t hashes[kProbeBatch];
+
+  for (size_t i = 0; i < n; i += kProbeBatch) {
+    const size_t batch = std::min(n - i, kProbeBatch);
+    HashBatch(keys + i, batch, hashes);
+    MayContainHashes(hashes, batch, out + i);
+  }
+}
+
+void FuseFilterReader::MayContainHashes(const uint64_t* hashes, size_t n,
+                                        bool* out) const {
+  if (num_shards_ == 0) {
+    std::fill_n(out, n, !valid_);
+    return;
+  }
+
+  // The three cells of a key are in different segments and usually in
+  // different cache lines; fetch all of them for the batch first.
+  const uint8_t* shard_cells[kProbeBatch];
+  FuseFilter::Cells cells[kProbeBatch];
+  uint8_t fingerprints[kProbeBatch];
+
+  for (size_t i = 0; i < n; i += kProbeBatch) {
+    const size_t batch = std::min(n - i, kProbeBatch);
+
+    for (size_t j = 0; j < batch; ++j) {
+      const size_t shard = fast_range64(hashes[i + j], num_shards_);
+      const uint64_t h =
+          FuseFilter::Mix(hashes[i + j], DecodeFixed64(seeds_ + 8 * shard));
+      const FuseFilter::Cells c =
+          FuseFilter::GetCells(h, segment_length_, segment_count_);
+      const uint8_t* base = cells_ + shard * cells_per_shard_;
+
+      __builtin_prefetch(base + c.h0);
+      __builtin_prefetch(base + c.h1);
+      __builtin_prefetch(base + c.h2);
+      shard_cells[j] = base;
+      cells[j] = c;
+      fingerprints[j] = FuseFilter::Fingerprint(h);
+    }
+
+    for (size_t j = 0; j < batch; ++j) {
+      const uint8_t* base = shard_cells[j];
+      const FuseFilter::Cells& c = cells[j];
+      out[i + j] = (fingerprints[j] ^ base[c.h0] ^ base[c.h1] ^
+                    base[c.h2]) == 0;
+    }
+  }
+}
+
+}  // namespace badger
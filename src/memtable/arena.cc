@@ -17,6 +17,26 @@ void Arena::Dump(std::ostream& os) {
   }
 }
 
+size_t Arena::MemoryAllocatedBytes() const {
+  size_t total = 0;
+
+  for (const auto& block : blocks_)
+    total += static_cast<char*>(block.BlockEnd()) -
+             static_cast<char*>(block.BlockStart());
+
+  return total;
+}
+
+size_t Arena::ApproximateMemoryUsage() const {
+  size_t used = 0;
+
+  for (const auto& block : blocks_)
+    used += static_cast<char*>(block.CurrentPtr()) -
+            static_cast<char*>(block.BlockStart());
+
+  return used;
+}
+
 void Arena::CreateNewBlock(size_t size) {
   void* p = mi_malloc(size);
 
@@ -24,6 +44,7 @@ void Arena::CreateNewBlock(size_t size) {
 
   size_t capacity = mi_usable_size(p);
   blocks_.emplace(p, capacity);
+  RecordTick(stats_, kArenaNewBlocks);
 }
 
 void Arena::CreateNewBlock(size_t size, size_t alignment) {
@@ -33,6 +54,7 @@ void Arena::CreateNewBlock(size_t size, size_t alignment) {
 
   size_t capacity = mi_usable_size(p);
   blocks_.emplace(p, capacity);
+  RecordTick(stats_, kArenaNewBlocks);
 }
 
 }  // namespace badger
\ No newline at end of file
@@ -0,0 +1,286 @@
+#include "cpp-badger/memtable/compact_memtable.hh"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#include "cpp-badger/util/coding.hh"
+
+namespace badger {
+
+namespace {
+
+/// A decoded view of an entry stored in a MemTable skiplist.
+struct SkipListEntry {
+  Slice user_key;
+  uint64_t tag;
+  Slice value;
+};
+
+SkipListEntry DecodeSkipListEntry(const char* entry) {
+  Slice internal_key = GetLengthPrefixedSlice(entry);
+
+  assert(internal_key.size() >= 8);
+
+  const size_t user_key_size = internal_key.size() - 8;
+
+  return SkipListEntry{
+      Slice(internal_key.data(), user_key_size),
+      DecodeFixed64(internal_key.data() + user_key_size),
+      GetLengthPrefixedSlice(internal_key.data() + internal_key.size())};
+}
+
+size_t PackedSize(const SkipListEntry& e) {
+  return VarintLength(e.user_key.size()) + e.user_key.size() + 8 +
+         e.value.size();
+}
+
+}  // namespace
+
+CompactMemTable::CompactMemTable(const MemTable& mem)
+    : merge_operator_(mem.options().merge_operator) {
+  MemTable::Table::Iterator iter(&mem.table_);
+  size_t num_entries = 0;
+  size_t data_size = 0;
+
+  for (iter.SeekToFirst(); iter.Valid(); iter.Next()) {
+    data_size += PackedSize(DecodeSkipListEntry(iter.key()));
+    ++num_entries;
+  }
+
+  if (data_size > UINT32_MAX)
+    throw std::length_error("memtable too large to compact");
+
+  data_ = std::make_unique_for_overwrite<char[]>(data_size);
+  offsets_.reserve(num_entries + 1);
+  index_.reserve((num_entries + kIndexInterval - 1) / kIndexInterval);
+
+  char* p = data_.get();
+
+  for (iter.SeekToFirst(); iter.Valid(); iter.Next()) {
+    SkipListEntry e = DecodeSkipListEntry(iter.key());
+
+    if (offsets_.size() % kIndexInterval == 0)
+      index_.push_back(KeyPrefix(e.user_key));
+
+    offsets_.push_back(static_cast<uint32_t>(p - data_.get()));
+    p = EncodeVarint32(p, static_cast<uint32_t>(e.user_key.size()));
+    memcpy(p, e.user_key.data(), e.user_key.size());
+    p += e.user_key.size();
+    EncodeFixed64(p, e.tag);
+    p += 8;
+    memcpy(p, e.value.data(), e.value.size());
+    p += e.value.size();
+  }
+
+  offsets_.push_back(static_cast<uint32_t>(p - data_.get()));
+
+  assert(offsets_.back() == data_size);
+
+  // Copy the tombstone keys first and take slices in a second pass, once
+  // tombstone_data_ no longer reallocates.
+  MemTable::Table::Iterator range_iter(&mem.range_del_table_);
+
+  for (range_iter.SeekToFirst(); range_iter.Valid(); range_iter.Next()) {
+    SkipListEntry e = DecodeSkipListEntry(range_iter.key());
+    tombstone_data_.append(e.user_key.data(), e.user_key.size());
+    tombstone_data_.append(e.value.data(), e.value.size());
+  }
+
+  std::vector<RangeTombstone> tombstones;
+  const char* q = tombstone_data_.data();
+
+  for (range_iter.SeekToFirst(); range_iter.Valid(); range_iter.Next()) {
+    SkipListEntry e = DecodeSkipListEntry(range_iter.key());
+    SequenceNumber seq;
+    ValueType type;
+    UnPackSequenceAndType(e.tag, &seq, &type);
+
+    const Slice start(q, e.user_key.size());
+    q += e.user_key.size();
+    const Slice end(q, e.value.size());
+    q += e.value.size();
+    tombstones.emplace_back(start, end, seq);
+  }
+
+  range_tombstones_ = std::make_shared<const FragmentedRangeTombstoneList>(
+      std::move(tombstones));
+}
+
+void CompactMemTable::ScheduleConversion(Executor* executor,
+                                         std::shared_ptr<const MemTable> mem,
+                                         ConvertCallback done) {
+  executor->Schedule([mem = std::move(mem), done = std::move(done)]() mutable {
+    std::shared_ptr<const CompactMemTable> result;
+
+    try {
+      result = std::make_shared<const CompactMemTable>(*mem);
+    } catch (const std::exception&) {
+      // Keep serving reads from the skiplist.
+    }
+
+    mem.reset();
+    done(std::move(result));
+  });
+}
+
+uint64_t CompactMemTable::KeyPrefix(const Slice& key) {
+  uint64_t prefix = 0;
+  const size_t n = std::min<size_t>(key.size(), 8);
+
+  for (size_t i = 0; i < n; ++i)
+    prefix |= static_cast<uint64_t>(static_cast<uint8_t>(key[i]))
+              << (56 - 8 * i);
+
+  return prefix;
+}
+
+CompactMemTable::Entry CompactMemTable::GetEntry(size_t i) const {
+  assert(i < NumEntries());
+
+  const char* p = data_.get() + offsets_[i];
+  const char* limit = data_.get() + offsets_[i + 1];
+  uint32_t user_key_size = 0;
+  p = GetVarint32Ptr(p, limit, &user_key_size);
+
+  if (p == nullptr || static_cast<size_t>(limit - p) < user_key_size + 8ull)
+    throw std::runtime_error("CompactMemTable: corrupt entry");
+
+  Entry e;
+  e.user_key = Slice(p, user_key_size);
+  p += user_key_size;
+  e.tag = DecodeFixed64(p);
+  p += 8;
+  e.value = Slice(p, limit - p);
+
+  return e;
+}
+
+size_t CompactMemTable::LowerBound(const Slice& user_key,
+                                   SequenceNumber seq) const {
+  // Prefixes never decrease along the array. The sample before the first one
+  // >= prefix sorts before the target, and the first sample > prefix sorts
+  // after it, so the answer lies between the two.
+  const uint64_t prefix = KeyPrefix(user_key);
+  auto first = std::lower_bound(index_.begin(), index_.end(), prefix);
+  auto last = std::upper_bound(first, index_.end(), prefix);
+
+  size_t lo = first - index_.begin();
+  lo = lo > 0 ? (lo - 1) * kIndexInterval : 0;
+  size_t hi = std::min<size_t>((last - index_.begin()) * kIndexInterval,
+                               NumEntries());
+
+  // Same tie-break as EncodeSeekKey() in memtable.cc.
+  const uint64_t tag = PackSequenceAndType(seq, kTypeRangeDeletion);
+
+  while (lo < hi) {
+    const size_t mid = lo + (hi - lo) / 2;
+    Entry e = GetEntry(mid);
+    const int r = e.user_key.Compare(user_key);
+
+    if (r < 0 || (r == 0 && e.tag > tag))
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+
+  return lo;
+}
+
+LookupResult CompactMemTable::Get(const Slice& key, SequenceNumber seq,
+                                  std::string* value) const {
+  const SequenceNumber tombstone_seq =
+      range_tombstones_->IsEmpty()
+          ? 0
+          : range_tombstones_->MaxCoveringTombstoneSeqnum(key, seq);
+  KeyVersionResolver resolver(tombstone_seq);
+
+  for (size_t i = LowerBound(key, seq); i < NumEntries(); ++i) {
+    Entry e = GetEntry(i);
+    SequenceNumber entry_seq;
+    ValueType type;
+    UnPackSequenceAndType(e.tag, &entry_seq, &type);
+
+    if (e.user_key != key || !resolver.Visit(entry_seq, type, e.value)) break;
+  }
+
+  return resolver.Finish(merge_operator_.get(), key, value);
+}
+
+size_t CompactMemTable::ApproximateMemoryUsage() const {
+  return offsets_.back() + offsets_.capacity() * sizeof(uint32_t) +
+         index_.capacity() * sizeof(uint64_t) + tombstone_data_.capacity();
+}
+
+CompactMemTable::Iterator::Iterator(const CompactMemTable* mem,
+                                    SequenceNumber read_seq)
+    : mem_(mem), read_seq_(read_seq), pos_(mem->NumEntries()) {}
+
+bool CompactMemTable::Iterator::IsHidden() const {
+  const SequenceNumber seq = sequence();
+
+  if (seq > read_seq_) return true;
+
+  return !mem_->range_tombstones_->IsEmpty() &&
+         mem_->range_tombstones_->ShouldDelete(key(), seq, read_seq_);
+}
+
+void CompactMemTable::Iterator::SkipForward() {
+  while (Valid() && IsHidden()) ++pos_;
+}
+
+void CompactMemTable::Iterator::Seek(const Slice& user_key) {
+  pos_ = mem_->LowerBound(user_key, kMaxSequenceNumber);
+  SkipForward();
+}
+
+void CompactMemTable::Iterator::SeekToFirst() {
+  pos_ = 0;
+  SkipForward();
+}
+
+void CompactMemTable::Iterator::SeekToLast() {
+  pos_ = mem_->NumEntries();
+  Prev();
+}
+
+void CompactMemTable::Iterator::Next() {
+  assert(Valid());
+
+  ++pos_;
+  SkipForward();
+}
+
+void CompactMemTable::Iterator::Prev() {
+  // Stepping back from the first entry (or from the end of an empty table)
+  // leaves the iterator invalid.
+  do {
+    pos_ = pos_ > 0 ? pos_ - 1 : mem_->NumEntries();
+  } while (Valid() && IsHidden());
+}
+
+Slice CompactMemTable::Iterator::key() const {
+  return mem_->GetEntry(pos_).user_key;
+}
+
+SequenceNumber CompactMemTable::Iterator::sequence() const {
+  SequenceNumber seq;
+  ValueType type;
+  UnPackSequenceAndType(mem_->GetEntry(pos_).tag, &seq, &type);
+
+  return seq;
+}
+
+ValueType CompactMemTable::Iterator::type() const {
+  SequenceNumber seq;
+  ValueType type;
+  UnPackSequenceAndType(mem_->GetEntry(pos_).tag, &seq, &type);
+
+  return type;
+}
+
+Slice CompactMemTable::Iterator::value() const {
+  return mem_->GetEntry(pos_).value;
+}
+
+}  // namespace badger
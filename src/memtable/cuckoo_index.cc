@@ -0,0 +1,300 @@
+#include "cpp-badger/memtable/cuckoo_index.hh"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <new>
+#include <vector>
+
+#include "cpp-badger/util/fast_range.hh"
+#include "cpp-badger/util/hash.hh"
+
+namespace badger {
+
+namespace {
+
+/// Seeds of the two bucket hashes.
+constexpr uint64_t kBucketSeeds[2] = {0x2545f4914f6cdd1dULL,
+                                      0x9fb21c651e98df25ULL};
+
+/// Buckets visited by one cuckoo path search. Six children per bucket reach
+/// paths of three or four moves, which is enough until the table is nearly
+/// full.
+constexpr size_t kMaxSearchBuckets = 512;
+
+/// Path searches an Insert() makes before it reports the table full.
+constexpr int kMaxInsertAttempts = 16;
+
+}  // namespace
+
+/// Locks the stripes of up to two buckets, in stripe order so that writers
+/// can't deadlock.
+class CuckooIndex::StripeGuard {
+  StripeGuard(const StripeGuard&) = delete;
+  StripeGuard& operator=(const StripeGuard&) = delete;
+
+ public:
+  StripeGuard(CuckooIndex* index, size_t b1, size_t b2) {
+    size_t s1 = b1 % kNumLockStripes;
+    size_t s2 = b2 % kNumLockStripes;
+    if (s1 > s2) std::swap(s1, s2);
+
+    first_ = &index->stripes_[s1].mutex;
+    second_ = s1 == s2 ? nullptr : &index->stripes_[s2].mutex;
+    first_->lock();
+    if (second_) second_->lock();
+  }
+
+  ~StripeGuard() {
+    if (second_) second_->unlock();
+    first_->unlock();
+  }
+
+ private:
+  std::mutex* first_;
+  std::mutex* second_;
+};
+
+CuckooIndex::CuckooIndex(Arena* arena, size_t expected_keys)
+    : arena_(arena) {
+  const auto slots =
+      static_cast<size_t>(static_cast<double>(expected_keys) / kMaxLoadFactor);
+  num_buckets_ = std::max<size_t>(
+      (slots + kSlotsPerBucket - 1) / kSlotsPerBucket, 1);
+
+  buckets_ = static_cast<Bucket*>(
+      arena_->Allocate(num_buckets_ * sizeof(Bucket), alignof(Bucket)));
+  for (size_t i = 0; i < num_buckets_; ++i) new (&buckets_[i]) Bucket();
+}
+
+CuckooIndex::KeyHash CuckooIndex::HashKey(const Slice& key) const {
+  KeyHash kh;
+  for (int i = 0; i < 2; ++i) {
+    kh.hashes[i] = Hash64(key.data(), key.size(), kBucketSeeds[i]);
+    kh.buckets[i] = fast_range64(kh.hashes[i], num_buckets_);
+  }
+  kh.tag = Tag(kh.hashes[0]);
+
+  return kh;
+}
+
+size_t CuckooIndex::AltBucket(const Entry& entry, size_t bucket) const {
+  const size_t b1 = fast_range64(entry.hashes[0], num_buckets_);
+
+  return b1 != bucket ? b1 : fast_range64(entry.hashes[1], num_buckets_);
+}
+
+int CuckooIndex::FindSlot(const Bucket& bucket, const Slice& key,
+                          const KeyHash& kh) {
+  for (int s = 0; s < kSlotsPerBucket; ++s) {
+    if (bucket.tags[s].load(std::memory_order_relaxed) != kh.tag) continue;
+
+    const Entry* entry = bucket.entries[s].load(std::memory_order_acquire);
+    if (entry != nullptr && entry->hashes[0] == kh.hashes[0] &&
+        entry->GetKey() == key) {
+      return s;
+    }
+  }
+
+  return -1;
+}
+
+int CuckooIndex::FreeSlot(const Bucket& bucket) {
+  for (int s = 0; s < kSlotsPerBucket; ++s)
+    if (bucket.entries[s].load(std::memory_order_relaxed) == nullptr) return s;
+
+  return -1;
+}
+
+void CuckooIndex::BeginWrite(Bucket* bucket) {
+  const uint32_t version = bucket->version.load(std::memory_order_relaxed);
+  bucket->version.store(version + 1, std::memory_order_relaxed);
+  // Keeps the slot stores below from being seen before the odd version.
+  std::atomic_thread_fence(std::memory_order_release);
+}
+
+void CuckooIndex::EndWrite(Bucket* bucket) {
+  const uint32_t version = bucket->version.load(std::memory_order_relaxed);
+  bucket->version.store(version + 1, std::memory_order_release);
+}
+
+void CuckooIndex::SetSlot(Bucket* bucket, int slot, const Entry* entry) {
+  bucket->tags[slot].store(entry ? Tag(entry->hashes[0]) : 0,
+                           std::memory_order_relaxed);
+  bucket->entries[slot].store(entry, std::memory_order_release);
+}
+
+const CuckooIndex::Entry* CuckooIndex::NewEntry(const Slice& key,
+                                                const KeyHash& kh,
+                                                uint64_t value) {
+  const size_t size =
+      std::max(sizeof(Entry), offsetof(Entry, key) + key.size());
+  void* mem;
+  {
+    std::lock_guard<std::mutex> lock(arena_mutex_);
+    mem = arena_->Allocate(size, alignof(Entry));
+  }
+
+  auto* entry = new (mem) Entry();
+  entry->value.store(value, std::memory_order_relaxed);
+  entry->hashes[0] = kh.hashes[0];
+  entry->hashes[1] = kh.hashes[1];
+  entry->key_size = static_cast<uint32_t>(key.size());
+  if (!key.IsEmpty()) std::memcpy(entry->key, key.data(), key.size());
+
+  return entry;
+}
+
+bool CuckooIndex::Insert(const Slice& key, uint64_t value) {
+  const KeyHash kh = HashKey(key);
+  const Entry* entry = nullptr;
+
+  for (int attempt = 0; attempt < kMaxInsertAttempts; ++attempt) {
+    {
+      StripeGuard guard(this, kh.buckets[0], kh.buckets[1]);
+
+      for (size_t b : kh.buckets) {
+        const int s = FindSlot(buckets_[b], key, kh);
+        if (s >= 0) {
+          buckets_[b].entries[s].load(std::memory_order_relaxed)
+              ->value.store(value, std::memory_order_relaxed);
+          return true;
+        }
+      }
+
+      for (size_t b : kh.buckets) {
+        const int s = FreeSlot(buckets_[b]);
+        if (s < 0) continue;
+
+        if (entry == nullptr) entry = NewEntry(key, kh, value);
+        BeginWrite(&buckets_[b]);
+        SetSlot(&buckets_[b], s, entry);
+        EndWrite(&buckets_[b]);
+        size_.fetch_add(1, std::memory_order_relaxed);
+        return true;
+      }
+    }
+
+    MakeRoom(kh.buckets[0], kh.buckets[1]);
+  }
+
+  return false;
+}
+
+bool CuckooIndex::Get(const Slice& key, uint64_t* value) const {
+  const KeyHash kh = HashKey(key);
+  const Bucket& b1 = buckets_[kh.buckets[0]];
+  const Bucket& b2 = buckets_[kh.buckets[1]];
+
+  for (;;) {
+    const uint32_t v1 = b1.version.load(std::memory_order_acquire);
+    const uint32_t v2 = b2.version.load(std::memory_order_acquire);
+    if (((v1 | v2) & 1) != 0) continue;
+
+    const Entry* entry = nullptr;
+    for (const Bucket* bucket : {&b1, &b2}) {
+      const int s = FindSlot(*bucket, key, kh);
+      if (s >= 0) {
+        entry = bucket->entries[s].load(std::memory_order_acquire);
+        break;
+      }
+    }
+
+    // Keeps the slot loads above from moving past the version checks.
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (b1.version.load(std::memory_order_relaxed) != v1 ||
+        b2.version.load(std::memory_order_relaxed) != v2) {
+      continue;
+    }
+
+    if (entry == nullptr) return false;
+
+    *value = entry->value.load(std::memory_order_relaxed);
+    return true;
+  }
+}
+
+bool CuckooIndex::Erase(const Slice& key) {
+  const KeyHash kh = HashKey(key);
+  StripeGuard guard(this, kh.buckets[0], kh.buckets[1]);
+
+  for (size_t b : kh.buckets) {
+    const int s = FindSlot(buckets_[b], key, kh);
+    if (s < 0) continue;
+
+    BeginWrite(&buckets_[b]);
+    SetSlot(&buckets_[b], s, nullptr);
+    EndWrite(&buckets_[b]);
+    size_.fetch_sub(1, std::memory_order_relaxed);
+    return true;
+  }
+
+  return false;
+}
+
+bool CuckooIndex::MakeRoom(size_t b1, size_t b2) {
+  // A breadth-first search over buckets, without locks. Each node is a
+  // bucket reached by moving the entry in `slot` of its parent's bucket.
+  struct Node {
+    size_t bucket;
+    int parent;
+    int slot;
+  };
+
+  std::vector<Node> nodes;
+  nodes.reserve(kMaxSearchBuckets);
+  nodes.push_back({b1, -1, -1});
+  if (b2 != b1) nodes.push_back({b2, -1, -1});
+
+  for (size_t i = 0; i < nodes.size(); ++i) {
+    const Bucket& bucket = buckets_[nodes[i].bucket];
+
+    if (FreeSlot(bucket) >= 0) {
+      // Move the entries from the end of the path back, each into the slot
+      // freed by the one before.
+      for (int n = static_cast<int>(i); nodes[n].parent >= 0;
+           n = nodes[n].parent) {
+        const Node& parent = nodes[nodes[n].parent];
+        if (!Move(parent.bucket, nodes[n].slot, nodes[n].bucket)) return false;
+      }
+
+      return true;
+    }
+
+    for (int s = 0; s < kSlotsPerBucket && nodes.size() < kMaxSearchBuckets;
+         ++s) {
+      const Entry* entry = bucket.entries[s].load(std::memory_order_acquire);
+      if (entry == nullptr) continue;
+
+      const size_t alt = AltBucket(*entry, nodes[i].bucket);
+      if (alt != nodes[i].bucket)
+        nodes.push_back({alt, static_cast<int>(i), s});
+    }
+  }
+
+  return false;
+}
+
+bool CuckooIndex::Move(size_t from, int slot, size_t to) {
+  StripeGuard guard(this, from, to);
+  Bucket* src = &buckets_[from];
+  Bucket* dst = &buckets_[to];
+
+  const Entry* entry = src->entries[slot].load(std::memory_order_relaxed);
+  if (entry == nullptr || AltBucket(*entry, from) != to) return false;
+
+  const int free_slot = FreeSlot(*dst);
+  if (free_slot < 0) return false;
+
+  // Readers of the entry check both buckets, and see both change.
+  BeginWrite(src);
+  BeginWrite(dst);
+  SetSlot(dst, free_slot, entry);
+  SetSlot(src, slot, nullptr);
+  EndWrite(dst);
+  EndWrite(src);
+
+  return true;
+}
+
+}  // namespace badger
@@ -0,0 +1,440 @@
+#include "cpp-badger/memtable/memtable.hh"
+
+#include <cstring>
+#include <vector>
+
+#include "cpp-badger/util/coding.hh"
+#include "cpp-badger/util/fast_range.hh"
+#include "cpp-badger/util/hash.hh"
+#include "cpp-badger/util/perf_context.hh"
+
+namespace badger {
+
+namespace {
+
+/// A decoded view of an entry stored in the memtable.
+struct ParsedEntry {
+  Slice user_key;
+  SequenceNumber seq;
+  ValueType type;
+  Slice value;
+};
+
+ParsedEntry ParseEntry(const char* entry) {
+  ParsedEntry parsed;
+  Slice internal_key = GetLengthPrefixedSlice(entry);
+
+  assert(internal_key.size() >= 8);
+
+  const size_t user_key_size = internal_key.size() - 8;
+  parsed.user_key = Slice(internal_key.data(), user_key_size);
+  UnPackSequenceAndType(DecodeFixed64(internal_key.data() + user_key_size),
+                        &parsed.seq, &parsed.type);
+  parsed.value =
+      GetLengthPrefixedSlice(internal_key.data() + internal_key.size());
+
+  return parsed;
+}
+
+/// Encodes a seek target for (user_key, seq). Since the comparator only looks
+/// at the internal key, the value part is omitted.
+const char* EncodeSeekKey(std::string* scratch, const Slice& user_key,
+                          SequenceNumber seq) {
+  scratch->clear();
+  PutVarint32(scratch, static_cast<uint32_t>(user_key.size() + 8));
+  scratch->append(user_key.data(), user_key.size());
+  // kTypeRangeDeletion is the largest type, so the target sorts before every
+  // entry with the same user key and sequence number.
+  PutFixed64(scratch, PackSequenceAndType(seq, kTypeRangeDeletion));
+
+  return scratch->data();
+}
+
+/// Applies `operands` (newest first) in order from oldest to newest. With
+/// `full_merge` the oldest operand is merged onto `existing_value` (nullptr
+/// for a deleted or missing key); otherwise the operands are only combined
+/// with each other.
+bool FoldOperands(const MergeOperator& merge_operator, const Slice& key,
+                  const Slice* existing_value, bool full_merge,
+                  const std::vector<Slice>& operands, std::string* result) {
+  auto it = operands.rbegin();
+  std::string acc;
+  std::string tmp;
+
+  if (full_merge) {
+    if (!merge_operator.Merge(key, existing_value, *it, &acc)) return false;
+  } else {
+    acc.assign(it->data(), it->size());
+  }
+
+  for (++it; it != operands.rend(); ++it) {
+    const Slice current(acc);
+
+    if (!merge_operator.Merge(key, &current, *it, &tmp)) return false;
+
+    acc.swap(tmp);
+  }
+
+  result->swap(acc);
+
+  return true;
+}
+
+}  // namespace
+
+bool KeyVersionResolver::Visit(SequenceNumber seq, ValueType type,
+                               const Slice& value) {
+  // Entries older than the covering range tombstone are deleted.
+  if (seq <= tombstone_seq_) return false;
+
+  switch (type) {
+    case kTypeMerge:
+      operands_.push_back(value);
+      return true;
+    case kTypeFoldedMerge:
+      // Already combines every older operand; there is no base to apply it to.
+      operands_.push_back(value);
+      return false;
+    case kTypeValue:
+      result_ = LookupResult::kFound;
+      base_ = value;
+      return false;
+    default:
+      assert(type == kTypeDeletion);
+      result_ = LookupResult::kDeleted;
+      return false;
+  }
+}
+
+LookupResult KeyVersionResolver::Finish(const MergeOperator* merge_operator,
+                                        const Slice& key,
+                                        std::string* value) const {
+  if (operands_.empty()) {
+    if (result_ == LookupResult::kFound)
+      value->assign(base_.data(), base_.size());
+
+    return result_;
+  }
+
+  assert(merge_operator != nullptr);
+
+  // Without a base value or deletion the operands can only be combined with
+  // each other; the caller applies them to older data.
+  const bool full_merge = result_ != LookupResult::kNotFound;
+  const Slice* existing = result_ == LookupResult::kFound ? &base_ : nullptr;
+
+  if (!FoldOperands(*merge_operator, key, existing, full_merge, operands_,
+                    value))
+    return LookupResult::kMergeFailed;
+
+  return full_merge ? LookupResult::kFound : LookupResult::kMergeInProgress;
+}
+
+int MemTable::KeyComparator::operator()(const char* a, const char* b) const {
+  Slice ka = GetLengthPrefixedSlice(a);
+  Slice kb = GetLengthPrefixedSlice(b);
+
+  Slice ua(ka.data(), ka.size() - 8);
+  Slice ub(kb.data(), kb.size() - 8);
+  int r = ua.Compare(ub);
+
+  if (r == 0) {
+    // Newer entries (larger tags) sort first.
+    const uint64_t ta = DecodeFixed64(ka.data() + ua.size());
+    const uint64_t tb = DecodeFixed64(kb.data() + ub.size());
+
+    if (ta > tb)
+      r = -1;
+    else if (ta < tb)
+      r = +1;
+  }
+
+  return r;
+}
+
+MemTable::MemTable(const MemTableOptions& options)
+    : options_(options),
+      arena_(options.arena_block_size),
+      table_(comparator_, &arena_),
+      range_del_table_(comparator_, &arena_) {
+  arena_.SetStatistics(options_.statistics);
+  table_.SetStatistics(options_.statistics);
+  range_del_table_.SetStatistics(options_.statistics);
+
+  if (options_.inplace_update_support) {
+    assert(options_.inplace_update_num_locks > 0);
+
+    locks_ = std::make_unique<std::shared_mutex[]>(
+        options_.inplace_update_num_locks);
+  }
+}
+
+std::shared_mutex& MemTable::GetLock(const Slice& key) const {
+  const uint32_t h = hash(key.data(), key.size(), 0);
+
+  return locks_[fast_range32(
+      h, static_cast<uint32_t>(options_.inplace_update_num_locks))];
+}
+
+void MemTable::Add(SequenceNumber seq, ValueType type, const Slice& key,
+                   const Slice& value) {
+  Add(seq, type, SliceParts(&key, 1), SliceParts(&value, 1));
+}
+
+void MemTable::Add(SequenceNumber seq, ValueType type, const SliceParts& key,
+                   const SliceParts& value) {
+  const size_t key_size = key.size();
+  const uint32_t internal_key_size = static_cast<uint32_t>(key_size + 8);
+  const uint32_t value_size = static_cast<uint32_t>(value.size());
+  const size_t encoded_len = VarintLength(internal_key_size) +
+                             internal_key_size + VarintLength(value_size) +
+                             value_size;
+
+  char* buf = static_cast<char*>(arena_.Allocate(encoded_len, 1));
+  char* p = EncodeVarint32(buf, internal_key_size);
+  p = key.CopyTo(p);
+  EncodeFixed64(p, PackSequenceAndType(seq, type));
+  p += 8;
+  p = EncodeVarint32(p, value_size);
+  p = value.CopyTo(p);
+
+  assert(static_cast<size_t>(p - buf) == encoded_len);
+
+  if (type == kTypeRangeDeletion) {
+    range_del_table_.Insert(buf);
+    num_range_deletes_.fetch_add(1, std::memory_order_relaxed);
+
+    // Invalidate the cached fragments; the next reader rebuilds them. Taking
+    // the lock keeps a rebuild that missed this tombstone from publishing
+    // its list afterwards.
+    std::lock_guard<std::mutex> lock(range_del_mutex_);
+    fragmented_range_tombstones_.store(nullptr, std::memory_order_release);
+  } else {
+    table_.Insert(buf);
+    num_entries_.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+void MemTable::Update(SequenceNumber seq, const Slice& key,
+                      const Slice& value) {
+  if (options_.inplace_update_support && UpdateInPlace(key, value)) {
+    num_inplace_updates_.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+
+  Add(seq, kTypeValue, key, value);
+}
+
+bool MemTable::UpdateInPlace(const Slice& key, const Slice& value) {
+  std::string scratch;
+  Table::Iterator iter(&table_);
+  iter.Seek(EncodeSeekKey(&scratch, key, kMaxSequenceNumber));
+
+  if (!iter.Valid()) return false;
+
+  ParsedEntry e = ParseEntry(iter.key());
+
+  if (e.user_key != key || e.type != kTypeValue) return false;
+
+  // A newer range tombstone already deleted this entry; overwriting it would
+  // not resurrect the key.
+  if (e.seq < MaxCoveringTombstoneSeqnum(key, kMaxSequenceNumber)) return false;
+
+  if (value.size() > e.value.size()) return false;
+
+  // The new length never needs more varint bytes than the old one, so the
+  // value is rewritten within the existing slot. The tag is left untouched:
+  // concurrent readers compare it without holding the lock.
+  char* p = const_cast<char*>(e.value.data()) -
+            VarintLength(static_cast<uint32_t>(e.value.size()));
+  std::unique_lock<std::shared_mutex> lock(GetLock(key));
+  p = EncodeVarint32(p, static_cast<uint32_t>(value.size()));
+  memcpy(p, value.data(), value.size());
+
+  return true;
+}
+
+void MemTable::Merge(SequenceNumber seq, const Slice& key,
+                     const Slice& operand) {
+  assert(options_.merge_operator != nullptr);
+
+  const size_t limit = options_.max_successive_merges;
+
+  if (limit > 0 && CountSuccessiveMerges(key, limit) >= limit) {
+    // Fold the existing chain together with the new operand. If the chain
+    // resolves to a value within this memtable, the result is a plain value.
+    // Otherwise it is a partial merge of the operands, stored as a folded
+    // operand so that readers stop there instead of walking the older ones.
+    // Either way the chain read by Get() is at most `limit` entries long, so
+    // this fold is bounded too.
+    std::string existing;
+    std::string folded;
+    const LookupResult result = Get(key, kMaxSequenceNumber, &existing);
+
+    if (result == LookupResult::kFound ||
+        result == LookupResult::kMergeInProgress) {
+      const Slice existing_slice(existing);
+
+      if (options_.merge_operator->Merge(key, &existing_slice, operand,
+                                         &folded)) {
+        Add(seq,
+            result == LookupResult::kFound ? kTypeValue : kTypeFoldedMerge,
+            key, folded);
+        return;
+      }
+    }
+  }
+
+  Add(seq, kTypeMerge, key, operand);
+}
+
+size_t MemTable::CountSuccessiveMerges(const Slice& key, size_t limit) const {
+  std::string scratch;
+  Table::Iterator iter(&table_);
+  iter.Seek(EncodeSeekKey(&scratch, key, kMaxSequenceNumber));
+
+  const SequenceNumber tombstone_seq =
+      MaxCoveringTombstoneSeqnum(key, kMaxSequenceNumber);
+  size_t count = 0;
+
+  for (; count < limit && iter.Valid(); iter.Next()) {
+    ParsedEntry e = ParseEntry(iter.key());
+
+    if (e.user_key != key || e.seq <= tombstone_seq) break;
+
+    if (e.type == kTypeFoldedMerge) {
+      ++count;
+      break;
+    }
+
+    if (e.type != kTypeMerge) break;
+
+    ++count;
+  }
+
+  return count;
+}
+
+SequenceNumber MemTable::MaxCoveringTombstoneSeqnum(const Slice& key,
+                                                    SequenceNumber seq) const {
+  if (NumRangeDeletes() == 0) return 0;
+
+  return GetRangeTombstones()->MaxCoveringTombstoneSeqnum(key, seq);
+}
+
+std::shared_ptr<const FragmentedRangeTombstoneList>
+MemTable::GetRangeTombstones() const {
+  auto list = fragmented_range_tombstones_.load(std::memory_order_acquire);
+
+  if (list != nullptr) return list;
+
+  std::lock_guard<std::mutex> lock(range_del_mutex_);
+
+  // Another reader may have rebuilt the list while we waited.
+  list = fragmented_range_tombstones_.load(std::memory_order_acquire);
+
+  if (list == nullptr) {
+    std::vector<RangeTombstone> tombstones;
+    Table::Iterator iter(&range_del_table_);
+
+    for (iter.SeekToFirst(); iter.Valid(); iter.Next()) {
+      ParsedEntry e = ParseEntry(iter.key());
+      tombstones.emplace_back(e.user_key, e.value, e.seq);
+    }
+
+    list = std::make_shared<const FragmentedRangeTombstoneList>(
+        std::move(tombstones));
+    fragmented_range_tombstones_.store(list, std::memory_order_release);
+  }
+
+  return list;
+}
+
+LookupResult MemTable::Get(const Slice& key, SequenceNumber seq,
+                           std::string* value) const {
+  BADGER_PERF_TIMER_GUARD(get_from_memtable_nanos);
+  BADGER_PERF_COUNTER_ADD(get_from_memtable_count, 1);
+
+  std::string scratch;
+  Table::Iterator iter(&table_);
+  iter.Seek(EncodeSeekKey(&scratch, key, seq));
+
+  KeyVersionResolver resolver(MaxCoveringTombstoneSeqnum(key, seq));
+  std::shared_lock<std::shared_mutex> lock;
+
+  if (options_.inplace_update_support)
+    lock = std::shared_lock<std::shared_mutex>(GetLock(key));
+
+  for (; iter.Valid(); iter.Next()) {
+    ParsedEntry e = ParseEntry(iter.key());
+
+    if (e.user_key != key || !resolver.Visit(e.seq, e.type, e.value)) break;
+  }
+
+  return resolver.Finish(options_.merge_operator.get(), key, value);
+}
+
+MemTable::Iterator::Iterator(const MemTable* mem, SequenceNumber read_seq)
+    : iter_(&mem->table_), read_seq_(read_seq) {
+  if (mem->NumRangeDeletes() > 0) tombstones_ = mem->GetRangeTombstones();
+}
+
+bool MemTable::Iterator::IsHidden() const {
+  ParsedEntry e = ParseEntry(iter_.key());
+
+  if (e.seq > read_seq_) return true;
+
+  return tombstones_ != nullptr &&
+         tombstones_->ShouldDelete(e.user_key, e.seq, read_seq_);
+}
+
+void MemTable::Iterator::SkipForward() {
+  while (iter_.Valid() && IsHidden()) iter_.Next();
+}
+
+void MemTable::Iterator::SkipBackward() {
+  while (iter_.Valid() && IsHidden()) iter_.Prev();
+}
+
+void MemTable::Iterator::Seek(const Slice& user_key) {
+  iter_.Seek(EncodeSeekKey(&scratch_, user_key, kMaxSequenceNumber));
+  SkipForward();
+}
+
+void MemTable::Iterator::SeekToFirst() {
+  iter_.SeekToFirst();
+  SkipForward();
+}
+
+void MemTable::Iterator::SeekToLast() {
+  iter_.SeekToLast();
+  SkipBackward();
+}
+
+void MemTable::Iterator::Next() {
+  iter_.Next();
+  SkipForward();
+}
+
+void MemTable::Iterator::Prev() {
+  iter_.Prev();
+  SkipBackward();
+}
+
+Slice MemTable::Iterator::key() const {
+  return ParseEntry(iter_.key()).user_key;
+}
+
+SequenceNumber MemTable::Iterator::sequence() const {
+  return ParseEntry(iter_.key()).seq;
+}
+
+ValueType MemTable::Iterator::type() const {
+  return ParseEntry(iter_.key()).type;
+}
+
+Slice MemTable::Iterator::value() const {
+  return ParseEntry(iter_.key()).value;
+}
+
+}  // namespace badger
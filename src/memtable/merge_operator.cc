@@ -0,0 +1,26 @@
+#include "cpp-badger/memtable/merge_operator.hh"
+
+#include "cpp-badger/util/coding.hh"
+
+namespace badger {
+
+bool UInt64AddOperator::Merge(const Slice& /*key*/,
+                              const Slice* existing_value, const Slice& value,
+                              std::string* new_value) const {
+  uint64_t base = 0;
+
+  if (existing_value != nullptr) {
+    if (existing_value->size() != sizeof(uint64_t)) return false;
+
+    base = DecodeFixed64(existing_value->data());
+  }
+
+  if (value.size() != sizeof(uint64_t)) return false;
+
+  new_value->clear();
+  PutFixed64(new_value, base + DecodeFixed64(value.data()));
+
+  return true;
+}
+
+}  // namespace badger
@@ -0,0 +1,110 @@
+//  Copyright (c) 2018-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+
+#include "cpp-badger/memtable/range_tombstone_fragmenter.hh"
+
+#include <algorithm>
+#include <functional>
+#include <map>
+
+namespace badger {
+
+namespace {
+
+struct SliceLess {
+  bool operator()(const Slice& a, const Slice& b) const {
+    return a.Compare(b) < 0;
+  }
+};
+
+}  // namespace
+
+FragmentedRangeTombstoneList::FragmentedRangeTombstoneList(
+    std::vector<RangeTombstone> tombstones)
+    : num_unfragmented_tombstones_(tombstones.size()) {
+  std::erase_if(tombstones, [](const RangeTombstone& t) {
+    return t.start.Compare(t.end) >= 0;
+  });
+
+  if (tombstones.empty()) return;
+
+  std::sort(tombstones.begin(), tombstones.end(),
+            [](const RangeTombstone& a, const RangeTombstone& b) {
+              return a.start.Compare(b.start) < 0;
+            });
+
+  // Every start and end key is a potential fragment boundary.
+  std::vector<Slice> boundaries;
+  boundaries.reserve(tombstones.size() * 2);
+
+  for (const auto& t : tombstones) {
+    boundaries.push_back(t.start);
+    boundaries.push_back(t.end);
+  }
+
+  std::sort(boundaries.begin(), boundaries.end(), SliceLess());
+  boundaries.erase(std::unique(boundaries.begin(), boundaries.end()),
+                   boundaries.end());
+
+  // Sweep the boundaries left to right, keeping the tombstones that cover the
+  // current position keyed by their end key so that expired ones can be
+  // dropped from the front.
+  std::multimap<Slice, SequenceNumber, SliceLess> active;
+  size_t next = 0;
+  std::vector<SequenceNumber> covering;
+
+  for (size_t i = 0; i + 1 < boundaries.size(); ++i) {
+    const Slice& lo = boundaries[i];
+    const Slice& hi = boundaries[i + 1];
+
+    while (!active.empty() && active.begin()->first.Compare(lo) <= 0)
+      active.erase(active.begin());
+
+    while (next < tombstones.size() &&
+           tombstones[next].start.Compare(lo) <= 0) {
+      active.emplace(tombstones[next].end, tombstones[next].seq);
+      ++next;
+    }
+
+    if (active.empty()) continue;
+
+    covering.clear();
+    for (const auto& [end, seq] : active) covering.push_back(seq);
+
+    std::sort(covering.begin(), covering.end(), std::greater<>());
+    covering.erase(std::unique(covering.begin(), covering.end()),
+                   covering.end());
+
+    size_t seq_start_idx = seqs_.size();
+    seqs_.insert(seqs_.end(), covering.begin(), covering.end());
+    fragments_.push_back({lo, hi, seq_start_idx, seqs_.size()});
+  }
+}
+
+SequenceNumber FragmentedRangeTombstoneList::MaxCoveringTombstoneSeqnum(
+    const Slice& user_key, SequenceNumber upper_bound) const {
+  // Find the last fragment whose start is <= user_key.
+  auto it = std::upper_bound(fragments_.begin(), fragments_.end(), user_key,
+                             [](const Slice& key, const auto& f) {
+                               return key.Compare(f.start) < 0;
+                             });
+
+  if (it == fragments_.begin()) return 0;
+
+  --it;
+
+  if (user_key.Compare(it->end) >= 0) return 0;
+
+  // Sequence numbers are sorted in descending order; find the first one that
+  // is visible at `upper_bound`.
+  auto seq_begin = seqs_.begin() + static_cast<ptrdiff_t>(it->seq_start_idx);
+  auto seq_end = seqs_.begin() + static_cast<ptrdiff_t>(it->seq_end_idx);
+  auto seq_it =
+      std::lower_bound(seq_begin, seq_end, upper_bound, std::greater<>());
+
+  return seq_it == seq_end ? 0 : *seq_it;
+}
+
+}  // namespace badger
@@ -0,0 +1,156 @@
+#include "cpp-badger/memtable/sharded_memtable.hh"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "cpp-badger/util/fast_range.hh"
+#include "cpp-badger/util/hash.hh"
+
+namespace badger {
+
+namespace {
+
+/// Seed for shard routing; distinct from the seed used by the in-place update
+/// locks so that a shard's keys still spread across its lock stripes.
+constexpr uint32_t kShardHashSeed = 0x5bd1e995;
+
+/// Heap order for the merging iterator: std::*_heap keep the largest element
+/// at the front, so "greater" entries compare as less.
+bool ComesAfter(const MemTable::Iterator* a, const MemTable::Iterator* b) {
+  int r = a->key().Compare(b->key());
+
+  if (r != 0) return r > 0;
+
+  return a->sequence() < b->sequence();
+}
+
+}  // namespace
+
+ShardedMemTable::ShardedMemTable(size_t num_shards,
+                                 const MemTableOptions& options) {
+  if (num_shards == 0 || num_shards > UINT32_MAX)
+    throw std::invalid_argument("num_shards must be in [1, 2^32)");
+
+  shards_.reserve(num_shards);
+
+  for (size_t i = 0; i < num_shards; ++i)
+    shards_.push_back(std::make_unique<Shard>(options));
+}
+
+size_t ShardedMemTable::ShardIndex(const Slice& key) const {
+  const uint32_t h = hash(key.data(), key.size(), kShardHashSeed);
+
+  return fast_range32(h, static_cast<uint32_t>(shards_.size()));
+}
+
+size_t ShardedMemTable::ShardIndex(const SliceParts& key) const {
+  const uint32_t h = hash(key, kShardHashSeed);
+
+  return fast_range32(h, static_cast<uint32_t>(shards_.size()));
+}
+
+void ShardedMemTable::Add(SequenceNumber seq, ValueType type,
+                          const Slice& key, const Slice& value) {
+  Add(seq, type, SliceParts(&key, 1), SliceParts(&value, 1));
+}
+
+void ShardedMemTable::Add(SequenceNumber seq, ValueType type,
+                          const SliceParts& key, const SliceParts& value) {
+  if (type == kTypeRangeDeletion) {
+    for (auto& shard : shards_) {
+      std::lock_guard<std::mutex> lock(shard->mutex);
+      shard->mem->Add(seq, type, key, value);
+    }
+
+    return;
+  }
+
+  Shard& shard = GetShardFor(key);
+  std::lock_guard<std::mutex> lock(shard.mutex);
+  shard.mem->Add(seq, type, key, value);
+}
+
+void ShardedMemTable::Update(SequenceNumber seq, const Slice& key,
+                             const Slice& value) {
+  Shard& shard = GetShardFor(key);
+  std::lock_guard<std::mutex> lock(shard.mutex);
+  shard.mem->Update(seq, key, value);
+}
+
+void ShardedMemTable::Merge(SequenceNumber seq, const Slice& key,
+                            const Slice& operand) {
+  Shard& shard = GetShardFor(key);
+  std::lock_guard<std::mutex> lock(shard.mutex);
+  shard.mem->Merge(seq, key, operand);
+}
+
+LookupResult ShardedMemTable::Get(const Slice& key, SequenceNumber seq,
+                                  std::string* value) const {
+  return GetShardFor(key).mem->Get(key, seq, value);
+}
+
+uint64_t ShardedMemTable::NumEntries() const {
+  uint64_t total = 0;
+
+  for (const auto& shard : shards_) total += shard->mem->NumEntries();
+
+  return total;
+}
+
+size_t ShardedMemTable::ApproximateMemoryUsage() const {
+  size_t total = 0;
+
+  for (auto& shard : shards_) {
+    std::lock_guard<std::mutex> lock(shard->mutex);
+    total += shard->mem->ApproximateMemoryUsage();
+  }
+
+  return total;
+}
+
+ShardedMemTable::Iterator::Iterator(const ShardedMemTable* mem,
+                                    SequenceNumber read_seq) {
+  children_.reserve(mem->NumShards());
+
+  for (const auto& shard : mem->shards_)
+    children_.emplace_back(shard->mem.get(), read_seq);
+
+  heap_.reserve(children_.size());
+}
+
+void ShardedMemTable::Iterator::BuildHeap() {
+  heap_.clear();
+
+  for (auto& child : children_)
+    if (child.Valid()) heap_.push_back(&child);
+
+  std::make_heap(heap_.begin(), heap_.end(), ComesAfter);
+}
+
+void ShardedMemTable::Iterator::Seek(const Slice& user_key) {
+  for (auto& child : children_) child.Seek(user_key);
+
+  BuildHeap();
+}
+
+void ShardedMemTable::Iterator::SeekToFirst() {
+  for (auto& child : children_) child.SeekToFirst();
+
+  BuildHeap();
+}
+
+void ShardedMemTable::Iterator::Next() {
+  assert(Valid());
+
+  std::pop_heap(heap_.begin(), heap_.end(), ComesAfter);
+  MemTable::Iterator* child = heap_.back();
+  child->Next();
+
+  if (child->Valid()) {
+    std::push_heap(heap_.begin(), heap_.end(), ComesAfter);
+  } else {
+    heap_.pop_back();
+  }
+}
+
+}  // namespace badger
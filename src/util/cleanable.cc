@@ -1,56 +1,161 @@
 #include "cpp-badger/util/cleanable.hh"
 
+#include <algorithm>
 #include <atomic>
 #include <cassert>
 #include <utility>
 
 namespace badger {
 
-// If the entire linked list was on heap we could have simply add attach one
-// link list to another. However the head is an embeded object to avoid the cost
-// of creating objects for most of the use cases when the Cleanable has only one
-// Cleanup to do. We could put evernything on heap if benchmarks show no
-// negative impact on performance.
-// Also we need to iterate on the linked list since there is no pointer to the
-// tail. We can add the tail pointer but maintainin it might negatively impact
-// the perforamnce for the common case of one cleanup where tail pointer is not
-// needed. Again benchmarks could clarify that.
-// Even without a tail pointer we could iterate on the list, find the tail, and
-// have only that node updated without the need to insert the Cleanups one by
-// one. This however would be redundant when the source Cleanable has one or a
-// few Cleanups which is the case most of the time.
-// TODO(myabandeh): if the list is too long we should maintain a tail pointer
-// and have the entire list (minus the head that has to be inserted separately)
-// merged with the target linked list at once.
+Cleanable& Cleanable::operator=(Cleanable&& other) noexcept {
+  if (this != &other) {
+    DoCleanup();
+    StealCleanups(&other);
+  }
+
+  return *this;
+}
+
+void Cleanable::StealCleanups(Cleanable* other) {
+  assert(!HasCleanups());
+
+  cleanup_ = other->cleanup_;
+  tail_ = other->tail_ == &other->cleanup_ ? &cleanup_ : other->tail_;
+
+  other->cleanup_ = Cleanup();
+  other->tail_ = &other->cleanup_;
+}
+
+void Cleanable::DoCleanupSlow() {
+  // Detach the list first, so that a cleanup may register new cleanups on
+  // this object without them being lost.
+  Cleanup head = cleanup_;
+  cleanup_ = Cleanup();
+  tail_ = &cleanup_;
+
+  head.function(head.arg1, head.arg2);
+
+  for (Cleanup* c = head.next; c != nullptr;) {
+    Cleanup* next = c->next;
+    c->function(c->arg1, c->arg2);
+    delete c;
+    c = next;
+  }
+}
+
 void Cleanable::DelegateCleanupsTo(Cleanable* other) {
-  assert(other != nullptr);
+  assert(other != nullptr && other != this);
+
+  if (!HasCleanups()) return;
+
+  if (!other->HasCleanups()) {
+    other->StealCleanups(this);
+    return;
+  }
+
+  // The embedded head cannot be linked into another list, so it moves to a
+  // heap node; the rest of the list is spliced as is.
+  Cleanup* head = new Cleanup(cleanup_);
+  other->tail_->next = head;
+  other->tail_ = tail_ == &cleanup_ ? head : tail_;
 
-  other->cleanups_.insert(other->cleanups_.end(),
-                          std::make_move_iterator(cleanups_.begin()),
-                          std::make_move_iterator(cleanups_.end()));
-  DoCleanup();
+  cleanup_ = Cleanup();
+  tail_ = &cleanup_;
 }
 
-void Cleanable::RegisterCleanup(CleanupFunction func, void* arg1, void* arg2) {
+void Cleanable::RegisterCleanupSlow(CleanupFunction func, void* arg1,
+                                    void* arg2) {
   assert(func != nullptr);
 
-  cleanups_.emplace_back(func, arg1, arg2);
+  Cleanup* c = new Cleanup{func, arg1, arg2, nullptr};
+  tail_->next = c;
+  tail_ = c;
 }
 
 struct SharedCleanablePtr::Impl : public Cleanable {
   std::atomic<unsigned> ref_count{1};
 
-  void Ref() { ref_count.fetch_add(1, std::memory_order_relaxed); }
+  void Ref(unsigned n = 1) {
+    ref_count.fetch_add(n, std::memory_order_relaxed);
+  }
 
-  void Unref() {
-    if (ref_count.fetch_sub(1, std::memory_order_relaxed) == 1) delete this;
+  // The release half orders this thread's uses of the object before the
+  // decrement; the acquire half makes every other thread's uses visible to
+  // the thread that deletes it.
+  void Unref(unsigned n = 1) {
+    if (ref_count.fetch_sub(n, std::memory_order_acq_rel) == n) delete this;
   }
 
   static void UnrefWrapper(void* arg1, void* /*arg2*/) {
     static_cast<SharedCleanablePtr::Impl*>(arg1)->Unref();
   }
+
+  static void DeferredUnrefWrapper(void* arg1, void* /*arg2*/);
+};
+
+/// Per-thread queue of references to release. Consecutive releases of the
+/// same pointer, the common case when a batch of results pinned to one block
+/// is destroyed, are coalesced into one entry and one atomic op.
+class SharedCleanablePtr::DeferredUnrefs {
+ public:
+  ~DeferredUnrefs() { Flush(); }
+
+  void Add(Impl* impl) {
+    if (size_ > 0 && entries_[size_ - 1].impl == impl) {
+      if (++entries_[size_ - 1].count == kMaxCount) {
+        --size_;
+        impl->Unref(kMaxCount);
+      }
+
+      return;
+    }
+
+    if (size_ == kCapacity) Flush();
+
+    entries_[size_++] = Entry{impl, 1};
+  }
+
+  void Flush() {
+    // Cleanups run by Unref() may queue more references, so take the entries
+    // out before releasing them.
+    while (size_ > 0) {
+      Entry entries[kCapacity];
+      const size_t n = size_;
+      std::copy_n(entries_, n, entries);
+      size_ = 0;
+
+      for (size_t i = 0; i < n; ++i) entries[i].impl->Unref(entries[i].count);
+    }
+  }
+
+ private:
+  static constexpr size_t kCapacity = 16;
+  static constexpr unsigned kMaxCount = 64;
+
+  struct Entry {
+    Impl* impl;
+    unsigned count;
+  };
+
+  Entry entries_[kCapacity];
+  size_t size_ = 0;
 };
 
+SharedCleanablePtr::DeferredUnrefs& SharedCleanablePtr::ThreadDeferredUnrefs() {
+  thread_local DeferredUnrefs deferred_unrefs;
+
+  return deferred_unrefs;
+}
+
+void SharedCleanablePtr::Impl::DeferredUnrefWrapper(void* arg1,
+                                                    void* /*arg2*/) {
+  ThreadDeferredUnrefs().Add(static_cast<SharedCleanablePtr::Impl*>(arg1));
+}
+
+void SharedCleanablePtr::FlushDeferredUnrefs() {
+  ThreadDeferredUnrefs().Flush();
+}
+
 void SharedCleanablePtr::Reset() {
   if (ptr_) {
     ptr_->Unref();
@@ -116,4 +221,28 @@ void SharedCleanablePtr::MoveAsCleanupTo(Cleanable* target) {
   }
 }
 
+SharedCleanablePtr::RefBatch::RefBatch(const SharedCleanablePtr& ptr,
+                                       unsigned batch_size, bool defer_unref)
+    : ptr_(ptr.ptr_), batch_size_(batch_size), defer_unref_(defer_unref) {
+  assert(batch_size > 0);
+}
+
+SharedCleanablePtr::RefBatch::~RefBatch() {
+  if (available_ > 0) ptr_->Unref(available_);
+}
+
+void SharedCleanablePtr::RefBatch::RegisterCopyWith(Cleanable* target) {
+  if (!ptr_) return;
+
+  if (available_ == 0) {
+    ptr_->Ref(batch_size_);
+    available_ = batch_size_;
+  }
+
+  --available_;
+  target->RegisterCleanup(
+      defer_unref_ ? &Impl::DeferredUnrefWrapper : &Impl::UnrefWrapper, ptr_,
+      nullptr);
+}
+
 }  // namespace badger
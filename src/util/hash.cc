@@ -2,8 +2,15 @@
 
 #include <string.h>
 
+#include <algorithm>
 #include <bit>
 
+#include "cpp-badger/util/slice.hh"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 namespace badger {
 
 inline constexpr bool kLittleEndian =
@@ -24,26 +31,42 @@ static uint32_t decode_fixed32(const char* ptr) {
   }
 }
 
-uint32_t hash(const char* data, size_t n, uint32_t seed) {
-  // MurmurHash1 - fast but mediocre quality
-  // https://github.com/aappleby/smhasher/wiki/MurmurHash1
-  //
-  const uint32_t m = 0xc6a4a793;
-  const uint32_t r = 24;
+// MurmurHash1 - fast but mediocre quality
+// https://github.com/aappleby/smhasher/wiki/MurmurHash1
+//
+static constexpr uint32_t kHashMultiplier = 0xc6a4a793;
+
+static uint32_t hash_init(size_t n, uint32_t seed) {
+  return static_cast<uint32_t>(seed ^ (n * kHashMultiplier));
+}
+
+static uint32_t hash_word(uint32_t h, uint32_t w) {
+  h += w;
+  h *= kHashMultiplier;
+  h ^= (h >> 16);
+
+  return h;
+}
+
+// Hashes the 4-byte words of [data, data + n) into `h` and returns the
+// number of trailing bytes left over.
+static size_t hash_words(uint32_t* h, const char* data, size_t n) {
   const char* limit = data + n;
-  uint32_t h = static_cast<uint32_t>(seed ^ (n * m));
 
-  // Pick up four bytes at a time
   while (data + 4 <= limit) {
-    uint32_t w = decode_fixed32(data);
+    *h = hash_word(*h, decode_fixed32(data));
     data += 4;
-    h += w;
-    h *= m;
-    h ^= (h >> 16);
   }
 
+  return limit - data;
+}
+
+static uint32_t hash_tail(uint32_t h, const char* data, size_t n) {
+  const uint32_t m = kHashMultiplier;
+  const uint32_t r = 24;
+
   // Pick up remaining bytes
-  switch (limit - data) {
+  switch (n) {
     // Note: The original hash implementation used data[i] << shift, which
     // promotes the char to int and then performs the shift. If the char is
     // negative, the shift is undefined behavior in C++. The hash algorithm is
@@ -69,4 +92,829 @@ uint32_t hash(const char* data, size_t n, uint32_t seed) {
   return h;
 }
 
-}  // namespace badger
\ No newline at end of file
+uint32_t hash(const char* data, size_t n, uint32_t seed) {
+  uint32_t h = hash_init(n, seed);
+
+  // Pick up four bytes at a time
+  const size_t tail = hash_words(&h, data, n);
+
+  return hash_tail(h, data + n - tail, tail);
+}
+
+uint32_t hash(const SliceParts& parts, uint32_t seed) {
+  uint32_t h = hash_init(parts.size(), seed);
+
+  // A word that straddles parts is assembled in `buf`.
+  char buf[4];
+  size_t buffered = 0;
+
+  for (int i = 0; i < parts.num_parts; ++i) {
+    const char* data = parts.parts[i].data();
+    size_t n = parts.parts[i].size();
+
+    if (buffered > 0) {
+      const size_t k = std::min(n, sizeof(buf) - buffered);
+      memcpy(buf + buffered, data, k);
+      buffered += k;
+      data += k;
+      n -= k;
+
+      if (buffered < sizeof(buf)) continue;
+
+      h = hash_word(h, decode_fixed32(buf));
+      buffered = 0;
+    }
+
+    const size_t tail = hash_words(&h, data, n);
+    memcpy(buf, data + n - tail, tail);
+    buffered = tail;
+  }
+
+  return hash_tail(h, buf, buffered);
+}
+
+// XXH3, 64 and 128-bit variants
+// https://github.com/Cyan4973/xxHash/blob/dev/doc/xxhash_spec.md
+//
+// A port of the portable code path of XXH3 (xxHash 0.8), using the default
+// secret; Hash64() and Hash128() return the same values as
+// XXH3_64bits_withSeed() and XXH3_128bits_withSeed() on every platform.
+
+static uint64_t decode_fixed64(const char* ptr) {
+  if (kLittleEndian) {
+    uint64_t result;
+    memcpy(&result, ptr, sizeof(result));
+
+    return result;
+  } else {
+    return static_cast<uint64_t>(decode_fixed32(ptr)) |
+           (static_cast<uint64_t>(decode_fixed32(ptr + 4)) << 32);
+  }
+}
+
+static constexpr uint32_t kPrime32_1 = 0x9E3779B1U;
+static constexpr uint32_t kPrime32_2 = 0x85EBCA77U;
+static constexpr uint32_t kPrime32_3 = 0xC2B2AE3DU;
+static constexpr uint64_t kPrime64_1 = 0x9E3779B185EBCA87ULL;
+static constexpr uint64_t kPrime64_2 = 0xC2B2AE3D27D4EB4FULL;
+static constexpr uint64_t kPrime64_3 = 0x165667B19E3779F9ULL;
+static constexpr uint64_t kPrime64_4 = 0x85EBCA77C2B2AE63ULL;
+static constexpr uint64_t kPrime64_5 = 0x27D4EB2F165667C5ULL;
+static constexpr uint64_t kPrimeMx1 = 0x165667919E3779F9ULL;
+static constexpr uint64_t kPrimeMx2 = 0x9FB21C651E98DF25ULL;
+
+static constexpr size_t kSecretSize = 192;
+static constexpr size_t kSecretSizeMin = 136;
+static constexpr size_t kStripeLen = 64;
+static constexpr size_t kSecretConsumeRate = 8;
+static constexpr size_t kAccNb = kStripeLen / sizeof(uint64_t);
+static constexpr size_t kSecretLastAccStart = 7;
+static constexpr size_t kSecretMergeAccsStart = 11;
+static constexpr size_t kMidSizeMax = 240;
+static constexpr size_t kMidSizeStartOffset = 3;
+static constexpr size_t kMidSizeLastOffset = 17;
+
+alignas(64) static constexpr unsigned char kSecret[kSecretSize] = {
+    0xb8, 0xfe, 0x6c, 0x39, 0x23, 0xa4, 0x4b, 0xbe, 0x7c, 0x01, 0x81, 0x2c,
+    0xf7, 0x21, 0xad, 0x1c, 0xde, 0xd4, 0x6d, 0xe9, 0x83, 0x90, 0x97, 0xdb,
+    0x72, 0x40, 0xa4, 0xa4, 0xb7, 0xb3, 0x67, 0x1f, 0xcb, 0x79, 0xe6, 0x4e,
+    0xcc, 0xc0, 0xe5, 0x78, 0x82, 0x5a, 0xd0, 0x7d, 0xcc, 0xff, 0x72, 0x21,
+    0xb8, 0x08, 0x46, 0x74, 0xf7, 0x43, 0x24, 0x8e, 0xe0, 0x35, 0x90, 0xe6,
+    0x81, 0x3a, 0x26, 0x4c, 0x3c, 0x28, 0x52, 0xbb, 0x91, 0xc3, 0x00, 0xcb,
+    0x88, 0xd0, 0x65, 0x8b, 0x1b, 0x53, 0x2e, 0xa3, 0x71, 0x64, 0x48, 0x97,
+    0xa2, 0x0d, 0xf9, 0x4e, 0x38, 0x19, 0xef, 0x46, 0xa9, 0xde, 0xac, 0xd8,
+    0xa8, 0xfa, 0x76, 0x3f, 0xe3, 0x9c, 0x34, 0x3f, 0xf9, 0xdc, 0xbb, 0xc7,
+    0xc7, 0x0b, 0x4f, 0x1d, 0x8a, 0x51, 0xe0, 0x4b, 0xcd, 0xb4, 0x59, 0x31,
+    0xc8, 0x9f, 0x7e, 0xc9, 0xd9, 0x78, 0x73, 0x64, 0xea, 0xc5, 0xac, 0x83,
+    0x34, 0xd3, 0xeb, 0xc3, 0xc5, 0x81, 0xa0, 0xff, 0xfa, 0x13, 0x63, 0xeb,
+    0x17, 0x0d, 0xdd, 0x51, 0xb7, 0xf0, 0xda, 0x49, 0xd3, 0x16, 0x55, 0x26,
+    0x29, 0xd4, 0x68, 0x9e, 0x2b, 0x16, 0xbe, 0x58, 0x7d, 0x47, 0xa1, 0xfc,
+    0x8f, 0xf8, 0xb8, 0xd1, 0x7a, 0xd0, 0x31, 0xce, 0x45, 0xcb, 0x3a, 0x8f,
+    0x95, 0x16, 0x04, 0x28, 0xaf, 0xd7, 0xfb, 0xca, 0xbb, 0x4b, 0x40, 0x7e,
+};
+
+static const char* default_secret() {
+  return reinterpret_cast<const char*>(kSecret);
+}
+
+static inline uint32_t read32(const char* p) { return decode_fixed32(p); }
+static inline uint64_t read64(const char* p) { return decode_fixed64(p); }
+
+static inline uint32_t swap32(uint32_t x) {
+  return ((x << 24) & 0xff000000) | ((x << 8) & 0x00ff0000) |
+         ((x >> 8) & 0x0000ff00) | ((x >> 24) & 0x000000ff);
+}
+
+static inline uint64_t swap64(uint64_t x) {
+  return (static_cast<uint64_t>(swap32(static_cast<uint32_t>(x))) << 32) |
+         swap32(static_cast<uint32_t>(x >> 32));
+}
+
+static inline Hash128Value mult64to128(uint64_t a, uint64_t b) {
+#if defined(__SIZEOF_INT128__)
+  __extension__ using uint128 = unsigned __int128;
+  const uint128 product = static_cast<uint128>(a) * b;
+
+  return Hash128Value{static_cast<uint64_t>(product),
+                      static_cast<uint64_t>(product >> 64)};
+#else
+  const uint64_t lo_lo = (a & 0xFFFFFFFF) * (b & 0xFFFFFFFF);
+  const uint64_t hi_lo = (a >> 32) * (b & 0xFFFFFFFF);
+  const uint64_t lo_hi = (a & 0xFFFFFFFF) * (b >> 32);
+  const uint64_t hi_hi = (a >> 32) * (b >> 32);
+  const uint64_t cross = (lo_lo >> 32) + (hi_lo & 0xFFFFFFFF) + lo_hi;
+  const uint64_t upper = (hi_lo >> 32) + (cross >> 32) + hi_hi;
+  const uint64_t lower = (cross << 32) | (lo_lo & 0xFFFFFFFF);
+
+  return Hash128Value{lower, upper};
+#endif
+}
+
+// Folds the product in registers; going through Hash128Value makes GCC spill
+// it to the stack, which adds a store-to-load round trip to every multiply.
+static inline uint64_t mul128_fold64(uint64_t a, uint64_t b) {
+#if defined(__SIZEOF_INT128__)
+  __extension__ using uint128 = unsigned __int128;
+  const uint128 product = static_cast<uint128>(a) * b;
+
+  return static_cast<uint64_t>(product) ^ static_cast<uint64_t>(product >> 64);
+#else
+  const Hash128Value product = mult64to128(a, b);
+
+  return product.lo ^ product.hi;
+#endif
+}
+
+static inline uint64_t xorshift64(uint64_t v, int shift) {
+  return v ^ (v >> shift);
+}
+
+static inline uint64_t xxh64_avalanche(uint64_t h) {
+  h ^= h >> 33;
+  h *= kPrime64_2;
+  h ^= h >> 29;
+  h *= kPrime64_3;
+  h ^= h >> 32;
+
+  return h;
+}
+
+static inline uint64_t xxh3_avalanche(uint64_t h) {
+  h = xorshift64(h, 37);
+  h *= kPrimeMx1;
+  h = xorshift64(h, 32);
+
+  return h;
+}
+
+static inline uint64_t rrmxmx(uint64_t h, uint64_t len) {
+  h ^= std::rotl(h, 49) ^ std::rotl(h, 24);
+  h *= kPrimeMx2;
+  h ^= (h >> 35) + len;
+  h *= kPrimeMx2;
+
+  return xorshift64(h, 28);
+}
+
+static inline uint64_t mix16(const char* in, const char* secret,
+                             uint64_t seed) {
+  return mul128_fold64(read64(in) ^ (read64(secret) + seed),
+                       read64(in + 8) ^ (read64(secret + 8) - seed));
+}
+
+static inline uint64_t hash64_1to3(const char* in, size_t len,
+                                   const char* secret, uint64_t seed) {
+  const uint8_t c1 = static_cast<uint8_t>(in[0]);
+  const uint8_t c2 = static_cast<uint8_t>(in[len >> 1]);
+  const uint8_t c3 = static_cast<uint8_t>(in[len - 1]);
+  const uint32_t combined = (static_cast<uint32_t>(c1) << 16) |
+                            (static_cast<uint32_t>(c2) << 24) |
+                            (static_cast<uint32_t>(c3) << 0) |
+                            (static_cast<uint32_t>(len) << 8);
+  const uint64_t bitflip = (read32(secret) ^ read32(secret + 4)) + seed;
+
+  return xxh64_avalanche(static_cast<uint64_t>(combined) ^ bitflip);
+}
+
+static inline uint64_t hash64_4to8(const char* in, size_t len,
+                                   const char* secret, uint64_t seed) {
+  seed ^= static_cast<uint64_t>(swap32(static_cast<uint32_t>(seed)))
+          << 32;
+
+  const uint32_t in1 = read32(in);
+  const uint32_t in2 = read32(in + len - 4);
+  const uint64_t bitflip = (read64(secret + 8) ^ read64(secret + 16)) - seed;
+  const uint64_t in64 = in2 + (static_cast<uint64_t>(in1) << 32);
+
+  return rrmxmx(in64 ^ bitflip, len);
+}
+
+static inline uint64_t hash64_9to16(const char* in, size_t len,
+                                    const char* secret, uint64_t seed) {
+  const uint64_t bitflip1 = (read64(secret + 24) ^ read64(secret + 32)) + seed;
+  const uint64_t bitflip2 = (read64(secret + 40) ^ read64(secret + 48)) - seed;
+  const uint64_t in_lo = read64(in) ^ bitflip1;
+  const uint64_t in_hi = read64(in + len - 8) ^ bitflip2;
+  const uint64_t acc =
+      len + swap64(in_lo) + in_hi + mul128_fold64(in_lo, in_hi);
+
+  return xxh3_avalanche(acc);
+}
+
+static inline uint64_t hash64_0to16(const char* in, size_t len,
+                                    const char* secret, uint64_t seed) {
+  if (len > 8) return hash64_9to16(in, len, secret, seed);
+  if (len >= 4) return hash64_4to8(in, len, secret, seed);
+  if (len > 0) return hash64_1to3(in, len, secret, seed);
+
+  return xxh64_avalanche(seed ^ read64(secret + 56) ^ read64(secret + 64));
+}
+
+static inline uint64_t hash64_17to128(const char* in, size_t len,
+                                      const char* secret, uint64_t seed) {
+  uint64_t acc = len * kPrime64_1;
+
+  if (len > 32) {
+    if (len > 64) {
+      if (len > 96) {
+        acc += mix16(in + 48, secret + 96, seed);
+        acc += mix16(in + len - 64, secret + 112, seed);
+      }
+
+      acc += mix16(in + 32, secret + 64, seed);
+      acc += mix16(in + len - 48, secret + 80, seed);
+    }
+
+    acc += mix16(in + 16, secret + 32, seed);
+    acc += mix16(in + len - 32, secret + 48, seed);
+  }
+
+  acc += mix16(in + 0, secret + 0, seed);
+  acc += mix16(in + len - 16, secret + 16, seed);
+
+  return xxh3_avalanche(acc);
+}
+
+static uint64_t hash64_129to240(const char* in, size_t len,
+                                const char* secret, uint64_t seed) {
+  const size_t num_rounds = len / 16;
+  uint64_t acc = len * kPrime64_1;
+
+  for (size_t i = 0; i < 8; ++i)
+    acc += mix16(in + 16 * i, secret + 16 * i, seed);
+
+  acc = xxh3_avalanche(acc);
+
+  for (size_t i = 8; i < num_rounds; ++i)
+    acc += mix16(in + 16 * i, secret + 16 * (i - 8) + kMidSizeStartOffset,
+                 seed);
+
+  // Last bytes
+  acc += mix16(in + len - 16, secret + kSecretSizeMin - kMidSizeLastOffset,
+               seed);
+
+  return xxh3_avalanche(acc);
+}
+
+// Long inputs: 8 accumulators consume 64-byte stripes, mixing in a window of
+// the secret that slides by 8 bytes per stripe, and are scrambled at the end
+// of every block of (kSecretSize - kStripeLen) / 8 stripes.
+
+// The SSE2 versions, always available on x86-64, compute the same values
+// two accumulators at a time. `acc` must be 16-byte aligned.
+
+static inline void accumulate_512(uint64_t* acc, const char* in,
+                                  const char* secret) {
+#if defined(__SSE2__)
+  // Load and store through the intrinsics: `acc` is also read as uint64_t,
+  // and plain __m128i dereferences would break strict aliasing.
+  auto* xacc = reinterpret_cast<__m128i*>(acc);
+
+  for (size_t i = 0; i < kStripeLen / sizeof(__m128i); ++i) {
+    const __m128i data =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(in) + i);
+    const __m128i key =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(secret) + i);
+    const __m128i data_key = _mm_xor_si128(data, key);
+    // (key & 0xFFFFFFFF) * (key >> 32) in each 64-bit lane.
+    const __m128i product = _mm_mul_epu32(
+        data_key, _mm_shuffle_epi32(data_key, _MM_SHUFFLE(0, 3, 0, 1)));
+    // acc[i ^ 1] += data
+    const __m128i data_swap =
+        _mm_shuffle_epi32(data, _MM_SHUFFLE(1, 0, 3, 2));
+    const __m128i sum = _mm_add_epi64(_mm_load_si128(xacc + i), data_swap);
+    _mm_store_si128(xacc + i, _mm_add_epi64(product, sum));
+  }
+#else
+  for (size_t i = 0; i < kAccNb; ++i) {
+    const uint64_t data = read64(in + 8 * i);
+    const uint64_t key = data ^ read64(secret + 8 * i);
+    acc[i ^ 1] += data;
+    acc[i] += (key & 0xFFFFFFFF) * (key >> 32);
+  }
+#endif
+}
+
+static inline void accumulate(uint64_t* acc, const char* in,
+                              const char* secret, size_t num_stripes) {
+  for (size_t n = 0; n < num_stripes; ++n)
+    accumulate_512(acc, in + n * kStripeLen, secret + n * kSecretConsumeRate);
+}
+
+static inline void scramble_acc(uint64_t* acc, const char* secret) {
+#if defined(__SSE2__)
+  auto* xacc = reinterpret_cast<__m128i*>(acc);
+  const __m128i prime = _mm_set1_epi32(static_cast<int>(kPrime32_1));
+
+  for (size_t i = 0; i < kStripeLen / sizeof(__m128i); ++i) {
+    const __m128i v = _mm_load_si128(xacc + i);
+    const __m128i a = _mm_xor_si128(v, _mm_srli_epi64(v, 47));
+    const __m128i key =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(secret) + i);
+    const __m128i data_key = _mm_xor_si128(a, key);
+    // 64x32-bit multiply from two 32x32-bit ones.
+    const __m128i product_lo = _mm_mul_epu32(data_key, prime);
+    const __m128i product_hi = _mm_mul_epu32(
+        _mm_shuffle_epi32(data_key, _MM_SHUFFLE(0, 3, 0, 1)), prime);
+    _mm_store_si128(xacc + i,
+                    _mm_add_epi64(product_lo, _mm_slli_epi64(product_hi, 32)));
+  }
+#else
+  for (size_t i = 0; i < kAccNb; ++i) {
+    uint64_t a = xorshift64(acc[i], 47);
+    a ^= read64(secret + 8 * i);
+    a *= kPrime32_1;
+    acc[i] = a;
+  }
+#endif
+}
+
+static inline void init_acc(uint64_t* acc) {
+  static constexpr uint64_t kInitAcc[kAccNb] = {
+      kPrime32_3, kPrime64_1, kPrime64_2, kPrime64_3,
+      kPrime64_4, kPrime32_2, kPrime64_5, kPrime32_1};
+
+  std::copy_n(kInitAcc, kAccNb, acc);
+}
+
+static constexpr size_t kStripesPerBlock =
+    (kSecretSize - kStripeLen) / kSecretConsumeRate;
+static constexpr size_t kBlockLen = kStripeLen * kStripesPerBlock;
+
+static void hash_long_internal_loop(uint64_t* acc, const char* in, size_t len,
+                                    const char* secret) {
+  const size_t num_blocks = (len - 1) / kBlockLen;
+
+  for (size_t n = 0; n < num_blocks; ++n) {
+    accumulate(acc, in + n * kBlockLen, secret, kStripesPerBlock);
+    scramble_acc(acc, secret + kSecretSize - kStripeLen);
+  }
+
+  // Last partial block
+  const size_t num_stripes =
+      ((len - 1) - (kBlockLen * num_blocks)) / kStripeLen;
+  accumulate(acc, in + num_blocks * kBlockLen, secret, num_stripes);
+
+  // Last stripe
+  accumulate_512(acc, in + len - kStripeLen,
+                 secret + kSecretSize - kStripeLen - kSecretLastAccStart);
+}
+
+static uint64_t merge_accs(const uint64_t* acc, const char* secret,
+                           uint64_t start) {
+  uint64_t result = start;
+
+  for (size_t i = 0; i < 4; ++i)
+    result += mul128_fold64(acc[2 * i] ^ read64(secret + 16 * i),
+                            acc[2 * i + 1] ^ read64(secret + 16 * i + 8));
+
+  return xxh3_avalanche(result);
+}
+
+// The final mixes of inputs longer than kMidSizeMax bytes.
+static uint64_t merge_accs64(const uint64_t* acc, const char* secret,
+                             uint64_t len) {
+  return merge_accs(acc, secret + kSecretMergeAccsStart, len * kPrime64_1);
+}
+
+static Hash128Value merge_accs128(const uint64_t* acc, const char* secret,
+                                  uint64_t len) {
+  return Hash128Value{
+      merge_accs64(acc, secret, len),
+      merge_accs(acc, secret + kSecretSize - kStripeLen - kSecretMergeAccsStart,
+                 ~(len * kPrime64_2))};
+}
+
+// Seeded long inputs use the default secret with the seed added to its
+// 64-bit words.
+static void init_custom_secret(char* secret, uint64_t seed) {
+  for (size_t i = 0; i < kSecretSize / 16; ++i) {
+    const uint64_t lo = read64(default_secret() + 16 * i) + seed;
+    const uint64_t hi = read64(default_secret() + 16 * i + 8) - seed;
+
+    for (size_t b = 0; b < 8; ++b) {
+      secret[16 * i + b] = static_cast<char>(lo >> (8 * b));
+      secret[16 * i + 8 + b] = static_cast<char>(hi >> (8 * b));
+    }
+  }
+}
+
+static const char* long_secret(char* buf, uint64_t seed) {
+  if (seed == 0) return default_secret();
+
+  init_custom_secret(buf, seed);
+
+  return buf;
+}
+
+static uint64_t hash64_long(const char* in, size_t len, uint64_t seed) {
+  alignas(64) char buf[kSecretSize];
+  const char* secret = long_secret(buf, seed);
+  alignas(64) uint64_t acc[kAccNb];
+
+  init_acc(acc);
+  hash_long_internal_loop(acc, in, len, secret);
+
+  return merge_accs64(acc, secret, len);
+}
+
+uint64_t Hash64(const char* data, size_t n, uint64_t seed) {
+  const char* secret = default_secret();
+
+  if (n <= 16) return hash64_0to16(data, n, secret, seed);
+  if (n <= 128) return hash64_17to128(data, n, secret, seed);
+  if (n <= kMidSizeMax) return hash64_129to240(data, n, secret, seed);
+
+  return hash64_long(data, n, seed);
+}
+
+// Number of keys HashBatch() hashes side by side. Four independent chains of
+// 64x64->128 multiplies keep the multiplier busy on current x86 and ARM
+// cores; more only adds register pressure.
+static constexpr size_t kBatchLanes = 4;
+
+// How many keys ahead HashBatch() prefetches, so that keys scattered over
+// memory arrive by the time their lane gets to them.
+static constexpr size_t kBatchPrefetchDistance = 2 * kBatchLanes;
+
+// hash64_9to16() of kBatchLanes keys. The lanes are independent and free of
+// branches, so the core overlaps their multiplies.
+static inline void hash64_9to16_batch(const Slice* keys, const char* secret,
+                                      uint64_t* out) {
+  const uint64_t bitflip1 = read64(secret + 24) ^ read64(secret + 32);
+  const uint64_t bitflip2 = read64(secret + 40) ^ read64(secret + 48);
+
+  for (size_t i = 0; i < kBatchLanes; ++i) {
+    const char* in = keys[i].data();
+    const size_t len = keys[i].size();
+    const uint64_t in_lo = read64(in) ^ bitflip1;
+    const uint64_t in_hi = read64(in + len - 8) ^ bitflip2;
+
+    out[i] = xxh3_avalanche(len + swap64(in_lo) + in_hi +
+                            mul128_fold64(in_lo, in_hi));
+  }
+}
+
+// hash64_17to128() of kBatchLanes keys of 17 to 32 bytes.
+static inline void hash64_17to32_batch(const Slice* keys, const char* secret,
+                                       uint64_t* out) {
+  for (size_t i = 0; i < kBatchLanes; ++i) {
+    const char* in = keys[i].data();
+    const size_t len = keys[i].size();
+
+    out[i] = xxh3_avalanche(len * kPrime64_1 + mix16(in, secret, 0) +
+                            mix16(in + len - 16, secret + 16, 0));
+  }
+}
+
+static inline bool all_sizes_within(const Slice* keys, size_t lo, size_t hi) {
+  bool within = true;
+
+  // Non-short-circuiting, so that this compiles to compares and ands.
+  for (size_t i = 0; i < kBatchLanes; ++i)
+    within &= keys[i].size() - lo <= hi - lo;
+
+  return within;
+}
+
+// Hash64() with seed 0, with the short paths inlined.
+static inline uint64_t hash64_inline(const Slice& key, const char* secret) {
+  const char* in = key.data();
+  const size_t len = key.size();
+
+  if (len <= 16) return hash64_0to16(in, len, secret, 0);
+  if (len <= 128) return hash64_17to128(in, len, secret, 0);
+
+  return Hash64(in, len);
+}
+
+void HashBatch(const Slice* keys, size_t n, uint64_t* out) {
+  const char* secret = default_secret();
+  size_t i = 0;
+
+  for (; i + kBatchLanes <= n; i += kBatchLanes) {
+    if (i + kBatchPrefetchDistance + kBatchLanes <= n) {
+      for (size_t j = 0; j < kBatchLanes; ++j)
+        __builtin_prefetch(keys[i + kBatchPrefetchDistance + j].data());
+    }
+
+    const Slice* batch = keys + i;
+    if (all_sizes_within(batch, 17, 32)) {
+      hash64_17to32_batch(batch, secret, out + i);
+    } else if (all_sizes_within(batch, 9, 16)) {
+      hash64_9to16_batch(batch, secret, out + i);
+    } else {
+      for (size_t j = 0; j < kBatchLanes; ++j)
+        out[i + j] = hash64_inline(batch[j], secret);
+    }
+  }
+
+  for (; i < n; ++i) out[i] = hash64_inline(keys[i], secret);
+}
+
+static inline Hash128Value hash128_1to3(const char* in, size_t len,
+                                        const char* secret, uint64_t seed) {
+  const uint8_t c1 = static_cast<uint8_t>(in[0]);
+  const uint8_t c2 = static_cast<uint8_t>(in[len >> 1]);
+  const uint8_t c3 = static_cast<uint8_t>(in[len - 1]);
+  const uint32_t combinedl = (static_cast<uint32_t>(c1) << 16) |
+                             (static_cast<uint32_t>(c2) << 24) |
+                             (static_cast<uint32_t>(c3) << 0) |
+                             (static_cast<uint32_t>(len) << 8);
+  const uint32_t combinedh = std::rotl(swap32(combinedl), 13);
+  const uint64_t bitflipl = (read32(secret) ^ read32(secret + 4)) + seed;
+  const uint64_t bitfliph = (read32(secret + 8) ^ read32(secret + 12)) - seed;
+
+  return Hash128Value{xxh64_avalanche(combinedl ^ bitflipl),
+                      xxh64_avalanche(combinedh ^ bitfliph)};
+}
+
+static inline Hash128Value hash128_4to8(const char* in, size_t len,
+                                        const char* secret, uint64_t seed) {
+  seed ^= static_cast<uint64_t>(swap32(static_cast<uint32_t>(seed)))
+          << 32;
+
+  const uint32_t in_lo = read32(in);
+  const uint32_t in_hi = read32(in + len - 4);
+  const uint64_t in64 = in_lo + (static_cast<uint64_t>(in_hi) << 32);
+  const uint64_t bitflip = (read64(secret + 16) ^ read64(secret + 24)) + seed;
+  const uint64_t keyed = in64 ^ bitflip;
+
+  // Shift len to the left to ensure it is even, this avoids even multiplies.
+  Hash128Value m = mult64to128(keyed, kPrime64_1 + (len << 2));
+  m.hi += (m.lo << 1);
+  m.lo ^= (m.hi >> 3);
+  m.lo = xorshift64(m.lo, 35);
+  m.lo *= kPrimeMx2;
+  m.lo = xorshift64(m.lo, 28);
+  m.hi = xxh3_avalanche(m.hi);
+
+  return m;
+}
+
+static inline Hash128Value hash128_9to16(const char* in, size_t len,
+                                         const char* secret, uint64_t seed) {
+  const uint64_t bitflipl = (read64(secret + 32) ^ read64(secret + 40)) - seed;
+  const uint64_t bitfliph = (read64(secret + 48) ^ read64(secret + 56)) + seed;
+  const uint64_t in_lo = read64(in);
+  uint64_t in_hi = read64(in + len - 8);
+
+  Hash128Value m = mult64to128(in_lo ^ in_hi ^ bitflipl, kPrime64_1);
+  m.lo += static_cast<uint64_t>(len - 1) << 54;
+  in_hi ^= bitfliph;
+  m.hi += in_hi + (in_hi & 0xFFFFFFFF) * (kPrime32_2 - 1);
+  m.lo ^= swap64(m.hi);
+
+  Hash128Value h = mult64to128(m.lo, kPrime64_2);
+  h.hi += m.hi * kPrime64_2;
+  h.lo = xxh3_avalanche(h.lo);
+  h.hi = xxh3_avalanche(h.hi);
+
+  return h;
+}
+
+static inline Hash128Value hash128_0to16(const char* in, size_t len,
+                                         const char* secret, uint64_t seed) {
+  if (len > 8) return hash128_9to16(in, len, secret, seed);
+  if (len >= 4) return hash128_4to8(in, len, secret, seed);
+  if (len > 0) return hash128_1to3(in, len, secret, seed);
+
+  return Hash128Value{
+      xxh64_avalanche(seed ^ read64(secret + 64) ^ read64(secret + 72)),
+      xxh64_avalanche(seed ^ read64(secret + 80) ^ read64(secret + 88))};
+}
+
+static inline Hash128Value mix32(Hash128Value acc, const char* in1,
+                                 const char* in2, const char* secret,
+                                 uint64_t seed) {
+  acc.lo += mix16(in1, secret, seed);
+  acc.lo ^= read64(in2) + read64(in2 + 8);
+  acc.hi += mix16(in2, secret + 16, seed);
+  acc.hi ^= read64(in1) + read64(in1 + 8);
+
+  return acc;
+}
+
+static inline Hash128Value hash128_finish(Hash128Value acc, size_t len,
+                                          uint64_t seed) {
+  Hash128Value h;
+  h.lo = acc.lo + acc.hi;
+  h.hi = (acc.lo * kPrime64_1) + (acc.hi * kPrime64_4) +
+         ((len - seed) * kPrime64_2);
+  h.lo = xxh3_avalanche(h.lo);
+  h.hi = 0 - xxh3_avalanche(h.hi);
+
+  return h;
+}
+
+static Hash128Value hash128_17to128(const char* in, size_t len,
+                                    const char* secret, uint64_t seed) {
+  Hash128Value acc{len * kPrime64_1, 0};
+
+  if (len > 32) {
+    if (len > 64) {
+      if (len > 96)
+        acc = mix32(acc, in + 48, in + len - 64, secret + 96, seed);
+
+      acc = mix32(acc, in + 32, in + len - 48, secret + 64, seed);
+    }
+
+    acc = mix32(acc, in + 16, in + len - 32, secret + 32, seed);
+  }
+
+  acc = mix32(acc, in, in + len - 16, secret, seed);
+
+  return hash128_finish(acc, len, seed);
+}
+
+static Hash128Value hash128_129to240(const char* in, size_t len,
+                                     const char* secret, uint64_t seed) {
+  const size_t num_rounds = len / 32;
+  Hash128Value acc{len * kPrime64_1, 0};
+
+  for (size_t i = 0; i < 4; ++i)
+    acc = mix32(acc, in + 32 * i, in + 32 * i + 16, secret + 32 * i, seed);
+
+  acc.lo = xxh3_avalanche(acc.lo);
+  acc.hi = xxh3_avalanche(acc.hi);
+
+  for (size_t i = 4; i < num_rounds; ++i)
+    acc = mix32(acc, in + 32 * i, in + 32 * i + 16,
+                secret + kMidSizeStartOffset + 32 * (i - 4), seed);
+
+  // Last bytes
+  acc = mix32(acc, in + len - 16, in + len - 32,
+              secret + kSecretSizeMin - kMidSizeLastOffset - 16, 0 - seed);
+
+  return hash128_finish(acc, len, seed);
+}
+
+static Hash128Value hash128_long(const char* in, size_t len, uint64_t seed) {
+  alignas(64) char buf[kSecretSize];
+  const char* secret = long_secret(buf, seed);
+  alignas(64) uint64_t acc[kAccNb];
+
+  init_acc(acc);
+  hash_long_internal_loop(acc, in, len, secret);
+
+  return merge_accs128(acc, secret, len);
+}
+
+Hash128Value Hash128(const char* data, size_t n, uint64_t seed) {
+  const char* secret = default_secret();
+
+  if (n <= 16) return hash128_0to16(data, n, secret, seed);
+  if (n <= 128) return hash128_17to128(data, n, secret, seed);
+  if (n <= kMidSizeMax) return hash128_129to240(data, n, secret, seed);
+
+  return hash128_long(data, n, seed);
+}
+
+static_assert(StreamingHash::kNumAccs == kAccNb);
+static_assert(StreamingHash::kSecretSize == kSecretSize);
+static_assert(StreamingHash::kBufferSize % kStripeLen == 0);
+static_assert(StreamingHash::kBufferSize > kMidSizeMax);
+
+static constexpr size_t kBufferStripes =
+    StreamingHash::kBufferSize / kStripeLen;
+
+// Accumulates `num_stripes` stripes at `in` into `acc`, continuing the block
+// that `*stripes_so_far` stripes of have already been accumulated, and
+// scrambling `acc` whenever a block fills up.
+static void consume_stripes(uint64_t* acc, size_t* stripes_so_far,
+                            const char* in, size_t num_stripes,
+                            const char* secret) {
+  const size_t stripes_to_end = kStripesPerBlock - *stripes_so_far;
+
+  if (num_stripes < stripes_to_end) {
+    accumulate(acc, in, secret + *stripes_so_far * kSecretConsumeRate,
+               num_stripes);
+    *stripes_so_far += num_stripes;
+    return;
+  }
+
+  accumulate(acc, in, secret + *stripes_so_far * kSecretConsumeRate,
+             stripes_to_end);
+  scramble_acc(acc, secret + kSecretSize - kStripeLen);
+  accumulate(acc, in + stripes_to_end * kStripeLen, secret,
+             num_stripes - stripes_to_end);
+  *stripes_so_far = num_stripes - stripes_to_end;
+}
+
+void StreamingHash::Init(uint64_t seed) {
+  init_acc(acc_);
+  if (seed != 0) init_custom_secret(secret_, seed);
+  seed_ = seed;
+  total_len_ = 0;
+  buffered_ = 0;
+  stripes_so_far_ = 0;
+}
+
+const char* StreamingHash::secret() const {
+  return seed_ == 0 ? default_secret() : secret_;
+}
+
+void StreamingHash::Update(const char* data, size_t n) {
+  const char* limit = data + n;
+  total_len_ += n;
+
+  // The buffer always keeps at least one byte back, since the last stripe
+  // is accumulated differently and only Final*() knows which one it is.
+  if (n <= kBufferSize - buffered_) {
+    memcpy(buffer_ + buffered_, data, n);
+    buffered_ += n;
+    return;
+  }
+
+  if (buffered_ > 0) {
+    const size_t k = kBufferSize - buffered_;
+    memcpy(buffer_ + buffered_, data, k);
+    data += k;
+    consume_stripes(acc_, &stripes_so_far_, buffer_, kBufferStripes,
+                    secret());
+    buffered_ = 0;
+  }
+
+  // Large inputs are consumed in place, with no copy.
+  if (static_cast<size_t>(limit - data) > kBufferSize) {
+    do {
+      consume_stripes(acc_, &stripes_so_far_, data, kBufferStripes, secret());
+      data += kBufferSize;
+    } while (static_cast<size_t>(limit - data) > kBufferSize);
+
+    // Final*() may need the end of the last consumed stripe.
+    memcpy(buffer_ + kBufferSize - kStripeLen, data - kStripeLen, kStripeLen);
+  }
+
+  memcpy(buffer_, data, limit - data);
+  buffered_ = limit - data;
+}
+
+void StreamingHash::Update(const Slice& data) {
+  Update(data.data(), data.size());
+}
+
+void StreamingHash::Update(const SliceParts& parts) {
+  for (int i = 0; i < parts.num_parts; ++i) Update(parts.parts[i]);
+}
+
+void StreamingHash::FinalAccs(uint64_t* acc) const {
+  std::copy_n(acc_, kAccNb, acc);
+
+  if (buffered_ >= kStripeLen) {
+    size_t stripes_so_far = stripes_so_far_;
+    consume_stripes(acc, &stripes_so_far, buffer_,
+                    (buffered_ - 1) / kStripeLen, secret());
+    accumulate_512(acc, buffer_ + buffered_ - kStripeLen,
+                   secret() + kSecretSize - kStripeLen - kSecretLastAccStart);
+  } else {
+    // The last stripe starts in the previous, already consumed stripes.
+    char last_stripe[kStripeLen];
+    const size_t catchup = kStripeLen - buffered_;
+    memcpy(last_stripe, buffer_ + kBufferSize - catchup, catchup);
+    memcpy(last_stripe + catchup, buffer_, buffered_);
+    accumulate_512(acc, last_stripe,
+                   secret() + kSecretSize - kStripeLen - kSecretLastAccStart);
+  }
+}
+
+uint64_t StreamingHash::Final64() const {
+  // Short inputs are still all in the buffer.
+  if (total_len_ <= kMidSizeMax) return Hash64(buffer_, total_len_, seed_);
+
+  alignas(64) uint64_t acc[kAccNb];
+  FinalAccs(acc);
+
+  return merge_accs64(acc, secret(), total_len_);
+}
+
+Hash128Value StreamingHash::Final128() const {
+  if (total_len_ <= kMidSizeMax) return Hash128(buffer_, total_len_, seed_);
+
+  alignas(64) uint64_t acc[kAccNb];
+  FinalAccs(acc);
+
+  return merge_accs128(acc, secret(), total_len_);
+}
+
+}  // namespace badger
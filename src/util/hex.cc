@@ -0,0 +1,306 @@
+#include "cpp-badger/util/hex.hh"
+
+#include <array>
+#include <cstdint>
+
+#ifdef BADGER_HAVE_X86_HEX
+#include <immintrin.h>
+#endif
+
+namespace badger {
+
+namespace {
+
+constexpr char kHexDigits[] = "0123456789abcdef";
+
+/// Maps every character to its digit value, or kInvalidDigit.
+constexpr uint8_t kInvalidDigit = 0xff;
+
+constexpr std::array<uint8_t, 256> MakeDigitTable() {
+  std::array<uint8_t, 256> table{};
+
+  for (auto& v : table) v = kInvalidDigit;
+  for (int i = 0; i < 10; ++i) table['0' + i] = static_cast<uint8_t>(i);
+  for (int i = 0; i < 6; ++i) {
+    table['a' + i] = static_cast<uint8_t>(10 + i);
+    table['A' + i] = static_cast<uint8_t>(10 + i);
+  }
+
+  return table;
+}
+
+constexpr std::array<uint8_t, 256> kDigitValues = MakeDigitTable();
+
+HexEncodeFunction SelectEncodeKernel() {
+#ifdef BADGER_HAVE_X86_HEX
+  if (__builtin_cpu_supports("avx2")) return HexEncodeAVX2;
+
+  return HexEncodeSSE2;
+#else
+  return HexEncodeScalar;
+#endif
+}
+
+HexDecodeFunction SelectDecodeKernel() {
+#ifdef BADGER_HAVE_X86_HEX
+  if (__builtin_cpu_supports("avx2")) return HexDecodeAVX2;
+
+  return HexDecodeSSE2;
+#else
+  return HexDecodeScalar;
+#endif
+}
+
+void ResolveAndHexEncode(const char* src, size_t n, char* dst) {
+  HexEncodeFunction kernel = SelectEncodeKernel();
+  internal::hex_encode.store(kernel, std::memory_order_relaxed);
+
+  kernel(src, n, dst);
+}
+
+bool ResolveAndHexDecode(const char* src, size_t n, char* dst) {
+  HexDecodeFunction kernel = SelectDecodeKernel();
+  internal::hex_decode.store(kernel, std::memory_order_relaxed);
+
+  return kernel(src, n, dst);
+}
+
+}  // namespace
+
+namespace internal {
+
+std::atomic<HexEncodeFunction> hex_encode{ResolveAndHexEncode};
+std::atomic<HexDecodeFunction> hex_decode{ResolveAndHexDecode};
+
+}  // namespace internal
+
+void HexEncodeScalar(const char* src, size_t n, char* dst) {
+  for (size_t i = 0; i < n; ++i) {
+    const uint8_t c = static_cast<uint8_t>(src[i]);
+    dst[2 * i] = kHexDigits[c >> 4];
+    dst[2 * i + 1] = kHexDigits[c & 0xf];
+  }
+}
+
+bool HexDecodeScalar(const char* src, size_t n, char* dst) {
+  if (n % 2 != 0) return false;
+
+  // Accumulate instead of branching per digit; invalid digits set high bits.
+  uint8_t invalid = 0;
+
+  for (size_t i = 0; i < n; i += 2) {
+    const uint8_t hi = kDigitValues[static_cast<uint8_t>(src[i])];
+    const uint8_t lo = kDigitValues[static_cast<uint8_t>(src[i + 1])];
+    invalid |= hi | lo;
+    dst[i / 2] = static_cast<char>((hi << 4) | lo);
+  }
+
+  return (invalid & 0xf0) == 0;
+}
+
+#ifdef BADGER_HAVE_X86_HEX
+
+// Like the mismatch kernels, the SIMD kernels finish with one block that
+// overlaps the previous one and ends exactly at the end of the input. Both
+// encodings are position independent, so the overlap is rewritten with the
+// same bytes.
+
+namespace {
+
+/// Maps nibbles to lowercase digits: v + '0', plus 'a' - '0' - 10 if v > 9.
+inline __m128i NibblesToDigits(__m128i v) {
+  const __m128i letter = _mm_cmpgt_epi8(v, _mm_set1_epi8(9));
+
+  return _mm_add_epi8(
+      _mm_add_epi8(v, _mm_set1_epi8('0')),
+      _mm_and_si128(letter, _mm_set1_epi8('a' - '0' - 10)));
+}
+
+inline void Encode16(const char* src, char* dst) {
+  const __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+  const __m128i mask = _mm_set1_epi8(0x0f);
+  const __m128i hi = _mm_and_si128(_mm_srli_epi16(x, 4), mask);
+  const __m128i lo = _mm_and_si128(x, mask);
+
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(dst),
+                   NibblesToDigits(_mm_unpacklo_epi8(hi, lo)));
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 16),
+                   NibblesToDigits(_mm_unpackhi_epi8(hi, lo)));
+}
+
+/// Maps 16 digits to their values and clears `*valid` bits for non-digits.
+/// Signed compares reject bytes >= 0x80, which are negative.
+inline __m128i DigitsToNibbles(__m128i c, __m128i* valid) {
+  const __m128i is_digit = _mm_and_si128(_mm_cmpgt_epi8(c, _mm_set1_epi8('/')),
+                                         _mm_cmplt_epi8(c, _mm_set1_epi8(':')));
+  const __m128i l = _mm_or_si128(c, _mm_set1_epi8(0x20));
+  const __m128i is_letter =
+      _mm_and_si128(_mm_cmpgt_epi8(l, _mm_set1_epi8('a' - 1)),
+                    _mm_cmplt_epi8(l, _mm_set1_epi8('g')));
+
+  *valid = _mm_and_si128(*valid, _mm_or_si128(is_digit, is_letter));
+
+  return _mm_or_si128(
+      _mm_and_si128(is_digit, _mm_sub_epi8(c, _mm_set1_epi8('0'))),
+      _mm_and_si128(is_letter, _mm_sub_epi8(l, _mm_set1_epi8('a' - 10))));
+}
+
+/// Combines pairs of nibbles, the first one high, into 16-bit lanes.
+inline __m128i PackNibblePairs(__m128i v) {
+  const __m128i hi = _mm_and_si128(v, _mm_set1_epi16(0x00ff));
+  const __m128i lo = _mm_srli_epi16(v, 8);
+
+  return _mm_or_si128(_mm_slli_epi16(hi, 4), lo);
+}
+
+/// \return false if the 32 characters at `src` are not all hex digits.
+inline bool Decode32(const char* src, char* dst) {
+  __m128i valid = _mm_set1_epi8(-1);
+  const __m128i v0 = DigitsToNibbles(
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(src)), &valid);
+  const __m128i v1 = DigitsToNibbles(
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 16)), &valid);
+
+  _mm_storeu_si128(
+      reinterpret_cast<__m128i*>(dst),
+      _mm_packus_epi16(PackNibblePairs(v0), PackNibblePairs(v1)));
+
+  return _mm_movemask_epi8(valid) == 0xffff;
+}
+
+__attribute__((target("avx2"))) inline __m256i NibblesToDigits(__m256i v) {
+  const __m256i letter = _mm256_cmpgt_epi8(v, _mm256_set1_epi8(9));
+
+  return _mm256_add_epi8(
+      _mm256_add_epi8(v, _mm256_set1_epi8('0')),
+      _mm256_and_si256(letter, _mm256_set1_epi8('a' - '0' - 10)));
+}
+
+__attribute__((target("avx2"))) inline void Encode32(const char* src,
+                                                     char* dst) {
+  const __m256i x =
+      _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src));
+  const __m256i mask = _mm256_set1_epi8(0x0f);
+  const __m256i hi = _mm256_and_si256(_mm256_srli_epi16(x, 4), mask);
+  const __m256i lo = _mm256_and_si256(x, mask);
+
+  // Unpacking works within 128-bit lanes: `a` holds bytes 0-7 and 16-23,
+  // `b` bytes 8-15 and 24-31.
+  const __m256i a = NibblesToDigits(_mm256_unpacklo_epi8(hi, lo));
+  const __m256i b = NibblesToDigits(_mm256_unpackhi_epi8(hi, lo));
+
+  _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst),
+                      _mm256_permute2x128_si256(a, b, 0x20));
+  _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + 32),
+                      _mm256_permute2x128_si256(a, b, 0x31));
+}
+
+__attribute__((target("avx2"))) inline __m256i DigitsToNibbles(
+    __m256i c, __m256i* valid) {
+  const __m256i is_digit =
+      _mm256_and_si256(_mm256_cmpgt_epi8(c, _mm256_set1_epi8('/')),
+                       _mm256_cmpgt_epi8(_mm256_set1_epi8(':'), c));
+  const __m256i l = _mm256_or_si256(c, _mm256_set1_epi8(0x20));
+  const __m256i is_letter =
+      _mm256_and_si256(_mm256_cmpgt_epi8(l, _mm256_set1_epi8('a' - 1)),
+                       _mm256_cmpgt_epi8(_mm256_set1_epi8('g'), l));
+
+  *valid = _mm256_and_si256(*valid, _mm256_or_si256(is_digit, is_letter));
+
+  return _mm256_or_si256(
+      _mm256_and_si256(is_digit, _mm256_sub_epi8(c, _mm256_set1_epi8('0'))),
+      _mm256_and_si256(is_letter,
+                       _mm256_sub_epi8(l, _mm256_set1_epi8('a' - 10))));
+}
+
+__attribute__((target("avx2"))) inline __m256i PackNibblePairs(__m256i v) {
+  const __m256i hi = _mm256_and_si256(v, _mm256_set1_epi16(0x00ff));
+  const __m256i lo = _mm256_srli_epi16(v, 8);
+
+  return _mm256_or_si256(_mm256_slli_epi16(hi, 4), lo);
+}
+
+__attribute__((target("avx2"))) inline bool Decode64(const char* src,
+                                                     char* dst) {
+  __m256i valid = _mm256_set1_epi8(-1);
+  const __m256i v0 = DigitsToNibbles(
+      _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src)), &valid);
+  const __m256i v1 = DigitsToNibbles(
+      _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + 32)), &valid);
+
+  // Packing also works within lanes; restore the order of the 64-bit
+  // quarters afterwards.
+  const __m256i packed =
+      _mm256_packus_epi16(PackNibblePairs(v0), PackNibblePairs(v1));
+  _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst),
+                      _mm256_permute4x64_epi64(packed, 0xd8));
+
+  return static_cast<uint32_t>(_mm256_movemask_epi8(valid)) == 0xffffffff;
+}
+
+}  // namespace
+
+void HexEncodeSSE2(const char* src, size_t n, char* dst) {
+  if (n < 16) return HexEncodeScalar(src, n, dst);
+
+  size_t i = 0;
+
+  for (; i + 16 <= n; i += 16) Encode16(src + i, dst + 2 * i);
+
+  if (i < n) Encode16(src + n - 16, dst + 2 * (n - 16));
+}
+
+bool HexDecodeSSE2(const char* src, size_t n, char* dst) {
+  if (n < 32) return HexDecodeScalar(src, n, dst);
+  if (n % 2 != 0) return false;
+
+  bool ok = true;
+  size_t i = 0;
+
+  for (; i + 32 <= n; i += 32) ok &= Decode32(src + i, dst + i / 2);
+
+  if (i < n) ok &= Decode32(src + n - 32, dst + (n - 32) / 2);
+
+  return ok;
+}
+
+__attribute__((target("avx2"))) void HexEncodeAVX2(const char* src, size_t n,
+                                                   char* dst) {
+  if (n < 32) return HexEncodeSSE2(src, n, dst);
+
+  size_t i = 0;
+
+  for (; i + 32 <= n; i += 32) Encode32(src + i, dst + 2 * i);
+
+  if (i < n) Encode32(src + n - 32, dst + 2 * (n - 32));
+}
+
+__attribute__((target("avx2"))) bool HexDecodeAVX2(const char* src, size_t n,
+                                                   char* dst) {
+  if (n < 64) return HexDecodeSSE2(src, n, dst);
+  if (n % 2 != 0) return false;
+
+  bool ok = true;
+  size_t i = 0;
+
+  for (; i + 64 <= n; i += 64) ok &= Decode64(src + i, dst + i / 2);
+
+  if (i < n) ok &= Decode64(src + n - 64, dst + (n - 64) / 2);
+
+  return ok;
+}
+
+#endif  // BADGER_HAVE_X86_HEX
+
+const char* HexKernelName() {
+  HexEncodeFunction kernel = SelectEncodeKernel();
+
+#ifdef BADGER_HAVE_X86_HEX
+  if (kernel == HexEncodeAVX2) return "avx2";
+  if (kernel == HexEncodeSSE2) return "sse2";
+#endif
+
+  return kernel == HexEncodeScalar ? "scalar" : "unknown";
+}
+
+}  // namespace badger
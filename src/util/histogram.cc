@@ -0,0 +1,57 @@
+#include "cpp-badger/util/histogram.hh"
+
+#include <cinttypes>
+#include <cstdio>
+
+namespace badger {
+
+void Histogram::Merge(const Histogram& other) {
+  for (int i = 0; i < kNumBuckets; ++i) buckets_[i] += other.buckets_[i];
+  count_ += other.count_;
+  sum_ += other.sum_;
+  min_ = std::min(min_, other.min_);
+  max_ = std::max(max_, other.max_);
+}
+
+double Histogram::Percentile(double p) const {
+  if (count_ == 0) return 0;
+
+  const double threshold = static_cast<double>(count_) * p / 100;
+  uint64_t cumulative = 0;
+
+  for (int i = 0; i < kNumBuckets; ++i) {
+    if (buckets_[i] == 0) continue;
+
+    const uint64_t before = cumulative;
+    cumulative += buckets_[i];
+    if (static_cast<double>(cumulative) < threshold) continue;
+
+    // Interpolate within the bucket, whose values are assumed to be spread
+    // evenly. The last bucket's upper end, 2^64, wraps to 0 in BucketLow().
+    const auto low = static_cast<double>(BucketLow(i));
+    const double high = i + 1 < kNumBuckets
+                            ? static_cast<double>(BucketLow(i + 1))
+                            : 0x1p64;
+    const double fraction = (threshold - static_cast<double>(before)) /
+                            static_cast<double>(buckets_[i]);
+
+    return std::clamp(low + (high - low) * fraction,
+                      static_cast<double>(Min()), static_cast<double>(max_));
+  }
+
+  return static_cast<double>(max_);
+}
+
+std::string Histogram::ToString() const {
+  char buf[256];
+
+  snprintf(buf, sizeof(buf),
+           "count %" PRIu64 " avg %.1f min %" PRIu64 " max %" PRIu64
+           " p50 %.1f p99 %.1f p99.9 %.1f",
+           count_, Average(), Min(), max_, Percentile(50), Percentile(99),
+           Percentile(99.9));
+
+  return buf;
+}
+
+}  // namespace badger
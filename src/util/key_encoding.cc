@@ -0,0 +1,63 @@
+#include "cpp-badger/util/key_encoding.hh"
+
+namespace badger {
+
+namespace {
+
+/// \return The position of the first escape byte in `input`, or nullptr.
+const char* FindEscape(const Slice& input, const char* from) {
+  return static_cast<const char*>(
+      memchr(from, internal::kEscape, input.data() + input.size() - from));
+}
+
+}  // namespace
+
+bool GetOrderedString(Slice* input, std::string* value) {
+  const char* p = input->data();
+  const char* limit = p + input->size();
+
+  value->clear();
+
+  while (true) {
+    const char* escape = FindEscape(*input, p);
+
+    if (escape == nullptr || escape + 1 == limit) return false;
+
+    value->append(p, escape - p);
+
+    if (escape[1] == internal::kTerminator) {
+      input->RemovePrefix(escape + 2 - input->data());
+      return true;
+    }
+
+    if (escape[1] != internal::kEscapedZero) return false;
+
+    value->push_back('\0');
+    p = escape + 2;
+  }
+}
+
+bool GetOrderedString(Slice* input, PinnableSlice* value) {
+  const char* escape = FindEscape(*input, input->data());
+
+  if (escape == nullptr || escape + 1 == input->data() + input->size())
+    return false;
+
+  if (escape[1] == internal::kTerminator) {
+    // No embedded zeros: the encoded bytes are the string itself.
+    const size_t size = escape - input->data();
+    value->PinSlice(Slice(input->data(), size),
+                    static_cast<Cleanable*>(nullptr));
+    input->RemovePrefix(size + 2);
+
+    return true;
+  }
+
+  if (!GetOrderedString(input, value->GetSelf())) return false;
+
+  value->PinSelf();
+
+  return true;
+}
+
+}  // namespace badger
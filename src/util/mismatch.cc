@@ -0,0 +1,157 @@
+#include "cpp-badger/util/mismatch.hh"
+
+#ifdef BADGER_HAVE_X86_MISMATCH
+#include <immintrin.h>
+#endif
+
+namespace badger {
+
+using internal::FindFirstMismatchShort;
+using internal::FirstNonZeroByte;
+using internal::Load;
+
+namespace {
+
+MismatchFunction SelectKernel() {
+#ifdef BADGER_HAVE_X86_MISMATCH
+  if (__builtin_cpu_supports("avx2")) return FindFirstMismatchAVX2;
+
+  return FindFirstMismatchSSE2;
+#else
+  return FindFirstMismatchScalar;
+#endif
+}
+
+size_t ResolveAndFindFirstMismatch(const char* a, const char* b, size_t n) {
+  MismatchFunction kernel = SelectKernel();
+  internal::find_first_mismatch.store(kernel, std::memory_order_relaxed);
+
+  return kernel(a, b, n);
+}
+
+}  // namespace
+
+namespace internal {
+
+std::atomic<MismatchFunction> find_first_mismatch{ResolveAndFindFirstMismatch};
+
+}  // namespace internal
+
+// The kernels below finish with one block that overlaps the previous one and
+// ends exactly at n. Bytes in the overlap are already known to be equal, so
+// the first difference in that block is the first difference overall.
+
+size_t FindFirstMismatchScalar(const char* a, const char* b, size_t n) {
+  if (n < 16) return FindFirstMismatchShort(a, b, n);
+
+  size_t i = 0;
+
+  for (; i + 8 <= n; i += 8) {
+    const uint64_t x = Load<uint64_t>(a + i) ^ Load<uint64_t>(b + i);
+    if (x != 0) return i + FirstNonZeroByte(x);
+  }
+
+  if (i == n) return n;
+
+  const uint64_t x = Load<uint64_t>(a + n - 8) ^ Load<uint64_t>(b + n - 8);
+
+  return x != 0 ? n - 8 + FirstNonZeroByte(x) : n;
+}
+
+#ifdef BADGER_HAVE_X86_MISMATCH
+
+namespace {
+
+/// \return A bit mask of the positions at which the 16-byte blocks at `a`
+///         and `b` differ.
+inline unsigned Diff16(const char* a, const char* b) {
+  const __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a));
+  const __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b));
+
+  return static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(va, vb))) ^
+         0xffff;
+}
+
+__attribute__((target("avx2"))) inline __m256i Eq32(const char* a,
+                                                     const char* b) {
+  const __m256i va = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a));
+  const __m256i vb = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b));
+
+  return _mm256_cmpeq_epi8(va, vb);
+}
+
+__attribute__((target("avx2"))) inline uint32_t Diff32(const char* a,
+                                                       const char* b) {
+  return ~static_cast<uint32_t>(_mm256_movemask_epi8(Eq32(a, b)));
+}
+
+}  // namespace
+
+size_t FindFirstMismatchSSE2(const char* a, const char* b, size_t n) {
+  if (n < 16) return FindFirstMismatchShort(a, b, n);
+
+  size_t i = 0;
+
+  for (; i + 16 <= n; i += 16) {
+    const unsigned mask = Diff16(a + i, b + i);
+    if (mask != 0) return i + std::countr_zero(mask);
+  }
+
+  if (i == n) return n;
+
+  const unsigned mask = Diff16(a + n - 16, b + n - 16);
+
+  return mask != 0 ? n - 16 + std::countr_zero(mask) : n;
+}
+
+__attribute__((target("avx2"))) size_t FindFirstMismatchAVX2(const char* a,
+                                                              const char* b,
+                                                              size_t n) {
+  if (n < 32) return FindFirstMismatchSSE2(a, b, n);
+
+  size_t i = 0;
+
+  // Two blocks per iteration keep both load ports busy; the branch only
+  // checks whether any byte differs.
+  for (; i + 64 <= n; i += 64) {
+    const __m256i eq0 = Eq32(a + i, b + i);
+    const __m256i eq1 = Eq32(a + i + 32, b + i + 32);
+
+    if (static_cast<uint32_t>(_mm256_movemask_epi8(
+            _mm256_and_si256(eq0, eq1))) != 0xffffffff) {
+      const uint32_t mask0 = ~static_cast<uint32_t>(_mm256_movemask_epi8(eq0));
+      if (mask0 != 0) return i + std::countr_zero(mask0);
+
+      const uint32_t mask1 = ~static_cast<uint32_t>(_mm256_movemask_epi8(eq1));
+      return i + 32 + std::countr_zero(mask1);
+    }
+  }
+
+  if (i + 32 <= n) {
+    const uint32_t mask = Diff32(a + i, b + i);
+    if (mask != 0) return i + std::countr_zero(mask);
+
+    i += 32;
+  }
+
+  if (i == n) return n;
+
+  const uint32_t mask = Diff32(a + n - 32, b + n - 32);
+
+  return mask != 0 ? n - 32 + std::countr_zero(mask) : n;
+}
+
+#endif  // BADGER_HAVE_X86_MISMATCH
+
+const char* MismatchKernelName() {
+  MismatchFunction kernel = SelectKernel();
+
+#ifdef BADGER_HAVE_X86_MISMATCH
+  if (kernel == FindFirstMismatchAVX2) return "avx2";
+  if (kernel == FindFirstMismatchSSE2) return "sse2";
+#endif
+
+  return kernel == FindFirstMismatchScalar ? "scalar" : "unknown";
+}
+
+}  // namespace badger
@@ -0,0 +1,47 @@
+#include "cpp-badger/util/perf_context.hh"
+
+#include <cinttypes>
+#include <cstdio>
+#include <utility>
+
+namespace badger {
+
+thread_local PerfLevel perf_level = PerfLevel::kDisable;
+thread_local PerfContext perf_context;
+
+void SetPerfLevel(PerfLevel level) { perf_level = level; }
+
+PerfLevel GetPerfLevel() { return perf_level; }
+
+PerfContext* GetPerfContext() { return &perf_context; }
+
+std::string PerfContext::ToString(bool exclude_zero_counters) const {
+  const std::pair<const char*, uint64_t> metrics[] = {
+      {"user_key_comparison_count", user_key_comparison_count},
+      {"skiplist_levels_traversed", skiplist_levels_traversed},
+      {"arena_bytes_allocated", arena_bytes_allocated},
+      {"cleanups_registered", cleanups_registered},
+      {"threadpool_tasks_scheduled", threadpool_tasks_scheduled},
+      {"get_from_memtable_count", get_from_memtable_count},
+      {"block_read_count", block_read_count},
+      {"block_read_bytes", block_read_bytes},
+      {"skiplist_insert_nanos", skiplist_insert_nanos},
+      {"get_from_memtable_nanos", get_from_memtable_nanos},
+      {"threadpool_schedule_nanos", threadpool_schedule_nanos},
+      {"block_read_nanos", block_read_nanos},
+  };
+  std::string out;
+
+  for (const auto& [name, value] : metrics) {
+    if (exclude_zero_counters && value == 0) continue;
+
+    char buf[64];
+    snprintf(buf, sizeof(buf), "%s%s = %" PRIu64, out.empty() ? "" : ", ",
+             name, value);
+    out += buf;
+  }
+
+  return out;
+}
+
+}  // namespace badger
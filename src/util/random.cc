@@ -28,6 +28,13 @@ Random* Random::GetTLSInstance() {
   return rv;
 }
 
+RandomGenerator* RandomGenerator::GetTLSInstance() {
+  static thread_local RandomGenerator instance(
+      std::hash<std::thread::id>()(std::this_thread::get_id()));
+
+  return &instance;
+}
+
 std::string Random::HumanReadableString(int len) {
   std::string ret;
   ret.resize(len);
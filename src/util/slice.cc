@@ -1,34 +1,63 @@
 #include "cpp-badger/util/slice.hh"
 
-#include <absl/strings/escaping.h>
-#include <absl/strings/str_cat.h>
-#include <absl/strings/string_view.h>
+#include <algorithm>
 
 namespace badger {
 
 Slice::Slice(const SliceParts& parts, std::string* buf) {
-  size_t length = 0;
+  parts.AppendTo(buf);
 
-  for (int i = 0; i < parts.num_parts; ++i) length += parts.parts[i].size();
+  data_ = buf->data();
+  size_ = buf->size();
+}
 
-  buf->reserve(length);
+int SliceParts::Compare(const Slice& b) const {
+  size_t offset = 0;
 
-  for (int i = 0; i < parts.num_parts; ++i)
-    buf->append(parts.parts[i].data(), parts.parts[i].size());
+  for (int i = 0; i < num_parts; ++i) {
+    const Slice& part = parts[i];
+    const size_t n = std::min(part.size(), b.size() - offset);
+    const size_t off = FindFirstMismatch(part.data(), b.data() + offset, n);
 
-  data_ = buf->data();
-  size_ = buf->size();
+    if (off < n)
+      return static_cast<uint8_t>(part[off]) <
+                     static_cast<uint8_t>(b[offset + off])
+                 ? -1
+                 : +1;
+
+    // `b` is a proper prefix of the parts.
+    if (n < part.size()) return +1;
+
+    offset += n;
+  }
+
+  return offset < b.size() ? -1 : 0;
+}
+
+void SliceParts::AppendTo(std::string* dst) const {
+  const size_t old_size = dst->size();
+
+  dst->resize(old_size + size());
+  CopyTo(dst->data() + old_size);
 }
 
 std::string Slice::ToString(bool hex) const {
-  if (hex) return absl::BytesToHexString(absl::string_view(data_, size_));
+  if (!hex) return std::string(data_, size_);
 
-  return std::string(data_, size_);
+  std::string result(2 * size_, '\0');
+  EncodeHex(result.data());
+
+  return result;
 }
 
 bool Slice::DecodeHex(std::string& result) const {
-  return absl::HexStringToBytes(absl::string_view{data_, data_ + size_},
-                                &result);
+  result.resize(size_ / 2);
+
+  if (HexDecode(data_, size_, result.data())) return true;
+
+  result.clear();
+
+  return false;
 }
 
 PinnableSlice::PinnableSlice(PinnableSlice&& other) {
@@ -42,18 +71,27 @@ PinnableSlice& PinnableSlice::operator=(PinnableSlice&& other) {
     size_ = other.size_;
     pinned_ = other.pinned_;
 
+    // The scratch buffer and allocator belong to each object and are not
+    // transferred.
     if (pinned_) {
       // When it's pinned, buf should no longer be of use.
       data_ = other.data_;
+    } else if (other.self_storage_ == SelfStorage::kScratch) {
+      // The data lives inside `other`; copy it out.
+      PinSelf(Slice(other.data_, other.size_));
+    } else if (other.self_storage_ == SelfStorage::kAllocated) {
+      // Allocator memory outlives both objects.
+      self_storage_ = SelfStorage::kAllocated;
+      data_ = other.data_;
     } else {
       if (other.buf_ == &other.self_space_) {
         self_space_ = std::move(other.self_space_);
         buf_ = &self_space_;
-        data_ = buf_->data();
       } else {
         buf_ = other.buf_;
-        data_ = other.data_;
       }
+
+      PinSelf();
     }
 
     other.self_space_.clear();
@@ -0,0 +1,185 @@
+#include "cpp-badger/util/statistics.hh"
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdarg>
+#include <cstdio>
+#include <iterator>
+
+namespace badger {
+
+namespace {
+
+constexpr const char* kTickerNames[] = {
+    "skiplist.inserts",
+    "arena.allocations",
+    "arena.allocated.bytes",
+    "arena.new.blocks",
+    "threadpool.tasks.scheduled",
+    "threadpool.tasks.run",
+};
+
+constexpr const char* kHistogramNames[] = {
+    "skiplist.insert.nanos",
+    "arena.allocation.bytes",
+    "threadpool.queue.nanos",
+};
+
+static_assert(std::size(kTickerNames) == kTickerMax);
+static_assert(std::size(kHistogramNames) == kHistogramMax);
+
+void Appendf(std::string* out, const char* format, ...)
+    __attribute__((format(printf, 2, 3)));
+
+void Appendf(std::string* out, const char* format, ...) {
+  char buf[512];
+  va_list args;
+
+  va_start(args, format);
+  const int n = vsnprintf(buf, sizeof(buf), format, args);
+  va_end(args);
+
+  if (n > 0) out->append(buf, std::min<size_t>(n, sizeof(buf) - 1));
+}
+
+}  // namespace
+
+const char* TickerName(Ticker ticker) { return kTickerNames[ticker]; }
+
+const char* HistogramName(HistogramType type) {
+  return kHistogramNames[type];
+}
+
+void StatisticsSnapshot::Merge(const StatisticsSnapshot& other) {
+  for (uint32_t i = 0; i < kTickerMax; ++i) tickers[i] += other.tickers[i];
+  for (uint32_t i = 0; i < kHistogramMax; ++i)
+    histograms[i].Merge(other.histograms[i]);
+}
+
+std::string StatisticsSnapshot::ToString() const {
+  std::string out;
+
+  for (uint32_t i = 0; i < kTickerMax; ++i)
+    Appendf(&out, "%s %" PRIu64 "\n", kTickerNames[i], tickers[i]);
+
+  for (uint32_t i = 0; i < kHistogramMax; ++i) {
+    if (histograms[i].Count() == 0) continue;
+
+    Appendf(&out, "%s %s\n", kHistogramNames[i],
+            histograms[i].ToString().c_str());
+  }
+
+  return out;
+}
+
+std::string StatisticsSnapshot::ToJson() const {
+  std::string out = "{\"tickers\": {";
+
+  for (uint32_t i = 0; i < kTickerMax; ++i) {
+    Appendf(&out, "%s\"%s\": %" PRIu64, i == 0 ? "" : ", ", kTickerNames[i],
+            tickers[i]);
+  }
+
+  out += "}, \"histograms\": {";
+
+  for (uint32_t i = 0; i < kHistogramMax; ++i) {
+    const Histogram& h = histograms[i];
+
+    Appendf(&out,
+            "%s\"%s\": {\"count\": %" PRIu64 ", \"sum\": %" PRIu64
+            ", \"min\": %" PRIu64 ", \"max\": %" PRIu64
+            ", \"avg\": %.3f, \"p50\": %.3f, \"p95\": %.3f, \"p99\": %.3f, "
+            "\"p999\": %.3f}",
+            i == 0 ? "" : ", ", kHistogramNames[i], h.Count(), h.Sum(),
+            h.Min(), h.Max(), h.Average(), h.Percentile(50),
+            h.Percentile(95), h.Percentile(99), h.Percentile(99.9));
+  }
+
+  out += "}}";
+
+  return out;
+}
+
+void Statistics::RecordInHistogram(HistogramType type, uint64_t value) {
+  AtomicHistogram& h = cores_.Access()->histograms[type];
+
+  h.buckets[Histogram::BucketIndex(value)].fetch_add(
+      1, std::memory_order_relaxed);
+  h.sum.fetch_add(value, std::memory_order_relaxed);
+
+  // Plain loads first: the extremes rarely change, and then there is no
+  // read-modify-write.
+  uint64_t min = h.min.load(std::memory_order_relaxed);
+  while (value < min &&
+         !h.min.compare_exchange_weak(min, value, std::memory_order_relaxed)) {
+  }
+  uint64_t max = h.max.load(std::memory_order_relaxed);
+  while (value > max &&
+         !h.max.compare_exchange_weak(max, value, std::memory_order_relaxed)) {
+  }
+}
+
+uint64_t Statistics::GetTickerCount(Ticker ticker) const {
+  uint64_t total = 0;
+
+  for (size_t core = 0; core < cores_.Size(); ++core)
+    total += cores_.AccessAtCore(core)->tickers[ticker].load(
+        std::memory_order_relaxed);
+
+  return total;
+}
+
+void Statistics::MergeCore(size_t core, HistogramType type,
+                           Histogram* histogram) const {
+  const AtomicHistogram& h = cores_.AccessAtCore(core)->histograms[type];
+
+  for (int i = 0; i < Histogram::kNumBuckets; ++i) {
+    const uint64_t n = h.buckets[i].load(std::memory_order_relaxed);
+
+    histogram->buckets_[i] += n;
+    histogram->count_ += n;
+  }
+  histogram->sum_ += h.sum.load(std::memory_order_relaxed);
+  histogram->min_ =
+      std::min(histogram->min_, h.min.load(std::memory_order_relaxed));
+  histogram->max_ =
+      std::max(histogram->max_, h.max.load(std::memory_order_relaxed));
+}
+
+Histogram Statistics::GetHistogram(HistogramType type) const {
+  Histogram histogram;
+
+  for (size_t core = 0; core < cores_.Size(); ++core)
+    MergeCore(core, type, &histogram);
+
+  return histogram;
+}
+
+StatisticsSnapshot Statistics::Snapshot() const {
+  StatisticsSnapshot snapshot;
+
+  for (uint32_t i = 0; i < kTickerMax; ++i)
+    snapshot.tickers[i] = GetTickerCount(static_cast<Ticker>(i));
+  for (uint32_t i = 0; i < kHistogramMax; ++i)
+    snapshot.histograms[i] = GetHistogram(static_cast<HistogramType>(i));
+
+  return snapshot;
+}
+
+void Statistics::Reset() {
+  for (size_t core = 0; core < cores_.Size(); ++core) {
+    CoreStats* stats = cores_.AccessAtCore(core);
+
+    for (auto& ticker : stats->tickers)
+      ticker.store(0, std::memory_order_relaxed);
+
+    for (auto& h : stats->histograms) {
+      for (auto& bucket : h.buckets) bucket.store(0, std::memory_order_relaxed);
+      h.sum.store(0, std::memory_order_relaxed);
+      h.min.store(UINT64_MAX, std::memory_order_relaxed);
+      h.max.store(0, std::memory_order_relaxed);
+    }
+  }
+}
+
+}  // namespace badger
@@ -0,0 +1,209 @@
+#include "cpp-badger/util/workload_generator.hh"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+#include <numbers>
+
+#include "cpp-badger/util/fast_range.hh"
+
+namespace badger {
+
+namespace {
+
+/// log1p(x) / x, accurate near 0.
+double Log1pOverX(double x) {
+  if (std::abs(x) > 1e-8) return std::log1p(x) / x;
+
+  return 1 - x * (0.5 - x * (1.0 / 3 - 0.25 * x));
+}
+
+/// expm1(x) / x, accurate near 0.
+double Expm1OverX(double x) {
+  if (std::abs(x) > 1e-8) return std::expm1(x) / x;
+
+  return 1 + x * 0.5 * (1 + x * (1.0 / 3) * (1 + 0.25 * x));
+}
+
+}  // namespace
+
+// The sampler follows RejectionInversionZipfSampler of Apache Commons RNG,
+// over ranks 1 to num_keys.
+ZipfianGenerator::ZipfianGenerator(uint64_t num_keys, double theta,
+                                   uint64_t seed)
+    : theta_(theta), rnd_(seed) {
+  assert(theta > 0);
+
+  h_integral_x1_ = HIntegral(1.5) - 1;
+  s_ = 2 - HIntegralInverse(HIntegral(2.5) - H(2));
+  SetNumKeys(num_keys);
+}
+
+void ZipfianGenerator::SetNumKeys(uint64_t num_keys) {
+  assert(num_keys > 0);
+
+  num_keys_ = num_keys;
+  h_integral_num_keys_ = HIntegral(static_cast<double>(num_keys) + 0.5);
+}
+
+double ZipfianGenerator::H(double x) const {
+  return std::exp(-theta_ * std::log(x));
+}
+
+double ZipfianGenerator::HIntegral(double x) const {
+  const double log_x = std::log(x);
+
+  return Expm1OverX((1 - theta_) * log_x) * log_x;
+}
+
+double ZipfianGenerator::HIntegralInverse(double x) const {
+  // Clamped, since rounding may push it just past the domain.
+  const double t = std::max(x * (1 - theta_), -1.0);
+
+  return std::exp(Log1pOverX(t) * x);
+}
+
+uint64_t ZipfianGenerator::Next() {
+  const auto n = static_cast<double>(num_keys_);
+
+  for (;;) {
+    // Invert the integral of the continuous density at a uniform point,
+    // round to the nearest rank, and accept it unless it falls in the small
+    // area where the density overestimates the distribution.
+    const double u =
+        h_integral_num_keys_ +
+        rnd_.NextDouble() * (h_integral_x1_ - h_integral_num_keys_);
+    const double x = HIntegralInverse(u);
+    const double k = std::clamp(std::floor(x + 0.5), 1.0, n);
+
+    if (k - x <= s_ || u >= HIntegral(k + 0.5) - H(k))
+      return static_cast<uint64_t>(k) - 1;
+  }
+}
+
+uint64_t ScrambledZipfianGenerator::Next() {
+  // The murmur3 finalizer, a bijection on 64-bit values. It maps 0 to 0, so
+  // the rank is offset first to move the hottest key away from key 0.
+  uint64_t h = zipf_.Next() + 0x9e3779b97f4a7c15ULL;
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdULL;
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53ULL;
+  h ^= h >> 33;
+
+  return fast_range64(h, zipf_.NumKeys());
+}
+
+HotspotGenerator::HotspotGenerator(uint64_t num_keys, double hot_set_fraction,
+                                   double hot_op_fraction, uint64_t seed)
+    : num_keys_(num_keys), rnd_(seed) {
+  assert(num_keys > 0);
+  assert(hot_set_fraction >= 0 && hot_set_fraction <= 1);
+  assert(hot_op_fraction >= 0 && hot_op_fraction <= 1);
+
+  hot_keys_ = std::min<uint64_t>(
+      static_cast<uint64_t>(static_cast<double>(num_keys) * hot_set_fraction),
+      num_keys);
+  hot_op_threshold_ = hot_op_fraction >= 1
+                          ? std::numeric_limits<uint64_t>::max()
+                          : static_cast<uint64_t>(hot_op_fraction * 0x1p64);
+}
+
+uint64_t HotspotGenerator::Next() {
+  const bool hot = rnd_.Next() < hot_op_threshold_;
+
+  if (hot_keys_ == num_keys_ || (hot && hot_keys_ > 0))
+    return rnd_.Uniform(hot_keys_);
+
+  return hot_keys_ + rnd_.Uniform(num_keys_ - hot_keys_);
+}
+
+ExponentialGenerator::ExponentialGenerator(uint64_t num_keys,
+                                           double percentile,
+                                           double range_fraction,
+                                           uint64_t seed)
+    : num_keys_(num_keys), rnd_(seed) {
+  assert(num_keys > 0);
+  assert(percentile > 0 && percentile < 100);
+  assert(range_fraction > 0);
+
+  gamma_ = -std::log1p(-percentile / 100) /
+           (static_cast<double>(num_keys) * range_fraction);
+}
+
+uint64_t ExponentialGenerator::Next() {
+  const auto n = static_cast<double>(num_keys_);
+
+  // Draws past the last key (about 3% with the defaults) are redrawn.
+  for (;;) {
+    const double x = -std::log1p(-rnd_.NextDouble()) / gamma_;
+    if (x < n) return static_cast<uint64_t>(x);
+  }
+}
+
+ValueSizeGenerator ValueSizeGenerator::Fixed(uint32_t size) {
+  return ValueSizeGenerator(Distribution::kFixed, 0, 0, size, size, 0);
+}
+
+ValueSizeGenerator ValueSizeGenerator::Uniform(uint32_t min, uint32_t max,
+                                               uint64_t seed) {
+  assert(min <= max);
+
+  return ValueSizeGenerator(Distribution::kUniform, 0, 0, min, max, seed);
+}
+
+ValueSizeGenerator ValueSizeGenerator::Normal(double mean, double stddev,
+                                              uint32_t min, uint32_t max,
+                                              uint64_t seed) {
+  assert(min <= max);
+
+  return ValueSizeGenerator(Distribution::kNormal, mean, stddev, min, max,
+                            seed);
+}
+
+ValueSizeGenerator ValueSizeGenerator::Pareto(double sigma, double k,
+                                              uint32_t min, uint32_t max,
+                                              uint64_t seed) {
+  assert(min <= max);
+
+  return ValueSizeGenerator(Distribution::kPareto, sigma, k, min, max, seed);
+}
+
+uint32_t ValueSizeGenerator::Clamp(double size) const {
+  if (!(size > min_)) return min_;
+  if (size >= max_) return max_;
+
+  return static_cast<uint32_t>(size + 0.5);
+}
+
+uint32_t ValueSizeGenerator::Next() {
+  switch (distribution_) {
+    case Distribution::kFixed:
+      return min_;
+    case Distribution::kUniform:
+      return min_ + static_cast<uint32_t>(rnd_.Uniform(uint64_t{max_} -
+                                                       min_ + 1));
+    case Distribution::kNormal: {
+      // Box-Muller; 1 - NextDouble() is in (0, 1], so the log is finite.
+      const double u1 = 1 - rnd_.NextDouble();
+      const double u2 = rnd_.NextDouble();
+      const double z = std::sqrt(-2 * std::log(u1)) *
+                       std::cos(2 * std::numbers::pi * u2);
+
+      return Clamp(a_ + b_ * z);
+    }
+    case Distribution::kPareto: {
+      // Inverse of the CDF at a uniform point in (0, 1].
+      const double u = 1 - rnd_.NextDouble();
+      const double x = b_ == 0 ? -a_ * std::log(u)
+                               : a_ * (std::pow(u, -b_) - 1) / b_;
+
+      return Clamp(min_ + x);
+    }
+  }
+
+  return min_;
+}
+
+}  // namespace badger
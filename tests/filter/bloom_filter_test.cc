@@ -0,0 +1,223 @@
+#include "cpp-badger/filter/bloom_filter.hh"
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "cpp-badger/util/coding.hh"
+#include "cpp-badger/util/random.hh"
+
+namespace badger {
+
+static std::string Key(uint64_t i) {
+  char buf[sizeof(i)];
+  EncodeFixed64(buf, i);
+
+  return std::string(buf, sizeof(buf));
+}
+
+static std::string BuildFilter(size_t num_keys, double bits_per_key) {
+  BloomFilterBuilder builder(bits_per_key);
+  for (uint64_t i = 0; i < num_keys; ++i) builder.AddKey(Key(i));
+
+  const size_t estimated_size = builder.EstimatedSize();
+  std::string filter;
+  builder.Finish(&filter);
+  EXPECT_EQ(estimated_size, filter.size());
+  EXPECT_EQ(0u, builder.NumAdded());
+
+  return filter;
+}
+
+static double FpRate(const BloomFilterReader& reader, uint64_t first_key) {
+  constexpr int kQueries = 100000;
+  int hits = 0;
+
+  for (uint64_t i = 0; i < kQueries; ++i)
+    hits += reader.MayContain(Key(first_key + i));
+
+  return static_cast<double>(hits) / kQueries;
+}
+
+TEST(BloomFilterTest, EmptyFilter) {
+  const std::string filter = BuildFilter(0, 10);
+  BloomFilterReader reader(filter);
+
+  ASSERT_TRUE(reader.IsValid());
+  ASSERT_EQ(0u, reader.NumLines());
+  ASSERT_FALSE(reader.MayContain("hello"));
+  ASSERT_FALSE(reader.MayContain(""));
+}
+
+TEST(BloomFilterTest, NoFalseNegatives) {
+  for (size_t num_keys : {1, 10, 100, 1000, 10000, 100000}) {
+    for (double bits_per_key : {1.0, 5.5, 10.0, 20.0}) {
+      const std::string filter = BuildFilter(num_keys, bits_per_key);
+      BloomFilterReader reader(filter);
+      ASSERT_TRUE(reader.IsValid());
+
+      for (uint64_t i = 0; i < num_keys; ++i)
+        ASSERT_TRUE(reader.MayContain(Key(i))) << num_keys << " " << i;
+    }
+  }
+}
+
+// The false positive rate follows bits_per_key and agrees with the estimate.
+TEST(BloomFilterTest, FpRate) {
+  constexpr size_t kNumKeys = 100000;
+
+  for (double bits_per_key : {5.0, 10.0, 16.0}) {
+    const std::string filter = BuildFilter(kNumKeys, bits_per_key);
+    BloomFilterReader reader(filter);
+    const double rate = FpRate(reader, 1 << 30);
+    const double estimate = BloomFilter::EstimatedFpRate(
+        kNumKeys, reader.NumLines(), reader.NumProbes());
+
+    ASSERT_NEAR(estimate, rate, 0.2 * estimate + 0.0005) << bits_per_key;
+  }
+
+  const std::string filter = BuildFilter(kNumKeys, 10);
+  ASSERT_LT(FpRate(BloomFilterReader(filter), 1 << 30), 0.0125);
+}
+
+TEST(BloomFilterTest, Shape) {
+  const std::string filter = BuildFilter(1000, 10);
+  BloomFilterReader reader(filter);
+
+  // 10000 bits round up to 20 lines.
+  ASSERT_EQ(20u, reader.NumLines());
+  ASSERT_EQ(6, reader.NumProbes());
+  ASSERT_EQ(20 * BloomFilter::kLineSize + BloomFilter::kTrailerSize,
+            filter.size());
+
+  ASSERT_EQ(1, BloomFilter::ChooseNumProbes(1000));
+  ASSERT_EQ(BloomFilter::kMaxProbes, BloomFilter::ChooseNumProbes(100000));
+}
+
+// Finish() appends, so a filter can be written after other contents and
+// read from the middle of a buffer.
+TEST(BloomFilterTest, ZeroCopyFromSlice) {
+  BloomFilterBuilder builder;
+  for (uint64_t i = 0; i < 500; ++i) builder.AddKey(Key(i));
+
+  std::string buffer = "header";
+  builder.Finish(&buffer);
+  const size_t filter_size = buffer.size() - 6;
+  buffer += "footer";
+
+  BloomFilterReader reader(Slice(buffer.data() + 6, filter_size));
+  ASSERT_TRUE(reader.IsValid());
+  for (uint64_t i = 0; i < 500; ++i) ASSERT_TRUE(reader.MayContain(Key(i)));
+}
+
+// The layout is persisted, so the same keys must always give the same bytes.
+TEST(BloomFilterTest, StableFormat) {
+  const std::string filter = BuildFilter(1000, 10);
+
+  ASSERT_EQ(0xe90e3d13bb80fb37ULL, Hash64(filter.data(), filter.size()));
+}
+
+TEST(BloomFilterTest, Corrupt) {
+  const std::string filter = BuildFilter(100, 10);
+
+  auto invalid = [](const Slice& contents) {
+    BloomFilterReader reader(contents);
+    return !reader.IsValid() && reader.MayContain("anything");
+  };
+
+  ASSERT_TRUE(invalid(Slice()));
+  ASSERT_TRUE(invalid(Slice(filter.data(), filter.size() - 1)));
+  ASSERT_TRUE(invalid(Slice(filter.data() + 64, filter.size() - 64)));
+
+  std::string bad_marker = filter;
+  bad_marker.back() = 0;
+  ASSERT_TRUE(invalid(bad_marker));
+
+  std::string bad_probes = filter;
+  bad_probes[bad_probes.size() - 4] = 0;
+  ASSERT_TRUE(invalid(bad_probes));
+}
+
+// The batched queries agree with one key at a time, for any batch size and
+// for empty and invalid filters too.
+TEST(BloomFilterTest, BatchedMayContain) {
+  const std::string filter = BuildFilter(10000, 6);
+  const std::string empty = BuildFilter(0, 10);
+
+  for (const Slice& contents : {Slice(filter), Slice(empty), Slice("junk")}) {
+    BloomFilterReader reader(contents);
+
+    for (size_t n : {0, 1, 7, 32, 33, 100, 20000}) {
+      std::vector<std::string> strings;
+      std::vector<Slice> keys;
+      std::vector<uint64_t> hashes;
+      // Half added keys, half not.
+      for (uint64_t i = 0; i < n; ++i) strings.push_back(Key(i * 2));
+      for (const auto& s : strings) {
+        keys.emplace_back(s);
+        hashes.push_back(Hash64(s.data(), s.size()));
+      }
+
+      std::unique_ptr<bool[]> from_keys(new bool[n]);
+      std::unique_ptr<bool[]> from_hashes(new bool[n]);
+      reader.MayContain(keys.data(), n, from_keys.get());
+      reader.MayContainHashes(hashes.data(), n, from_hashes.get());
+
+      for (size_t i = 0; i < n; ++i) {
+        ASSERT_EQ(reader.MayContain(keys[i]), from_keys[i]) << n << " " << i;
+        ASSERT_EQ(reader.MayContain(keys[i]), from_hashes[i]) << n << " " << i;
+      }
+    }
+  }
+}
+
+// Every kernel gives the same answers, for all numbers of probes.
+TEST(BloomFilterTest, ProbeKernels) {
+  constexpr size_t kNumLines = 64;
+  constexpr size_t kNumQueries = 4096;
+  Random64 rnd(301);
+  std::vector<uint8_t> lines(kNumLines * BloomFilter::kLineSize);
+  std::vector<const uint8_t*> query_lines;
+  std::vector<uint32_t> probe_hashes;
+
+  // Dense lines, so that many queries pass.
+  for (auto& b : lines)
+    b = static_cast<uint8_t>(rnd.Next() | rnd.Next() | rnd.Next());
+  for (size_t i = 0; i < kNumQueries; ++i) {
+    query_lines.push_back(&lines[rnd.Next() % kNumLines *
+                                 BloomFilter::kLineSize]);
+    probe_hashes.push_back(static_cast<uint32_t>(rnd.Next()));
+  }
+
+  std::vector<BloomProbeFunction> kernels;
+#ifdef BADGER_HAVE_X86_BLOOM
+  if (__builtin_cpu_supports("avx2")) kernels.push_back(BloomProbeAVX2);
+#endif
+  kernels.push_back(internal::bloom_probe.load());
+
+  for (int num_probes = 1; num_probes <= BloomFilter::kMaxProbes;
+       ++num_probes) {
+    std::unique_ptr<bool[]> expected(new bool[kNumQueries]);
+    BloomProbeScalar(query_lines.data(), probe_hashes.data(), kNumQueries,
+                     num_probes, expected.get());
+
+    size_t hits = 0;
+    for (size_t i = 0; i < kNumQueries; ++i) hits += expected[i];
+    ASSERT_GT(hits, 0u) << num_probes;
+
+    for (BloomProbeFunction kernel : kernels) {
+      std::unique_ptr<bool[]> out(new bool[kNumQueries]);
+      kernel(query_lines.data(), probe_hashes.data(), kNumQueries, num_probes,
+             out.get());
+
+      for (size_t i = 0; i < kNumQueries; ++i)
+        ASSERT_EQ(expected[i], out[i]) << num_probes << " " << i;
+    }
+  }
+
+  ASSERT_NE(nullptr, BloomProbeKernelName());
+}
+
+}  // namespace badger
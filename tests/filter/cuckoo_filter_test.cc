@@ -0,0 +1,121 @@
+#include "cpp-badger/filter/cuckoo_filter.hh"
+
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include "cpp-badger/util/coding.hh"
+
+namespace badger {
+
+static std::string Key(uint64_t i) {
+  char buf[sizeof(i)];
+  EncodeFixed64(buf, i);
+
+  return std::string(buf, sizeof(buf));
+}
+
+static double FpRate(const CuckooFilter& filter) {
+  constexpr int kQueries = 200000;
+  int hits = 0;
+
+  for (uint64_t i = 0; i < kQueries; ++i)
+    hits += filter.MayContain(Key((uint64_t{1} << 40) + i));
+
+  return static_cast<double>(hits) / kQueries;
+}
+
+TEST(CuckooFilterTest, Empty) {
+  Arena arena;
+  CuckooFilter filter(&arena, 0);
+
+  ASSERT_EQ(1u, filter.NumBuckets());
+  ASSERT_FALSE(filter.MayContain("hello"));
+  ASSERT_FALSE(filter.DeleteKey("hello"));
+  ASSERT_EQ(0u, filter.Size());
+}
+
+TEST(CuckooFilterTest, AddDeleteMayContain) {
+  constexpr size_t kNumKeys = 100000;
+  Arena arena;
+  CuckooFilter filter(&arena, kNumKeys);
+
+  for (uint64_t i = 0; i < kNumKeys; ++i) ASSERT_TRUE(filter.AddKey(Key(i)));
+  ASSERT_EQ(kNumKeys, filter.Size());
+  for (uint64_t i = 0; i < kNumKeys; ++i)
+    ASSERT_TRUE(filter.MayContain(Key(i)));
+
+  // 16-bit fingerprints in two buckets of four: about 8 / 65536.
+  ASSERT_LT(FpRate(filter), 0.0003);
+
+  // Deleting the even keys leaves the odd ones and makes the even ones
+  // (mostly) absent.
+  for (uint64_t i = 0; i < kNumKeys; i += 2)
+    ASSERT_TRUE(filter.DeleteKey(Key(i)));
+  ASSERT_EQ(kNumKeys / 2, filter.Size());
+
+  size_t still_present = 0;
+  for (uint64_t i = 0; i < kNumKeys; ++i) {
+    if (i % 2 == 1)
+      ASSERT_TRUE(filter.MayContain(Key(i))) << i;
+    else
+      still_present += filter.MayContain(Key(i));
+  }
+  ASSERT_LT(still_present, kNumKeys / 2 / 1000);
+}
+
+// A window of keys slides through a filter sized for it: the oldest key is
+// deleted as each new one comes in, and the filter never fills up.
+TEST(CuckooFilterTest, SlidingWindow) {
+  constexpr uint64_t kWindow = 20000;
+  Arena arena;
+  CuckooFilter filter(&arena, kWindow);
+
+  for (uint64_t i = 0; i < 10 * kWindow; ++i) {
+    ASSERT_TRUE(filter.AddKey(Key(i))) << i;
+    if (i >= kWindow) ASSERT_TRUE(filter.DeleteKey(Key(i - kWindow))) << i;
+  }
+
+  ASSERT_EQ(kWindow, filter.Size());
+  for (uint64_t i = 9 * kWindow; i < 10 * kWindow; ++i)
+    ASSERT_TRUE(filter.MayContain(Key(i)));
+  ASSERT_LT(FpRate(filter), 0.0003);
+}
+
+TEST(CuckooFilterTest, Repeats) {
+  Arena arena;
+  CuckooFilter filter(&arena, 100);
+
+  ASSERT_TRUE(filter.AddKey("a"));
+  ASSERT_TRUE(filter.AddKey("a"));
+  ASSERT_TRUE(filter.DeleteKey("a"));
+  ASSERT_TRUE(filter.MayContain("a"));
+  ASSERT_TRUE(filter.DeleteKey("a"));
+  ASSERT_FALSE(filter.MayContain("a"));
+  ASSERT_FALSE(filter.DeleteKey("a"));
+}
+
+// The table fills well past kMaxLoadFactor. Once full, every added key is
+// still reported present, and deleting makes room again.
+TEST(CuckooFilterTest, Full) {
+  constexpr size_t kCapacity = 10000;
+  Arena arena;
+  CuckooFilter filter(&arena, kCapacity);
+
+  uint64_t added = 0;
+  while (filter.AddKey(Key(added))) ++added;
+  ++added;  // The last key was kept aside, not dropped
+
+  ASSERT_GE(added, kCapacity);
+  ASSERT_GT(static_cast<double>(added) / filter.Capacity(), 0.95);
+  ASSERT_EQ(added, filter.Size());
+  for (uint64_t i = 0; i < added; ++i) ASSERT_TRUE(filter.MayContain(Key(i)));
+
+  for (uint64_t i = 0; i < added / 10; ++i)
+    ASSERT_TRUE(filter.DeleteKey(Key(i)));
+  for (uint64_t i = added / 10; i < added; ++i)
+    ASSERT_TRUE(filter.MayContain(Key(i)));
+  ASSERT_TRUE(filter.AddKey(Key(added)));
+}
+
+}  // namespace badger
@@ -0,0 +1,187 @@
+#include "cpp-badger/filter/fuse_filter.hh"
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "cpp-badger/filter/bloom_filter.hh"
+#include "cpp-badger/util/coding.hh"
+#include "cpp-badger/util/threadpool.hh"
+
+namespace badger {
+
+static std::string Key(uint64_t i) {
+  char buf[sizeof(i)];
+  EncodeFixed64(buf, i);
+
+  return std::string(buf, sizeof(buf));
+}
+
+static std::string BuildFilter(size_t num_keys, Executor* executor = nullptr) {
+  FuseFilterBuilder builder;
+  for (uint64_t i = 0; i < num_keys; ++i) builder.AddKey(Key(i));
+
+  const size_t estimated_size = builder.EstimatedSize();
+  std::string filter;
+  builder.Finish(&filter, executor);
+  EXPECT_EQ(estimated_size, filter.size());
+  EXPECT_EQ(0u, builder.NumAdded());
+
+  return filter;
+}
+
+static double FpRate(const FuseFilterReader& reader) {
+  constexpr int kQueries = 200000;
+  int hits = 0;
+
+  for (uint64_t i = 0; i < kQueries; ++i)
+    hits += reader.MayContain(Key((uint64_t{1} << 40) + i));
+
+  return static_cast<double>(hits) / kQueries;
+}
+
+TEST(FuseFilterTest, EmptyFilter) {
+  const std::string filter = BuildFilter(0);
+  FuseFilterReader reader(filter);
+
+  ASSERT_TRUE(reader.IsValid());
+  ASSERT_EQ(0u, reader.NumShards());
+  ASSERT_FALSE(reader.MayContain("hello"));
+}
+
+TEST(FuseFilterTest, NoFalseNegatives) {
+  for (size_t num_keys : {1, 2, 3, 10, 100, 1000, 10000, 100000}) {
+    const std::string filter = BuildFilter(num_keys);
+    FuseFilterReader reader(filter);
+    ASSERT_TRUE(reader.IsValid());
+
+    for (uint64_t i = 0; i < num_keys; ++i)
+      ASSERT_TRUE(reader.MayContain(Key(i))) << num_keys << " " << i;
+  }
+}
+
+// 8-bit fingerprints give a false positive rate of 1/256 in about 9 bits per
+// key; a Bloom filter needs 12 bits per key for a slightly higher rate.
+TEST(FuseFilterTest, FpRateAndSize) {
+  constexpr size_t kNumKeys = 200000;
+  const std::string filter = BuildFilter(kNumKeys);
+  const double rate = FpRate(FuseFilterReader(filter));
+
+  ASSERT_NEAR(1.0 / 256, rate, 0.001);
+  ASSERT_LT(8.0 * filter.size() / kNumKeys, 9.4);
+
+  BloomFilterBuilder bloom(12);
+  for (uint64_t i = 0; i < kNumKeys; ++i) bloom.AddKey(Key(i));
+  std::string bloom_filter;
+  bloom.Finish(&bloom_filter);
+  BloomFilterReader bloom_reader(bloom_filter);
+
+  ASSERT_LT(filter.size(), 0.8 * bloom_filter.size());
+  ASSERT_LT(rate, BloomFilter::EstimatedFpRate(kNumKeys,
+                                               bloom_reader.NumLines(),
+                                               bloom_reader.NumProbes()));
+}
+
+// Repeated keys, adjacent or not, are harmless.
+TEST(FuseFilterTest, Duplicates) {
+  FuseFilterBuilder builder;
+  for (int round = 0; round < 3; ++round)
+    for (uint64_t i = 0; i < 5000; ++i) builder.AddKey(Key(i));
+  builder.AddKey(Key(7));
+  builder.AddKey(Key(7));
+
+  std::string filter;
+  builder.Finish(&filter);
+  FuseFilterReader reader(filter);
+  for (uint64_t i = 0; i < 5000; ++i) ASSERT_TRUE(reader.MayContain(Key(i)));
+  ASSERT_LT(FpRate(reader), 0.01);
+}
+
+// Shards built in parallel give the same bytes as built serially.
+TEST(FuseFilterTest, ParallelBuild) {
+  constexpr size_t kNumKeys = 3 * FuseFilter::kMaxShardKeys + 12345;
+  ThreadPool pool(4);
+
+  const std::string serial = BuildFilter(kNumKeys);
+  const std::string parallel = BuildFilter(kNumKeys, &pool);
+  ASSERT_EQ(serial, parallel);
+
+  FuseFilterReader reader(parallel);
+  ASSERT_EQ(4u, reader.NumShards());
+  for (uint64_t i = 0; i < kNumKeys; ++i)
+    ASSERT_TRUE(reader.MayContain(Key(i))) << i;
+  ASSERT_NEAR(1.0 / 256, FpRate(reader), 0.001);
+}
+
+// The batched queries agree with one key at a time, for empty and invalid
+// filters too.
+TEST(FuseFilterTest, BatchedMayContain) {
+  const std::string filter = BuildFilter(10000);
+  const std::string empty = BuildFilter(0);
+
+  for (const Slice& contents : {Slice(filter), Slice(empty), Slice("junk")}) {
+    FuseFilterReader reader(contents);
+
+    for (size_t n : {0, 1, 33, 20000}) {
+      std::vector<std::string> strings;
+      std::vector<Slice> keys;
+      for (uint64_t i = 0; i < n; ++i) strings.push_back(Key(i * 2));
+      for (const auto& s : strings) keys.emplace_back(s);
+
+      std::unique_ptr<bool[]> out(new bool[n]);
+      reader.MayContain(keys.data(), n, out.get());
+      for (size_t i = 0; i < n; ++i)
+        ASSERT_EQ(reader.MayContain(keys[i]), out[i]) << n << " " << i;
+    }
+  }
+}
+
+TEST(FuseFilterTest, ZeroCopyFromSlice) {
+  FuseFilterBuilder builder;
+  for (uint64_t i = 0; i < 500; ++i) builder.AddKey(Key(i));
+
+  std::string buffer = "header";
+  builder.Finish(&buffer);
+  const size_t filter_size = buffer.size() - 6;
+  buffer += "footer";
+
+  FuseFilterReader reader(Slice(buffer.data() + 6, filter_size));
+  ASSERT_TRUE(reader.IsValid());
+  for (uint64_t i = 0; i < 500; ++i) ASSERT_TRUE(reader.MayContain(Key(i)));
+}
+
+// The layout is persisted, so the same keys must always give the same bytes.
+TEST(FuseFilterTest, StableFormat) {
+  const std::string filter = BuildFilter(1000);
+
+  ASSERT_EQ(0x74777810b7638322ULL, Hash64(filter.data(), filter.size()));
+}
+
+TEST(FuseFilterTest, Corrupt) {
+  const std::string filter = BuildFilter(100);
+
+  auto invalid = [](const Slice& contents) {
+    FuseFilterReader reader(contents);
+    return !reader.IsValid() && reader.MayContain("anything");
+  };
+
+  ASSERT_TRUE(invalid(Slice()));
+  ASSERT_TRUE(invalid(Slice(filter.data(), filter.size() - 1)));
+  ASSERT_TRUE(invalid(Slice(filter.data() + 1, filter.size() - 1)));
+
+  std::string bad_marker = filter;
+  bad_marker.back() = 0;
+  ASSERT_TRUE(invalid(bad_marker));
+
+  std::string bad_length = filter;
+  EncodeFixed32(bad_length.data() + bad_length.size() - 12, 3);
+  ASSERT_TRUE(invalid(bad_length));
+
+  std::string huge_shards = filter;
+  EncodeFixed32(huge_shards.data() + huge_shards.size() - 16, 0xffffffff);
+  ASSERT_TRUE(invalid(huge_shards));
+}
+
+}  // namespace badger
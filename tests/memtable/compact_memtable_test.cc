@@ -0,0 +1,208 @@
+#include "cpp-badger/memtable/compact_memtable.hh"
+
+#include <gtest/gtest.h>
+
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "cpp-badger/memtable/merge_operator.hh"
+#include "cpp-badger/util/coding.hh"
+#include "cpp-badger/util/random.hh"
+#include "cpp-badger/util/threadpool.hh"
+
+namespace badger {
+
+class CompactMemTableTest : public testing::Test {};
+
+static std::string KeyOf(uint32_t k) {
+  char buf[16];
+  snprintf(buf, sizeof(buf), "key%03u", k);
+
+  return buf;
+}
+
+static std::string EncodeCounter(uint64_t v) {
+  std::string s;
+  PutFixed64(&s, v);
+
+  return s;
+}
+
+/// Fills `mem` with a random mix of values, deletions, merges and range
+/// deletions over a small key space.
+static void FillRandom(MemTable* mem, uint32_t num_keys, SequenceNumber n) {
+  Random rnd(301);
+
+  for (SequenceNumber seq = 1; seq <= n; ++seq) {
+    const std::string key = KeyOf(rnd.Uniform(num_keys));
+
+    if (rnd.OneIn(10)) {
+      mem->Add(seq, kTypeDeletion, key, "");
+    } else if (rnd.OneIn(20)) {
+      mem->DeleteRange(seq, key, KeyOf(rnd.Uniform(num_keys)));
+    } else if (rnd.OneIn(3)) {
+      mem->Add(seq, kTypeMerge, key, EncodeCounter(seq));
+    } else {
+      mem->Add(seq, kTypeValue, key, EncodeCounter(seq));
+    }
+  }
+}
+
+TEST_F(CompactMemTableTest, Empty) {
+  MemTable mem;
+  CompactMemTable compact(mem);
+  std::string value;
+
+  ASSERT_EQ(0u, compact.NumEntries());
+  ASSERT_EQ(LookupResult::kNotFound,
+            compact.Get("a", kMaxSequenceNumber, &value));
+
+  CompactMemTable::Iterator iter(&compact, kMaxSequenceNumber);
+  iter.SeekToFirst();
+  ASSERT_FALSE(iter.Valid());
+  iter.SeekToLast();
+  ASSERT_FALSE(iter.Valid());
+  iter.Seek("a");
+  ASSERT_FALSE(iter.Valid());
+}
+
+TEST_F(CompactMemTableTest, MatchesMemTable) {
+  const uint32_t kNumKeys = 200;
+  MemTableOptions options;
+  options.merge_operator = std::make_shared<UInt64AddOperator>();
+  MemTable mem(options);
+
+  FillRandom(&mem, kNumKeys, 5000);
+
+  CompactMemTable compact(mem);
+
+  ASSERT_EQ(mem.NumEntries(), compact.NumEntries());
+  ASSERT_EQ(mem.NumRangeDeletes(), compact.NumRangeDeletes());
+  ASSERT_LT(compact.ApproximateMemoryUsage(), mem.ApproximateMemoryUsage());
+
+  for (SequenceNumber snapshot :
+       {SequenceNumber{0}, SequenceNumber{1000}, SequenceNumber{2500},
+        kMaxSequenceNumber}) {
+    for (uint32_t k = 0; k <= kNumKeys; ++k) {
+      const std::string key = KeyOf(k);
+      std::string expected_value;
+      std::string value;
+      LookupResult expected = mem.Get(key, snapshot, &expected_value);
+
+      ASSERT_EQ(expected, compact.Get(key, snapshot, &value)) << key;
+
+      if (expected != LookupResult::kNotFound &&
+          expected != LookupResult::kDeleted)
+        ASSERT_EQ(expected_value, value) << key;
+    }
+
+    MemTable::Iterator expected(&mem, snapshot);
+    CompactMemTable::Iterator iter(&compact, snapshot);
+
+    for (expected.SeekToFirst(), iter.SeekToFirst(); expected.Valid();
+         expected.Next(), iter.Next()) {
+      ASSERT_TRUE(iter.Valid());
+      ASSERT_EQ(expected.key(), iter.key());
+      ASSERT_EQ(expected.sequence(), iter.sequence());
+      ASSERT_EQ(expected.type(), iter.type());
+      ASSERT_EQ(expected.value(), iter.value());
+    }
+
+    ASSERT_FALSE(iter.Valid());
+
+    for (expected.SeekToLast(), iter.SeekToLast(); expected.Valid();
+         expected.Prev(), iter.Prev()) {
+      ASSERT_TRUE(iter.Valid());
+      ASSERT_EQ(expected.key(), iter.key());
+      ASSERT_EQ(expected.sequence(), iter.sequence());
+    }
+
+    ASSERT_FALSE(iter.Valid());
+
+    for (uint32_t k = 0; k <= kNumKeys; k += 7) {
+      expected.Seek(KeyOf(k));
+      iter.Seek(KeyOf(k));
+      ASSERT_EQ(expected.Valid(), iter.Valid());
+
+      if (expected.Valid()) {
+        ASSERT_EQ(expected.key(), iter.key());
+        ASSERT_EQ(expected.sequence(), iter.sequence());
+      }
+    }
+  }
+
+  // Copied range tombstones must not reference the source memtable.
+  auto fragments = compact.GetRangeTombstones();
+  ASSERT_EQ(mem.GetRangeTombstones()->fragments().size(),
+            fragments->fragments().size());
+}
+
+TEST_F(CompactMemTableTest, SharedPrefixes) {
+  // Keys that agree on their first 8 bytes defeat the sparse index, so the
+  // search must fall back to the full comparison.
+  MemTable mem;
+  const int kNumKeys = 1000;
+
+  for (int i = 0; i < kNumKeys; ++i) {
+    mem.Add(i + 1, kTypeValue, "prefix00" + std::to_string(i),
+            std::to_string(i));
+    mem.Add(kNumKeys + i + 1, kTypeValue, std::string(1, 'a' + i % 26), "x");
+  }
+
+  CompactMemTable compact(mem);
+  std::string value;
+
+  for (int i = 0; i < kNumKeys; ++i) {
+    ASSERT_EQ(LookupResult::kFound,
+              compact.Get("prefix00" + std::to_string(i), kMaxSequenceNumber,
+                          &value));
+    ASSERT_EQ(std::to_string(i), value);
+  }
+
+  ASSERT_EQ(LookupResult::kNotFound,
+            compact.Get("prefix00", kMaxSequenceNumber, &value));
+  ASSERT_EQ(LookupResult::kNotFound,
+            compact.Get("prefix01", kMaxSequenceNumber, &value));
+  ASSERT_EQ(LookupResult::kFound, compact.Get("q", kMaxSequenceNumber, &value));
+  ASSERT_EQ(LookupResult::kFound, compact.Get("a", 1500, &value));
+  ASSERT_EQ(LookupResult::kNotFound, compact.Get("a", 1000, &value));
+}
+
+TEST_F(CompactMemTableTest, ScheduleConversion) {
+  ThreadPool pool(2);
+  auto mem = std::make_shared<MemTable>();
+
+  for (uint32_t k = 0; k < 100; ++k) mem->Add(k + 1, kTypeValue, KeyOf(k), "v");
+
+  std::weak_ptr<const MemTable> weak = mem;
+  std::mutex mu;
+  std::condition_variable cv;
+  std::shared_ptr<const CompactMemTable> result;
+  bool done = false;
+
+  CompactMemTable::ScheduleConversion(
+      &pool, std::move(mem),
+      [&](std::shared_ptr<const CompactMemTable> compact) {
+        std::lock_guard<std::mutex> lock(mu);
+        result = std::move(compact);
+        done = true;
+        cv.notify_one();
+      });
+
+  std::unique_lock<std::mutex> lock(mu);
+  cv.wait(lock, [&] { return done; });
+
+  // The skiplist and its arena were released once the conversion finished.
+  ASSERT_TRUE(weak.expired());
+  ASSERT_NE(nullptr, result);
+  ASSERT_EQ(100u, result->NumEntries());
+
+  std::string value;
+  ASSERT_EQ(LookupResult::kFound,
+            result->Get(KeyOf(42), kMaxSequenceNumber, &value));
+  ASSERT_EQ("v", value);
+}
+
+}  // namespace badger
@@ -0,0 +1,137 @@
+#include "cpp-badger/memtable/cuckoo_index.hh"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace badger {
+
+class CuckooIndexTest : public testing::Test {};
+
+static std::string MakeKey(int i) {
+  char buf[16];
+  snprintf(buf, sizeof(buf), "key%06d", i);
+
+  return buf;
+}
+
+static uint64_t ValueOf(int i) { return uint64_t{4096} * i + 7; }
+
+TEST_F(CuckooIndexTest, InsertGetErase) {
+  Arena arena;
+  CuckooIndex index(&arena, 100);
+  uint64_t value = 0;
+
+  ASSERT_FALSE(index.Get("a", &value));
+  ASSERT_TRUE(index.Insert("a", 1));
+  ASSERT_TRUE(index.Insert("", 2));
+  ASSERT_TRUE(index.Get("a", &value));
+  ASSERT_EQ(1u, value);
+  ASSERT_TRUE(index.Get("", &value));
+  ASSERT_EQ(2u, value);
+  ASSERT_EQ(2u, index.Size());
+
+  // Insert() of a present key replaces its value.
+  ASSERT_TRUE(index.Insert("a", 3));
+  ASSERT_TRUE(index.Get("a", &value));
+  ASSERT_EQ(3u, value);
+  ASSERT_EQ(2u, index.Size());
+
+  ASSERT_TRUE(index.Erase("a"));
+  ASSERT_FALSE(index.Erase("a"));
+  ASSERT_FALSE(index.Get("a", &value));
+  ASSERT_EQ(1u, index.Size());
+}
+
+// The table takes its expected number of keys, and more, by moving entries
+// to their other buckets.
+TEST_F(CuckooIndexTest, FillsPastExpectedKeys) {
+  constexpr int kExpected = 10000;
+  Arena arena;
+  CuckooIndex index(&arena, kExpected);
+
+  int inserted = 0;
+  while (index.Insert(MakeKey(inserted), ValueOf(inserted))) ++inserted;
+
+  ASSERT_GE(inserted, kExpected);
+  ASSERT_GT(static_cast<double>(inserted) / index.Capacity(), 0.95);
+  ASSERT_EQ(static_cast<size_t>(inserted), index.Size());
+
+  for (int i = 0; i < inserted; ++i) {
+    uint64_t value = 0;
+    ASSERT_TRUE(index.Get(MakeKey(i), &value)) << i;
+    ASSERT_EQ(ValueOf(i), value);
+  }
+
+  // Erasing makes room again.
+  for (int i = 0; i < kExpected / 10; ++i) ASSERT_TRUE(index.Erase(MakeKey(i)));
+  for (int i = 0; i < kExpected / 10; ++i)
+    ASSERT_TRUE(index.Insert(MakeKey(inserted + i), ValueOf(inserted + i)));
+}
+
+// Readers never miss a key while writers fill the table to near capacity,
+// which forces long cuckoo paths, and erase and update other keys.
+TEST_F(CuckooIndexTest, ManyReadersFewWriters) {
+  constexpr int kStable = 20000;
+  constexpr int kPerWriter = 15000;
+  constexpr int kNumWriters = 2;
+  constexpr int kNumReaders = 6;
+  Arena arena;
+  CuckooIndex index(&arena, kStable + kNumWriters * kPerWriter);
+
+  for (int i = 0; i < kStable; ++i)
+    ASSERT_TRUE(index.Insert(MakeKey(i), ValueOf(i)));
+
+  std::atomic<int> writers_left{kNumWriters};
+  std::atomic<bool> failed{false};
+  std::vector<std::thread> threads;
+
+  for (int t = 0; t < kNumWriters; ++t) {
+    threads.emplace_back([&, t] {
+      const int first = kStable + t * kPerWriter;
+
+      for (int i = first; i < first + kPerWriter; ++i) {
+        if (!index.Insert(MakeKey(i), ValueOf(i))) failed = true;
+        // Churn: erase and re-add every fourth key.
+        if (i % 4 == 0) {
+          if (!index.Erase(MakeKey(i))) failed = true;
+          if (!index.Insert(MakeKey(i), ValueOf(i))) failed = true;
+        }
+      }
+
+      writers_left.fetch_sub(1);
+    });
+  }
+
+  for (int t = 0; t < kNumReaders; ++t) {
+    threads.emplace_back([&, t] {
+      uint64_t value;
+      int i = t;
+
+      do {
+        for (int n = 0; n < 1000; ++n) {
+          i = (i + 7919) % kStable;
+          if (!index.Get(MakeKey(i), &value) || value != ValueOf(i))
+            failed = true;
+        }
+      } while (writers_left.load() > 0);
+    });
+  }
+
+  for (auto& thread : threads) thread.join();
+
+  ASSERT_FALSE(failed.load());
+  ASSERT_EQ(static_cast<size_t>(kStable + kNumWriters * kPerWriter),
+            index.Size());
+
+  for (int i = 0; i < kStable + kNumWriters * kPerWriter; ++i) {
+    uint64_t value = 0;
+    ASSERT_TRUE(index.Get(MakeKey(i), &value)) << i;
+    ASSERT_EQ(ValueOf(i), value);
+  }
+}
+
+}  // namespace badger
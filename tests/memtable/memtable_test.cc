@@ -0,0 +1,450 @@
+#include "cpp-badger/memtable/memtable.hh"
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "cpp-badger/memtable/merge_operator.hh"
+#include "cpp-badger/memtable/range_tombstone_fragmenter.hh"
+#include "cpp-badger/util/coding.hh"
+#include "cpp-badger/util/random.hh"
+#include "cpp-badger/util/statistics.hh"
+
+namespace badger {
+
+class MemTableTest : public testing::Test {};
+
+TEST_F(MemTableTest, PutGetDelete) {
+  MemTable mem;
+  std::string value;
+
+  ASSERT_EQ(LookupResult::kNotFound, mem.Get("k1", kMaxSequenceNumber, &value));
+
+  mem.Add(1, kTypeValue, "k1", "v1");
+  mem.Add(2, kTypeValue, "k2", "v2");
+  mem.Add(3, kTypeValue, "k1", "v1.1");
+  mem.Add(4, kTypeDeletion, "k2", "");
+
+  ASSERT_EQ(LookupResult::kFound, mem.Get("k1", kMaxSequenceNumber, &value));
+  ASSERT_EQ("v1.1", value);
+  ASSERT_EQ(LookupResult::kFound, mem.Get("k1", 2, &value));
+  ASSERT_EQ("v1", value);
+  ASSERT_EQ(LookupResult::kNotFound, mem.Get("k1", 0, &value));
+
+  ASSERT_EQ(LookupResult::kDeleted, mem.Get("k2", kMaxSequenceNumber, &value));
+  ASSERT_EQ(LookupResult::kFound, mem.Get("k2", 3, &value));
+  ASSERT_EQ("v2", value);
+
+  ASSERT_EQ(LookupResult::kNotFound, mem.Get("k", kMaxSequenceNumber, &value));
+  ASSERT_EQ(LookupResult::kNotFound, mem.Get("k3", kMaxSequenceNumber, &value));
+  ASSERT_EQ(4u, mem.NumEntries());
+}
+
+TEST_F(MemTableTest, AddSliceParts) {
+  MemTable mem;
+  std::string value;
+  const Slice key_parts[] = {"us", "er", ":42"};
+  const Slice value_parts[] = {"", "hello", " ", "world"};
+
+  mem.Add(1, kTypeValue, SliceParts(key_parts, 3), SliceParts(value_parts, 4));
+  mem.Add(2, kTypeRangeDeletion, SliceParts(key_parts, 2),
+          SliceParts(key_parts, 3));
+
+  ASSERT_EQ(LookupResult::kFound,
+            mem.Get("user:42", kMaxSequenceNumber, &value));
+  ASSERT_EQ("hello world", value);
+  ASSERT_EQ(LookupResult::kDeleted,
+            mem.Get("user", kMaxSequenceNumber, &value));
+}
+
+TEST_F(MemTableTest, RangeDeletionGet) {
+  MemTable mem;
+  std::string value;
+
+  mem.Add(1, kTypeValue, "a", "va");
+  mem.Add(2, kTypeValue, "b", "vb");
+  mem.Add(3, kTypeValue, "c", "vc");
+  mem.DeleteRange(4, "a", "c");
+  mem.Add(5, kTypeValue, "b", "vb2");
+
+  ASSERT_EQ(1u, mem.NumRangeDeletes());
+  ASSERT_EQ(4u, mem.NumEntries());
+
+  // "a" is covered by the tombstone.
+  ASSERT_EQ(LookupResult::kDeleted, mem.Get("a", kMaxSequenceNumber, &value));
+  ASSERT_EQ(LookupResult::kFound, mem.Get("a", 3, &value));
+  ASSERT_EQ("va", value);
+
+  // "b" was rewritten after the tombstone.
+  ASSERT_EQ(LookupResult::kFound, mem.Get("b", kMaxSequenceNumber, &value));
+  ASSERT_EQ("vb2", value);
+  ASSERT_EQ(LookupResult::kDeleted, mem.Get("b", 4, &value));
+
+  // The end key is exclusive.
+  ASSERT_EQ(LookupResult::kFound, mem.Get("c", kMaxSequenceNumber, &value));
+  ASSERT_EQ("vc", value);
+
+  // Keys without a point entry but inside the range are deleted too.
+  ASSERT_EQ(LookupResult::kDeleted, mem.Get("aa", kMaxSequenceNumber, &value));
+  ASSERT_EQ(LookupResult::kNotFound, mem.Get("aa", 3, &value));
+}
+
+TEST_F(MemTableTest, RangeDeletionIterator) {
+  MemTable mem;
+
+  for (int i = 0; i < 10; ++i) {
+    std::string key = "k" + std::to_string(i);
+    mem.Add(i + 1, kTypeValue, key, "v");
+  }
+
+  mem.DeleteRange(20, "k2", "k5");
+  mem.DeleteRange(21, "k4", "k7");
+
+  std::vector<std::string> keys;
+  MemTable::Iterator iter(&mem, kMaxSequenceNumber);
+
+  for (iter.SeekToFirst(); iter.Valid(); iter.Next())
+    keys.push_back(iter.key().ToString());
+
+  ASSERT_EQ((std::vector<std::string>{"k0", "k1", "k7", "k8", "k9"}), keys);
+
+  keys.clear();
+  for (iter.SeekToLast(); iter.Valid(); iter.Prev())
+    keys.push_back(iter.key().ToString());
+
+  ASSERT_EQ((std::vector<std::string>{"k9", "k8", "k7", "k1", "k0"}), keys);
+
+  iter.Seek("k3");
+  ASSERT_TRUE(iter.Valid());
+  ASSERT_EQ("k7", iter.key().ToString());
+
+  // An older snapshot does not see either tombstone.
+  MemTable::Iterator old_iter(&mem, 19);
+  size_t count = 0;
+
+  for (old_iter.SeekToFirst(); old_iter.Valid(); old_iter.Next()) ++count;
+
+  ASSERT_EQ(10u, count);
+}
+
+TEST_F(MemTableTest, Fragmentation) {
+  std::vector<RangeTombstone> tombstones = {
+      {"a", "e", 10},
+      {"c", "g", 8},
+      {"c", "g", 12},
+      {"x", "x", 20},  // empty, ignored
+  };
+
+  FragmentedRangeTombstoneList list(tombstones);
+
+  ASSERT_EQ(4u, list.num_unfragmented_tombstones());
+
+  const auto& fragments = list.fragments();
+  ASSERT_EQ(3u, fragments.size());
+
+  ASSERT_EQ("a", fragments[0].start.ToString());
+  ASSERT_EQ("c", fragments[0].end.ToString());
+  ASSERT_EQ("c", fragments[1].start.ToString());
+  ASSERT_EQ("e", fragments[1].end.ToString());
+  ASSERT_EQ("e", fragments[2].start.ToString());
+  ASSERT_EQ("g", fragments[2].end.ToString());
+
+  for (size_t i = 1; i < fragments.size(); ++i)
+    ASSERT_LE(fragments[i - 1].end.Compare(fragments[i].start), 0);
+
+  ASSERT_EQ(10u, list.MaxCoveringTombstoneSeqnum("b", kMaxSequenceNumber));
+  ASSERT_EQ(12u, list.MaxCoveringTombstoneSeqnum("d", kMaxSequenceNumber));
+  ASSERT_EQ(10u, list.MaxCoveringTombstoneSeqnum("d", 11));
+  ASSERT_EQ(8u, list.MaxCoveringTombstoneSeqnum("d", 9));
+  ASSERT_EQ(0u, list.MaxCoveringTombstoneSeqnum("d", 7));
+  ASSERT_EQ(12u, list.MaxCoveringTombstoneSeqnum("f", kMaxSequenceNumber));
+  ASSERT_EQ(0u, list.MaxCoveringTombstoneSeqnum("g", kMaxSequenceNumber));
+  ASSERT_EQ(0u, list.MaxCoveringTombstoneSeqnum("0", kMaxSequenceNumber));
+  ASSERT_EQ(0u, list.MaxCoveringTombstoneSeqnum("x", kMaxSequenceNumber));
+}
+
+TEST_F(MemTableTest, InplaceUpdate) {
+  MemTableOptions options;
+  options.inplace_update_support = true;
+  options.inplace_update_num_locks = 16;
+  MemTable mem(options);
+  std::string value;
+
+  mem.Update(1, "counter", "00000001");
+  ASSERT_EQ(0u, mem.NumInplaceUpdates());
+
+  // Same size and smaller values are written in place.
+  mem.Update(2, "counter", "00000002");
+  mem.Update(3, "counter", "3");
+  ASSERT_EQ(2u, mem.NumInplaceUpdates());
+  ASSERT_EQ(1u, mem.NumEntries());
+  ASSERT_EQ(LookupResult::kFound,
+            mem.Get("counter", kMaxSequenceNumber, &value));
+  ASSERT_EQ("3", value);
+
+  // A larger value needs a new entry.
+  mem.Update(4, "counter", "0000000004");
+  ASSERT_EQ(2u, mem.NumInplaceUpdates());
+  ASSERT_EQ(2u, mem.NumEntries());
+  ASSERT_EQ(LookupResult::kFound,
+            mem.Get("counter", kMaxSequenceNumber, &value));
+  ASSERT_EQ("0000000004", value);
+
+  // Deleted entries are never overwritten.
+  mem.Add(5, kTypeDeletion, "counter", "");
+  mem.Update(6, "counter", "6");
+  ASSERT_EQ(2u, mem.NumInplaceUpdates());
+  ASSERT_EQ(LookupResult::kFound,
+            mem.Get("counter", kMaxSequenceNumber, &value));
+  ASSERT_EQ("6", value);
+
+  mem.DeleteRange(7, "a", "z");
+  mem.Update(8, "counter", "8");
+  ASSERT_EQ(2u, mem.NumInplaceUpdates());
+  ASSERT_EQ(LookupResult::kFound,
+            mem.Get("counter", kMaxSequenceNumber, &value));
+  ASSERT_EQ("8", value);
+}
+
+TEST_F(MemTableTest, InplaceUpdateBoundsMemory) {
+  const int kNumKeys = 100;
+  const int kNumUpdates = 100000;
+
+  MemTableOptions options;
+  options.inplace_update_support = true;
+  MemTable inplace(options);
+  MemTable regular;
+
+  for (int i = 0; i < kNumUpdates; ++i) {
+    std::string key = "metric" + std::to_string(i % kNumKeys);
+    char counter[8];
+    memcpy(counter, &i, sizeof(i));
+    memset(counter + sizeof(i), 0, sizeof(counter) - sizeof(i));
+
+    inplace.Update(i + 1, key, Slice(counter, sizeof(counter)));
+    regular.Update(i + 1, key, Slice(counter, sizeof(counter)));
+  }
+
+  ASSERT_EQ(static_cast<uint64_t>(kNumKeys), inplace.NumEntries());
+  ASSERT_EQ(static_cast<uint64_t>(kNumUpdates), regular.NumEntries());
+  ASSERT_LT(inplace.ApproximateMemoryUsage() * 100,
+            regular.ApproximateMemoryUsage());
+
+  std::string value;
+  ASSERT_EQ(LookupResult::kFound, inplace.Get("metric7", kMaxSequenceNumber,
+                                              &value));
+  int last;
+  memcpy(&last, value.data(), sizeof(last));
+  ASSERT_EQ(kNumUpdates - kNumKeys + 7, last);
+}
+
+static std::string EncodeCounter(uint64_t v) {
+  std::string s;
+  PutFixed64(&s, v);
+  return s;
+}
+
+static uint64_t DecodeCounter(const std::string& s) {
+  EXPECT_EQ(sizeof(uint64_t), s.size());
+  return DecodeFixed64(s.data());
+}
+
+TEST_F(MemTableTest, Merge) {
+  MemTableOptions options;
+  options.merge_operator = std::make_shared<UInt64AddOperator>();
+  MemTable mem(options);
+  std::string value;
+
+  // Operands without a base value are combined but left unresolved.
+  mem.Merge(1, "c", EncodeCounter(1));
+  mem.Merge(2, "c", EncodeCounter(2));
+  ASSERT_EQ(LookupResult::kMergeInProgress,
+            mem.Get("c", kMaxSequenceNumber, &value));
+  ASSERT_EQ(3u, DecodeCounter(value));
+
+  // A base value resolves the chain.
+  mem.Add(3, kTypeValue, "c", EncodeCounter(10));
+  mem.Merge(4, "c", EncodeCounter(5));
+  mem.Merge(5, "c", EncodeCounter(7));
+  ASSERT_EQ(LookupResult::kFound, mem.Get("c", kMaxSequenceNumber, &value));
+  ASSERT_EQ(22u, DecodeCounter(value));
+  ASSERT_EQ(LookupResult::kFound, mem.Get("c", 4, &value));
+  ASSERT_EQ(15u, DecodeCounter(value));
+  ASSERT_EQ(LookupResult::kMergeInProgress, mem.Get("c", 1, &value));
+  ASSERT_EQ(1u, DecodeCounter(value));
+
+  // Deletions (point or range) reset the base to "missing".
+  mem.Add(6, kTypeDeletion, "c", "");
+  mem.Merge(7, "c", EncodeCounter(4));
+  ASSERT_EQ(LookupResult::kFound, mem.Get("c", kMaxSequenceNumber, &value));
+  ASSERT_EQ(4u, DecodeCounter(value));
+
+  mem.DeleteRange(8, "a", "d");
+  mem.Merge(9, "c", EncodeCounter(8));
+  ASSERT_EQ(LookupResult::kFound, mem.Get("c", kMaxSequenceNumber, &value));
+  ASSERT_EQ(8u, DecodeCounter(value));
+
+  // Malformed operands fail the merge.
+  mem.Merge(10, "c", "bad");
+  ASSERT_EQ(LookupResult::kMergeFailed,
+            mem.Get("c", kMaxSequenceNumber, &value));
+}
+
+TEST_F(MemTableTest, MaxSuccessiveMerges) {
+  MemTableOptions options;
+  options.merge_operator = std::make_shared<UInt64AddOperator>();
+  options.max_successive_merges = 4;
+  MemTable mem(options);
+  std::string value;
+
+  mem.Add(1, kTypeValue, "base", EncodeCounter(100));
+
+  for (SequenceNumber seq = 2; seq <= 101; ++seq) {
+    mem.Merge(seq, "base", EncodeCounter(1));
+    mem.Merge(seq, "nobase", EncodeCounter(1));
+  }
+
+  ASSERT_EQ(LookupResult::kFound, mem.Get("base", kMaxSequenceNumber, &value));
+  ASSERT_EQ(200u, DecodeCounter(value));
+  ASSERT_EQ(LookupResult::kMergeInProgress,
+            mem.Get("nobase", kMaxSequenceNumber, &value));
+  ASSERT_EQ(100u, DecodeCounter(value));
+
+  // Reads never walk more than max_successive_merges operands once the chain
+  // has a base value.
+  size_t operands = 0;
+  MemTable::Iterator iter(&mem, kMaxSequenceNumber);
+
+  for (iter.Seek("base"); iter.Valid() && iter.type() == kTypeMerge;
+       iter.Next())
+    ++operands;
+
+  ASSERT_LE(operands, options.max_successive_merges);
+}
+
+TEST_F(MemTableTest, MaxSuccessiveMergesWithoutBase) {
+  MemTableOptions options;
+  options.merge_operator = std::make_shared<UInt64AddOperator>();
+  options.max_successive_merges = 4;
+  MemTable mem(options);
+  std::string value;
+
+  for (SequenceNumber seq = 1; seq <= 100; ++seq)
+    mem.Merge(seq, "c", EncodeCounter(seq));
+
+  ASSERT_EQ(LookupResult::kMergeInProgress,
+            mem.Get("c", kMaxSequenceNumber, &value));
+  ASSERT_EQ(5050u, DecodeCounter(value));
+
+  // Older snapshots still see the operands written before them.
+  for (SequenceNumber seq = 1; seq <= 100; ++seq) {
+    ASSERT_EQ(LookupResult::kMergeInProgress, mem.Get("c", seq, &value));
+    ASSERT_EQ(seq * (seq + 1) / 2, DecodeCounter(value));
+  }
+
+  // The chain is cut at a folded operand that combines everything below it.
+  size_t operands = 0;
+  MemTable::Iterator iter(&mem, kMaxSequenceNumber);
+
+  for (iter.Seek("c"); iter.Valid() && iter.type() == kTypeMerge; iter.Next())
+    ++operands;
+
+  ASSERT_TRUE(iter.Valid());
+  ASSERT_EQ(kTypeFoldedMerge, iter.type());
+  ASSERT_LT(operands, options.max_successive_merges);
+
+  // A value written later becomes the base again.
+  mem.Add(101, kTypeValue, "c", EncodeCounter(1));
+  mem.Merge(102, "c", EncodeCounter(1));
+  ASSERT_EQ(LookupResult::kFound, mem.Get("c", kMaxSequenceNumber, &value));
+  ASSERT_EQ(2u, DecodeCounter(value));
+}
+
+// Compares the memtable against a naive model under random writes, point
+// deletes and range deletes.
+TEST_F(MemTableTest, RandomizedAgainstModel) {
+  struct Op {
+    SequenceNumber seq;
+    ValueType type;
+    std::string key;
+    std::string value;
+  };
+
+  Random rnd(301);
+  MemTable mem;
+  std::vector<Op> ops;
+  const int kNumKeys = 50;
+
+  auto key_of = [](uint32_t k) {
+    char buf[16];
+    snprintf(buf, sizeof(buf), "key%03u", k);
+    return std::string(buf);
+  };
+
+  for (SequenceNumber seq = 1; seq <= 2000; ++seq) {
+    Op op{seq, kTypeValue, key_of(rnd.Uniform(kNumKeys)), ""};
+
+    if (rnd.OneIn(10)) {
+      op.type = kTypeDeletion;
+    } else if (rnd.OneIn(20)) {
+      op.type = kTypeRangeDeletion;
+      op.value = key_of(rnd.Uniform(kNumKeys));
+    } else {
+      op.value = "v" + std::to_string(seq);
+    }
+
+    mem.Add(op.seq, op.type, op.key, op.value);
+    ops.push_back(op);
+  }
+
+  for (SequenceNumber snapshot : {SequenceNumber{500}, SequenceNumber{1500},
+                                  kMaxSequenceNumber}) {
+    for (uint32_t k = 0; k <= kNumKeys; ++k) {
+      const std::string key = key_of(k);
+      LookupResult expected = LookupResult::kNotFound;
+      std::string expected_value;
+
+      // Replay in sequence order; later ops win.
+      for (const auto& op : ops) {
+        if (op.seq > snapshot) break;
+
+        if (op.type == kTypeRangeDeletion) {
+          if (op.key <= key && key < op.value)
+            expected = LookupResult::kDeleted;
+        } else if (op.key == key) {
+          expected = op.type == kTypeValue ? LookupResult::kFound
+                                           : LookupResult::kDeleted;
+          expected_value = op.value;
+        }
+      }
+
+      std::string value;
+      ASSERT_EQ(expected, mem.Get(key, snapshot, &value)) << key;
+
+      if (expected == LookupResult::kFound) ASSERT_EQ(expected_value, value);
+    }
+  }
+}
+
+TEST_F(MemTableTest, Statistics) {
+  Statistics stats;
+  MemTableOptions options;
+  options.statistics = &stats;
+  MemTable mem(options);
+
+  for (int i = 0; i < 100; ++i)
+    mem.Add(i + 1, kTypeValue, "key" + std::to_string(i), "value");
+  mem.DeleteRange(101, "a", "b");
+
+  // Each insert allocates an entry and a skiplist node.
+  ASSERT_EQ(101u, stats.GetTickerCount(kSkipListInserts));
+  ASSERT_EQ(101u, stats.GetHistogram(kSkipListInsertNanos).Count());
+  ASSERT_EQ(202u, stats.GetTickerCount(kArenaAllocations));
+  ASSERT_GE(stats.GetTickerCount(kArenaAllocatedBytes),
+            mem.ApproximateMemoryUsage() / 2);
+}
+
+}  // namespace badger
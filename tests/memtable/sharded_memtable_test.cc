@@ -0,0 +1,196 @@
+#include "cpp-badger/memtable/sharded_memtable.hh"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "cpp-badger/memtable/merge_operator.hh"
+#include "cpp-badger/util/coding.hh"
+
+namespace badger {
+
+class ShardedMemTableTest : public testing::Test {};
+
+static std::string MakeKey(int i) {
+  char buf[16];
+  snprintf(buf, sizeof(buf), "key%06d", i);
+
+  return buf;
+}
+
+TEST_F(ShardedMemTableTest, PutGetDelete) {
+  ShardedMemTable mem(4);
+  std::string value;
+
+  mem.Add(1, kTypeValue, "k1", "v1");
+  mem.Add(2, kTypeValue, "k2", "v2");
+  mem.Add(3, kTypeValue, "k1", "v1.1");
+  mem.Add(4, kTypeDeletion, "k2", "");
+
+  ASSERT_EQ(LookupResult::kFound, mem.Get("k1", kMaxSequenceNumber, &value));
+  ASSERT_EQ("v1.1", value);
+  ASSERT_EQ(LookupResult::kFound, mem.Get("k1", 2, &value));
+  ASSERT_EQ("v1", value);
+  ASSERT_EQ(LookupResult::kDeleted, mem.Get("k2", kMaxSequenceNumber, &value));
+  ASSERT_EQ(LookupResult::kNotFound, mem.Get("k3", kMaxSequenceNumber, &value));
+  ASSERT_EQ(4u, mem.NumEntries());
+}
+
+TEST_F(ShardedMemTableTest, AddSliceParts) {
+  ShardedMemTable mem(8);
+  std::string value;
+
+  for (int i = 0; i < 100; ++i) {
+    const std::string key = MakeKey(i);
+    const Slice key_parts[] = {Slice(key.data(), 3), Slice(key.data() + 3, 3),
+                               Slice(key.data() + 6, key.size() - 6)};
+    const SliceParts parts(key_parts, 3);
+
+    ASSERT_EQ(mem.ShardIndex(key), mem.ShardIndex(parts));
+
+    const Slice v = key;
+    mem.Add(i + 1, kTypeValue, parts, SliceParts(&v, 1));
+    ASSERT_EQ(LookupResult::kFound, mem.Get(key, kMaxSequenceNumber, &value));
+    ASSERT_EQ(key, value);
+  }
+}
+
+TEST_F(ShardedMemTableTest, ShardsPartitionKeys) {
+  ShardedMemTable mem(8);
+  const int kNumKeys = 1000;
+
+  for (int i = 0; i < kNumKeys; ++i) mem.Add(i + 1, kTypeValue, MakeKey(i), "");
+
+  uint64_t total = 0;
+
+  for (size_t s = 0; s < mem.NumShards(); ++s) {
+    const MemTable& shard = mem.GetShard(s);
+
+    // Every shard gets a share of the keys, and only keys routed to it.
+    ASSERT_GT(shard.NumEntries(), 0u);
+    total += shard.NumEntries();
+
+    MemTable::Iterator iter(&shard, kMaxSequenceNumber);
+    for (iter.SeekToFirst(); iter.Valid(); iter.Next())
+      ASSERT_EQ(s, mem.ShardIndex(iter.key()));
+  }
+
+  ASSERT_EQ(static_cast<uint64_t>(kNumKeys), total);
+}
+
+TEST_F(ShardedMemTableTest, MergingIterator) {
+  ShardedMemTable mem(4);
+  SequenceNumber seq = 0;
+
+  for (int i = 0; i < 100; ++i) mem.Add(++seq, kTypeValue, MakeKey(i), "a");
+  for (int i = 0; i < 100; i += 2) mem.Add(++seq, kTypeValue, MakeKey(i), "b");
+
+  ShardedMemTable::Iterator iter(&mem, kMaxSequenceNumber);
+  std::string prev_key;
+  SequenceNumber prev_seq = 0;
+  size_t count = 0;
+
+  for (iter.SeekToFirst(); iter.Valid(); iter.Next(), ++count) {
+    std::string key = iter.key().ToString();
+
+    if (count > 0) {
+      ASSERT_LE(prev_key, key);
+      if (prev_key == key) ASSERT_GT(prev_seq, iter.sequence());
+    }
+
+    prev_key = key;
+    prev_seq = iter.sequence();
+  }
+
+  ASSERT_EQ(150u, count);
+
+  iter.Seek(MakeKey(50));
+  ASSERT_TRUE(iter.Valid());
+  ASSERT_EQ(MakeKey(50), iter.key().ToString());
+  ASSERT_EQ("b", iter.value().ToString());
+  iter.Next();
+  ASSERT_EQ(MakeKey(50), iter.key().ToString());
+  ASSERT_EQ("a", iter.value().ToString());
+  iter.Next();
+  ASSERT_EQ(MakeKey(51), iter.key().ToString());
+
+  iter.Seek("zzz");
+  ASSERT_FALSE(iter.Valid());
+}
+
+TEST_F(ShardedMemTableTest, RangeDeletionSpansShards) {
+  ShardedMemTable mem(4);
+  std::string value;
+
+  for (int i = 0; i < 100; ++i) mem.Add(i + 1, kTypeValue, MakeKey(i), "v");
+
+  mem.DeleteRange(1000, MakeKey(10), MakeKey(90));
+
+  for (int i = 0; i < 100; ++i) {
+    LookupResult expected = (i >= 10 && i < 90) ? LookupResult::kDeleted
+                                                : LookupResult::kFound;
+    ASSERT_EQ(expected, mem.Get(MakeKey(i), kMaxSequenceNumber, &value));
+  }
+
+  ShardedMemTable::Iterator iter(&mem, kMaxSequenceNumber);
+  size_t count = 0;
+
+  for (iter.SeekToFirst(); iter.Valid(); iter.Next()) ++count;
+
+  ASSERT_EQ(20u, count);
+}
+
+TEST_F(ShardedMemTableTest, ConcurrentWriters) {
+  MemTableOptions options;
+  options.merge_operator = std::make_shared<UInt64AddOperator>();
+  ShardedMemTable mem(8, options);
+
+  const int kNumThreads = 4;
+  const int kKeysPerThread = 2000;
+  const int kNumCounters = 16;
+  std::atomic<SequenceNumber> seq{0};
+  std::vector<std::thread> threads;
+
+  for (int t = 0; t < kNumThreads; ++t) {
+    threads.emplace_back([&, t] {
+      std::string one;
+      PutFixed64(&one, 1);
+
+      for (int i = 0; i < kKeysPerThread; ++i) {
+        mem.Add(seq.fetch_add(1) + 1, kTypeValue,
+                MakeKey(t * kKeysPerThread + i), "v");
+        mem.Merge(seq.fetch_add(1) + 1,
+                  "counter" + std::to_string(i % kNumCounters), one);
+      }
+    });
+  }
+
+  for (auto& thread : threads) thread.join();
+
+  std::string value;
+
+  for (int i = 0; i < kNumThreads * kKeysPerThread; ++i)
+    ASSERT_EQ(LookupResult::kFound,
+              mem.Get(MakeKey(i), kMaxSequenceNumber, &value));
+
+  for (int c = 0; c < kNumCounters; ++c) {
+    ASSERT_EQ(LookupResult::kMergeInProgress,
+              mem.Get("counter" + std::to_string(c), kMaxSequenceNumber,
+                      &value));
+    ASSERT_EQ(static_cast<uint64_t>(kNumThreads * kKeysPerThread /
+                                    kNumCounters),
+              DecodeFixed64(value.data()));
+  }
+
+  ShardedMemTable::Iterator iter(&mem, kMaxSequenceNumber);
+  size_t count = 0;
+
+  for (iter.Seek("key"); iter.Valid(); iter.Next()) ++count;
+
+  ASSERT_EQ(static_cast<size_t>(kNumThreads * kKeysPerThread), count);
+}
+
+}  // namespace badger
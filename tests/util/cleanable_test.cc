@@ -5,7 +5,10 @@
 
 #include <gtest/gtest.h>
 
+#include <cstdint>
 #include <functional>
+#include <thread>
+#include <vector>
 
 #include "cpp-badger/util/slice.hh"
 
@@ -372,6 +375,132 @@ TEST_F(CleanableTest, CleanableWrapShared) {
   ASSERT_EQ(val, 0);
 }
 
+TEST_F(CleanableTest, RefBatch) {
+  int val = 1;
+  SharedCleanablePtr scp;
+  scp.Allocate();
+  scp->RegisterCleanup(&Decrement, &val, nullptr);
+
+  {
+    std::vector<Cleanable> targets(10);
+    {
+      SharedCleanablePtr::RefBatch batch(scp, 4);
+      for (auto& target : targets) batch.RegisterCopyWith(&target);
+    }
+
+    // Unused references are returned with the batch.
+    scp.Reset();
+    ASSERT_EQ(1, val);
+
+    targets.resize(1);
+    ASSERT_EQ(1, val);
+  }
+
+  ASSERT_EQ(0, val);
+
+  // A batch over a null pointer hands out nothing.
+  SharedCleanablePtr null_scp;
+  Cleanable target;
+  SharedCleanablePtr::RefBatch batch(null_scp, 4);
+  batch.RegisterCopyWith(&target);
+  ASSERT_FALSE(target.HasCleanups());
+}
+
+TEST_F(CleanableTest, DeferredUnref) {
+  int val1 = 1;
+  int val2 = 1;
+  SharedCleanablePtr scp1;
+  SharedCleanablePtr scp2;
+  scp1.Allocate();
+  scp1->RegisterCleanup(&Decrement, &val1, nullptr);
+  scp2.Allocate();
+  scp2->RegisterCleanup(&Decrement, &val2, nullptr);
+
+  {
+    std::vector<Cleanable> targets(1000);
+    SharedCleanablePtr::RefBatch batch1(scp1, 100, /*defer_unref=*/true);
+    SharedCleanablePtr::RefBatch batch2(scp2, 100, /*defer_unref=*/true);
+
+    for (size_t i = 0; i < targets.size(); ++i)
+      (i % 2 == 0 ? batch1 : batch2).RegisterCopyWith(&targets[i]);
+  }
+
+  scp1.Reset();
+  scp2.Reset();
+
+  // The last references to each are still queued.
+  ASSERT_EQ(1, val1);
+  ASSERT_EQ(1, val2);
+
+  SharedCleanablePtr::FlushDeferredUnrefs();
+  ASSERT_EQ(0, val1);
+  ASSERT_EQ(0, val2);
+
+  // Queued references are released when the thread exits.
+  int val3 = 1;
+  scp1.Allocate();
+  scp1->RegisterCleanup(&Decrement, &val3, nullptr);
+
+  std::thread thread([&scp1] {
+    Cleanable target;
+    SharedCleanablePtr::RefBatch batch(scp1, 1, /*defer_unref=*/true);
+    batch.RegisterCopyWith(&target);
+  });
+  thread.join();
+  scp1.Reset();
+
+  ASSERT_EQ(0, val3);
+}
+
+static void Append(void* vec, void* value) {
+  static_cast<std::vector<int>*>(vec)->push_back(
+      static_cast<int>(reinterpret_cast<intptr_t>(value)));
+}
+
+static void* IntArg(int i) { return reinterpret_cast<void*>(intptr_t{i}); }
+
+TEST_F(CleanableTest, OrderAndSplice) {
+  std::vector<int> order;
+
+  {
+    Cleanable a;
+    Cleanable b;
+    Cleanable c;
+
+    for (int i = 0; i < 3; ++i) a.RegisterCleanup(&Append, &order, IntArg(i));
+    for (int i = 3; i < 6; ++i) b.RegisterCleanup(&Append, &order, IntArg(i));
+    c.RegisterCleanup(&Append, &order, IntArg(6));
+
+    // Splice a list whose tail is a heap node, then one whose tail is the
+    // embedded head, and keep appending to the result.
+    b.DelegateCleanupsTo(&a);
+    c.DelegateCleanupsTo(&a);
+    a.RegisterCleanup(&Append, &order, IntArg(7));
+    ASSERT_FALSE(b.HasCleanups());
+    ASSERT_FALSE(c.HasCleanups());
+
+    // Delegating into an empty Cleanable adopts the list as is.
+    Cleanable d;
+    a.DelegateCleanupsTo(&d);
+    d.RegisterCleanup(&Append, &order, IntArg(8));
+
+    // Moves keep the tail consistent, including for single-entry lists.
+    Cleanable e(std::move(d));
+    e.RegisterCleanup(&Append, &order, IntArg(9));
+
+    Cleanable f;
+    f.RegisterCleanup(&Append, &order, IntArg(10));
+    Cleanable g;
+    g = std::move(f);
+    g.RegisterCleanup(&Append, &order, IntArg(11));
+    g.DelegateCleanupsTo(&e);
+
+    ASSERT_TRUE(order.empty());
+  }
+
+  ASSERT_EQ(std::vector<int>({0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11}), order);
+}
+
 }  // namespace badger
 
 int main(int argc, char** argv) {
@@ -0,0 +1,283 @@
+#include "cpp-badger/util/hash.hh"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "cpp-badger/util/random.hh"
+#include "cpp-badger/util/slice.hh"
+
+namespace badger {
+
+static std::string TestData(size_t n) {
+  std::string data(n, '\0');
+
+  for (size_t i = 0; i < n; ++i) data[i] = static_cast<char>(i * 131 + 7);
+
+  return data;
+}
+
+static std::string RandomKey(Random* rnd, size_t n) {
+  std::string key(n, '\0');
+
+  for (auto& c : key) c = static_cast<char>(rnd->Uniform(256));
+
+  return key;
+}
+
+// The outputs are persisted, so they must never change. The expected values
+// come from xxHash 0.8 (XXH3_64bits_withSeed / XXH3_128bits_withSeed) and
+// cover every size class.
+TEST(HashTest, KnownValues) {
+  struct Case {
+    size_t n;
+    uint64_t seed;
+    uint64_t hash64;
+    Hash128Value hash128;
+  };
+
+  const Case cases[] = {
+      {0, 0, 0x2d06800538d394c2, {0x6001c324468d497f, 0x99aa06d3014798d8}},
+      {0, 42, 0xb029411ff43d84d2, {0x3c1d09e9fe249164, 0x16c20acd33f7af2f}},
+      {1, 0, 0x4c5cca45d0f4811f, {0x4c5cca45d0f4811f, 0x495b62073ef70ca4}},
+      {1, 42, 0xc72384329881f542, {0xc72384329881f542, 0x8f345f94f33c2b82}},
+      {3, 0, 0x6e3e2670e61106ac, {0x6e3e2670e61106ac, 0x390cdc5b4a895dd7}},
+      {3, 42, 0x06be808a0f1e13d6, {0x06be808a0f1e13d6, 0x307572e8ae2fb3eb}},
+      {4, 0, 0x5c4c63133443d03f, {0x3d668af6f2a44d77, 0xaa6e2f274640a3f4}},
+      {4, 42, 0xcca1c5c31699ed91, {0x2d02187ab4c4fda3, 0x64dcdeb0f7fc88f8}},
+      {8, 0, 0xf9fd4dd0b04d78f5, {0x61ddbe7f31a6100d, 0x6a86a3bda6af4e3d}},
+      {8, 42, 0x859ee438a590e13d, {0x93a3e4d1d6db2f9c, 0xd57d3e54d7389077}},
+      {9, 0, 0x7c20df9712c26edf, {0x8c7b67fd458a936b, 0x664c7ca18afd6255}},
+      {9, 42, 0x18d8d7990efdce09, {0xabc3fe63a0fd9753, 0x43343712afe5b48b}},
+      {16, 0, 0x86abf6baccea0858, {0xe2ce54a7c19c730d, 0x7f9a218b0425449a}},
+      {16, 42, 0x3dfb7c5ae85844fe, {0x6fbadfeb3524a71b, 0x68b3467254351145}},
+      {17, 0, 0xb58bf5dc5022d071, {0x8d96ef110fcdebb4, 0x66fc23f6439dbd77}},
+      {17, 42, 0x75bb843c3df21312, {0x024e4888a660fbb7, 0x230f3ceec96bd7cc}},
+      {128, 0, 0x10d17f72c0ccba41, {0xff361dec1385710a, 0xaec730751478556c}},
+      {128, 42, 0xa80975a8e9c98d88, {0x171bb64b0adfe7bf, 0x03ca45c0042ea13d}},
+      {129, 0, 0x1648bdc3db49d1a2, {0x4545b3a09738e31a, 0x98cd36ccbb557926}},
+      {129, 42, 0xb5978592da15b4c3, {0xed566543306953ce, 0x6b6bb77d4e61020e}},
+      {240, 0, 0xb6cfaf343fab81e6, {0x3f2c53e72293711f, 0x5293e17bf553903d}},
+      {240, 42, 0xd865d0b2178586a4, {0xc367a4f83f189410, 0x3b33473fb0b4c8aa}},
+      {241, 0, 0x956cae592c67279e, {0x956cae592c67279e, 0xb53840fe3fedf161}},
+      {241, 42, 0xf10c69779cba8524, {0xf10c69779cba8524, 0x58f5c060087c57e4}},
+      {1024, 0, 0x70bd377d9574f4bb, {0x70bd377d9574f4bb, 0xf69630613f24324d}},
+      {1024, 42, 0x0052d93f0342f851, {0x0052d93f0342f851, 0x233cba2f58871cf5}},
+      {2000, 0, 0xf7d78023f8a2c2b7, {0xf7d78023f8a2c2b7, 0x2502e02dac16cce9}},
+      {2000, 42, 0xa9d21f8b3e8955b1, {0xa9d21f8b3e8955b1, 0xb7e3f90b1e41599b}},
+  };
+
+  const std::string data = TestData(2000);
+
+  for (const auto& c : cases) {
+    ASSERT_EQ(c.hash64, Hash64(data.data(), c.n, c.seed)) << c.n;
+    ASSERT_EQ(c.hash128, Hash128(data.data(), c.n, c.seed)) << c.n;
+  }
+}
+
+// Flipping any input bit must flip every output bit with probability 1/2.
+// The lengths cover every size class; long inputs sample their input bits.
+TEST(HashTest, Avalanche) {
+  constexpr int kTrials = 1000;
+  constexpr double kMaxBias = 0.1;
+  Random rnd(301);
+
+  for (size_t len : {2, 3, 4, 8, 12, 16, 24, 64, 100, 200, 256, 1500}) {
+    const size_t input_bits = 8 * len;
+    const size_t step = input_bits <= 512 ? 1 : input_bits / 256;
+    std::vector<int> flips64(input_bits * 64);
+    std::vector<int> flips128(input_bits * 128);
+
+    for (int t = 0; t < kTrials; ++t) {
+      std::string key = RandomKey(&rnd, len);
+      const uint64_t h64 = Hash64(key.data(), len);
+      const Hash128Value h128 = Hash128(key.data(), len);
+
+      for (size_t bit = 0; bit < input_bits; bit += step) {
+        key[bit / 8] ^= static_cast<char>(1 << (bit % 8));
+        const uint64_t d64 = h64 ^ Hash64(key.data(), len);
+        const Hash128Value f128 = Hash128(key.data(), len);
+        const uint64_t d_lo = h128.lo ^ f128.lo;
+        const uint64_t d_hi = h128.hi ^ f128.hi;
+        key[bit / 8] ^= static_cast<char>(1 << (bit % 8));
+
+        for (int o = 0; o < 64; ++o) {
+          flips64[bit * 64 + o] += (d64 >> o) & 1;
+          flips128[bit * 128 + o] += (d_lo >> o) & 1;
+          flips128[bit * 128 + 64 + o] += (d_hi >> o) & 1;
+        }
+      }
+    }
+
+    for (size_t bit = 0; bit < input_bits; bit += step) {
+      for (int o = 0; o < 64; ++o)
+        ASSERT_NEAR(0.5, flips64[bit * 64 + o] / double{kTrials}, kMaxBias)
+            << "len " << len << " bit " << bit << " -> " << o;
+
+      for (int o = 0; o < 128; ++o)
+        ASSERT_NEAR(0.5, flips128[bit * 128 + o] / double{kTrials}, kMaxBias)
+            << "len " << len << " bit " << bit << " -> " << o;
+    }
+  }
+}
+
+// Structured key sets that trip up weak hashes: sequential integers and
+// keys with only one or two bits set.
+TEST(HashTest, NoCollisions) {
+  std::unordered_set<uint64_t> seen64;
+  std::unordered_set<uint64_t> seen128;
+  size_t keys = 0;
+
+  auto add = [&](const std::string& key) {
+    ++keys;
+    const Hash128Value h = Hash128(key.data(), key.size());
+    ASSERT_TRUE(seen64.insert(Hash64(key.data(), key.size())).second);
+    ASSERT_TRUE(seen128.insert(h.lo ^ std::rotl(h.hi, 17)).second);
+  };
+
+  for (uint64_t i = 0; i < 200000; ++i) {
+    std::string key(reinterpret_cast<const char*>(&i), sizeof(i));
+    add(key);
+    add(std::to_string(i));
+  }
+
+  for (size_t len : {16, 32, 200}) {
+    for (size_t a = 0; a < 8 * len; ++a) {
+      std::string key(len, '\0');
+      key[a / 8] ^= static_cast<char>(1 << (a % 8));
+      add(key);
+
+      for (size_t b = a + 1; b < 8 * len && len <= 32; ++b) {
+        key[b / 8] ^= static_cast<char>(1 << (b % 8));
+        add(key);
+        key[b / 8] ^= static_cast<char>(1 << (b % 8));
+      }
+    }
+  }
+
+  ASSERT_EQ(keys, seen64.size());
+}
+
+// Buckets taken from the low and high bits are filled evenly (chi-square).
+TEST(HashTest, Distribution) {
+  constexpr size_t kBuckets = 1024;
+  constexpr size_t kKeys = 256 * kBuckets;
+  std::vector<int> low(kBuckets);
+  std::vector<int> high(kBuckets);
+
+  for (uint64_t i = 0; i < kKeys; ++i) {
+    const uint64_t h = Hash64(reinterpret_cast<const char*>(&i), sizeof(i));
+    ++low[h % kBuckets];
+    ++high[h >> 54];
+  }
+
+  for (const auto& buckets : {low, high}) {
+    const double expected = double{kKeys} / kBuckets;
+    double chi2 = 0;
+
+    for (int count : buckets)
+      chi2 += (count - expected) * (count - expected) / expected;
+
+    // 1023 degrees of freedom: mean 1023, standard deviation ~45.
+    ASSERT_LT(chi2, 1023 + 6 * 45);
+  }
+}
+
+// Unlike hash(), neighbouring seeds give unrelated outputs.
+TEST(HashTest, SeedIndependence) {
+  Random rnd(301);
+  double total_bits = 0;
+  int samples = 0;
+
+  for (uint64_t seed = 0; seed < 1000; ++seed) {
+    const std::string key = RandomKey(&rnd, 1 + rnd.Uniform(300));
+    const uint64_t a = Hash64(key.data(), key.size(), seed);
+    const uint64_t b = Hash64(key.data(), key.size(), seed + 1);
+    total_bits += std::popcount(a ^ b);
+    ++samples;
+  }
+
+  ASSERT_NEAR(32.0, total_bits / samples, 1.0);
+}
+
+// HashBatch() matches Hash64() whether a batch of keys takes one of the
+// side-by-side paths or the per-key fallback, and for any count.
+TEST(HashTest, HashBatch) {
+  Random rnd(301);
+
+  for (auto [min_size, max_size] : {std::pair<size_t, size_t>{9, 16},
+                                    {17, 32},
+                                    {16, 33},
+                                    {0, 300},
+                                    {0, 5000}}) {
+    std::vector<std::string> storage;
+    std::vector<Slice> keys;
+    for (int i = 0; i < 203; ++i) {
+      const size_t n = min_size + rnd.Uniform(max_size - min_size + 1);
+      storage.push_back(RandomKey(&rnd, n));
+    }
+    for (const auto& key : storage) keys.emplace_back(key);
+
+    for (size_t n : {0, 1, 3, 4, 5, 12, 13, 203}) {
+      std::vector<uint64_t> out(n + 1, 42);
+      HashBatch(keys.data(), n, out.data());
+
+      for (size_t i = 0; i < n; ++i)
+        ASSERT_EQ(Hash64(keys[i].data(), keys[i].size()), out[i]);
+      ASSERT_EQ(42u, out[n]);
+    }
+  }
+}
+
+// Whatever the pieces, StreamingHash gives the one-shot hash of their
+// concatenation, including across the short/long boundary and the 1 KiB
+// blocks of the long path.
+TEST(HashTest, StreamingHash) {
+  Random rnd(301);
+  const std::string data = RandomKey(&rnd, 5000);
+
+  for (uint64_t seed : {uint64_t{0}, uint64_t{42}}) {
+    for (size_t n = 0; n <= data.size(); n += (n < 1100 ? 1 : 97)) {
+      const uint64_t expected64 = Hash64(data.data(), n, seed);
+      const Hash128Value expected128 = Hash128(data.data(), n, seed);
+
+      for (size_t max_piece : {size_t{1}, size_t{7}, size_t{300}, n + 1}) {
+        StreamingHash hasher(seed);
+        for (size_t pos = 0; pos < n;) {
+          const size_t k =
+              std::min<size_t>(n - pos, 1 + rnd.Uniform(max_piece));
+          hasher.Update(data.data() + pos, k);
+          pos += k;
+        }
+
+        ASSERT_EQ(expected64, hasher.Final64()) << n << " " << max_piece;
+        ASSERT_EQ(expected128, hasher.Final128()) << n << " " << max_piece;
+      }
+    }
+  }
+}
+
+TEST(HashTest, StreamingHashReuse) {
+  const std::string data = TestData(1000);
+  StreamingHash hasher;
+
+  // Final*() leaves the state alone, so hashing may go on afterwards.
+  for (size_t n = 0; n < data.size(); n += 100) {
+    ASSERT_EQ(Hash64(data.data(), n), hasher.Final64());
+    hasher.Update(data.data() + n, 100);
+  }
+  ASSERT_EQ(Hash128(data.data(), data.size()), hasher.Final128());
+
+  hasher.Init(7);
+  const Slice parts[] = {Slice(data.data(), 10), Slice(),
+                         Slice(data.data() + 10, 290)};
+  hasher.Update(SliceParts(parts, 3));
+  ASSERT_EQ(Hash64(data.data(), 300, 7), hasher.Final64());
+}
+
+}  // namespace badger
@@ -0,0 +1,119 @@
+#include "cpp-badger/util/hex.hh"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "cpp-badger/util/random.hh"
+#include "cpp-badger/util/slice.hh"
+
+namespace badger {
+
+static std::vector<std::pair<HexEncodeFunction, HexDecodeFunction>>
+AllKernels() {
+  std::vector<std::pair<HexEncodeFunction, HexDecodeFunction>> kernels = {
+      {HexEncodeScalar, HexDecodeScalar}, {HexEncode, HexDecode}};
+#ifdef BADGER_HAVE_X86_HEX
+  kernels.emplace_back(HexEncodeSSE2, HexDecodeSSE2);
+  if (__builtin_cpu_supports("avx2"))
+    kernels.emplace_back(HexEncodeAVX2, HexDecodeAVX2);
+#endif
+
+  return kernels;
+}
+
+static std::string NaiveHex(const std::string& s) {
+  static const char kDigits[] = "0123456789abcdef";
+  std::string result;
+
+  for (unsigned char c : s) {
+    result.push_back(kDigits[c >> 4]);
+    result.push_back(kDigits[c & 0xf]);
+  }
+
+  return result;
+}
+
+TEST(HexTest, RoundTripEveryLength) {
+  Random rnd(301);
+
+  for (size_t n = 0; n < 200; ++n) {
+    std::string bytes(n, '\0');
+    for (auto& c : bytes) c = static_cast<char>(rnd.Uniform(256));
+    const std::string expected = NaiveHex(bytes);
+
+    for (const auto& [encode, decode] : AllKernels()) {
+      std::string hex(2 * n, '\0');
+      encode(bytes.data(), n, hex.data());
+      ASSERT_EQ(expected, hex) << n;
+
+      // Decoding accepts either case.
+      for (bool mixed_case : {false, true}) {
+        std::string digits = hex;
+        for (auto& c : digits)
+          if (mixed_case && c >= 'a' && rnd.OneIn(2))
+            c = static_cast<char>(c - 'a' + 'A');
+
+        std::string decoded(n, '\0');
+        ASSERT_TRUE(decode(digits.data(), digits.size(), decoded.data()));
+        ASSERT_EQ(bytes, decoded) << n;
+      }
+    }
+  }
+}
+
+TEST(HexTest, RejectsInvalidDigits) {
+  const std::string valid(150, 'a');
+
+  for (const auto& [encode, decode] : AllKernels()) {
+    std::string out(valid.size(), '\0');
+    ASSERT_FALSE(decode(valid.data(), 3, out.data()));
+    ASSERT_FALSE(decode(valid.data(), valid.size() - 1, out.data()));
+
+    // Every position, including the overlapping tail block, is checked.
+    for (size_t i = 0; i < valid.size(); ++i) {
+      for (char bad : {'g', 'G', '/', ':', '@', '`', ' ', '\0', '\x80',
+                       '\xb0', '\xff'}) {
+        std::string digits = valid;
+        digits[i] = bad;
+        ASSERT_FALSE(decode(digits.data(), digits.size(), out.data()))
+            << i << " " << static_cast<int>(bad);
+      }
+    }
+  }
+}
+
+TEST(HexTest, Slice) {
+  const std::string bytes("\x00\x01\x7f\x80\xfe\xff", 6);
+  const std::string hex = Slice(bytes).ToString(true);
+  std::string decoded = "previous";
+
+  ASSERT_EQ("00017f80feff", hex);
+  ASSERT_TRUE(Slice(hex).DecodeHex(decoded));
+  ASSERT_EQ(bytes, decoded);
+
+  ASSERT_FALSE(Slice("0g").DecodeHex(decoded));
+  ASSERT_TRUE(decoded.empty());
+
+  char buf[12];
+  ASSERT_EQ(buf + 12, Slice(bytes).EncodeHex(buf));
+  ASSERT_EQ(hex, std::string(buf, 12));
+
+  char out[6];
+  ASSERT_TRUE(Slice("00017F80FEFF").DecodeHex(out));
+  ASSERT_EQ(bytes, std::string(out, 6));
+}
+
+TEST(HexTest, KernelName) {
+  const std::string name = HexKernelName();
+
+#ifdef BADGER_HAVE_X86_HEX
+  ASSERT_EQ(__builtin_cpu_supports("avx2") ? "avx2" : "sse2", name);
+#else
+  ASSERT_EQ("scalar", name);
+#endif
+}
+
+}  // namespace badger
@@ -0,0 +1,80 @@
+#include "cpp-badger/util/histogram.hh"
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <cstdint>
+
+namespace badger {
+
+TEST(HistogramTest, Empty) {
+  Histogram h;
+
+  ASSERT_EQ(0u, h.Count());
+  ASSERT_EQ(0u, h.Min());
+  ASSERT_EQ(0u, h.Max());
+  ASSERT_EQ(0, h.Average());
+  ASSERT_EQ(0, h.Percentile(50));
+}
+
+// Every value lands in a bucket whose range holds it, and buckets are
+// ordered.
+TEST(HistogramTest, Buckets) {
+  for (uint64_t v : {uint64_t{0}, uint64_t{1}, uint64_t{15}, uint64_t{16},
+                     uint64_t{17}, uint64_t{1000}, uint64_t{123456789},
+                     UINT64_MAX / 3, UINT64_MAX}) {
+    const int i = Histogram::BucketIndex(v);
+
+    ASSERT_GE(i, 0);
+    ASSERT_LT(i, Histogram::kNumBuckets);
+    ASSERT_LE(Histogram::BucketLow(i), v);
+    if (i + 1 < Histogram::kNumBuckets)
+      ASSERT_LT(v, Histogram::BucketLow(i + 1));
+  }
+
+  for (int i = 1; i < Histogram::kNumBuckets; ++i) {
+    ASSERT_LT(Histogram::BucketLow(i - 1), Histogram::BucketLow(i));
+    ASSERT_EQ(i, Histogram::BucketIndex(Histogram::BucketLow(i)));
+  }
+}
+
+TEST(HistogramTest, Percentiles) {
+  Histogram h;
+
+  for (uint64_t v = 1; v <= 100000; ++v) h.Add(v);
+
+  ASSERT_EQ(100000u, h.Count());
+  ASSERT_EQ(1u, h.Min());
+  ASSERT_EQ(100000u, h.Max());
+  ASSERT_DOUBLE_EQ(50000.5, h.Average());
+
+  // Within a bucket, which is at most 1/16 of the value wide.
+  for (double p : {1.0, 50.0, 90.0, 99.0, 99.9}) {
+    const double expected = p * 1000;
+    ASSERT_NEAR(expected, h.Percentile(p), expected / 16) << p;
+  }
+  ASSERT_EQ(100000, h.Percentile(100));
+}
+
+TEST(HistogramTest, MergeAndClear) {
+  Histogram a;
+  Histogram b;
+
+  for (int i = 0; i < 90; ++i) a.Add(10);
+  for (int i = 0; i < 10; ++i) b.Add(1000000);
+  a.Merge(b);
+
+  ASSERT_EQ(100u, a.Count());
+  ASSERT_EQ(10u, a.Min());
+  ASSERT_EQ(1000000u, a.Max());
+  ASSERT_NEAR(10, a.Percentile(50), 1);
+  ASSERT_NEAR(1000000, a.Percentile(95), 1000000 / 16);
+
+  a.Clear();
+  ASSERT_EQ(0u, a.Count());
+  ASSERT_EQ(0u, a.Max());
+  a.Add(5);
+  ASSERT_EQ(5u, a.Min());
+}
+
+}  // namespace badger
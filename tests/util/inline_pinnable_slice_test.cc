@@ -0,0 +1,149 @@
+#include "cpp-badger/util/inline_pinnable_slice.hh"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <string>
+
+// Counts heap allocations so that tests can assert that none happen.
+static std::atomic<size_t> num_allocations{0};
+
+void* operator new(size_t size) {
+  num_allocations.fetch_add(1, std::memory_order_relaxed);
+
+  if (void* p = std::malloc(size == 0 ? 1 : size)) return p;
+
+  throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+
+namespace badger {
+
+static bool Within(const Slice& s, const void* begin, size_t n) {
+  const char* b = static_cast<const char*>(begin);
+
+  return s.data() >= b && s.data() + s.size() <= b + n;
+}
+
+TEST(InlinePinnableSliceTest, SmallValuesStayInline) {
+  const std::string value(512, 'v');
+  InlinePinnableSlice<512> slice;
+
+  const size_t before = num_allocations.load();
+  slice.PinSelf(Slice(value.data(), 300));
+  slice.Reset();
+  slice.PinSelf(value);
+  ASSERT_EQ(before, num_allocations.load());
+
+  ASSERT_TRUE(Within(slice, &slice, sizeof(slice)));
+  ASSERT_EQ(std::string(512, 'v'), slice.ToString());
+  ASSERT_FALSE(slice.IsPinned());
+}
+
+TEST(InlinePinnableSliceTest, LargeValuesUseArena) {
+  Arena arena(64 * 1024);
+  const std::string value(2000, 'x');
+  InlinePinnableSlice<512> slice(&arena);
+
+  const size_t before = num_allocations.load();
+  slice.PinSelf(value);
+  ASSERT_EQ(before, num_allocations.load());
+
+  ASSERT_FALSE(Within(slice, &slice, sizeof(slice)));
+  ASSERT_EQ(value, slice.ToString());
+  ASSERT_EQ(2000u, arena.ApproximateMemoryUsage());
+}
+
+TEST(InlinePinnableSliceTest, LargeValuesWithoutArena) {
+  const std::string value(2000, 'x');
+  InlinePinnableSlice<64> slice;
+
+  slice.PinSelf(value);
+  ASSERT_EQ(value, slice.ToString());
+  ASSERT_EQ(slice.data(), slice.GetSelf()->data());
+
+  // Small values go back to the inline buffer.
+  slice.Reset();
+  slice.PinSelf("small");
+  ASSERT_TRUE(Within(slice, &slice, sizeof(slice)));
+  ASSERT_EQ("small", slice.ToString());
+}
+
+TEST(InlinePinnableSliceTest, RemovePrefixSuffix) {
+  InlinePinnableSlice<32> slice;
+
+  slice.PinSelf("0123456789");
+  slice.RemovePrefix(2);
+  slice.RemoveSuffix(3);
+  ASSERT_EQ("23456", slice.ToString());
+
+  // Copying from the current contents must be safe.
+  slice.PinSelf(Slice(slice.data() + 1, 3));
+  ASSERT_EQ("345", slice.ToString());
+}
+
+TEST(InlinePinnableSliceTest, PinSlice) {
+  const std::string value = "external";
+  InlinePinnableSlice<32> slice;
+  int cleanups = 0;
+
+  slice.PinSlice(
+      value, [](void* arg, void*) { ++*static_cast<int*>(arg); }, &cleanups,
+      nullptr);
+  ASSERT_TRUE(slice.IsPinned());
+  ASSERT_EQ(value.data(), slice.data());
+
+  slice.Reset();
+  ASSERT_EQ(1, cleanups);
+
+  slice.PinSelf("again");
+  ASSERT_EQ("again", slice.ToString());
+}
+
+TEST(InlinePinnableSliceTest, Move) {
+  Arena arena;
+  InlinePinnableSlice<32> small;
+  InlinePinnableSlice<32> large(&arena);
+
+  small.PinSelf("inline");
+  large.PinSelf(std::string(100, 'a'));
+
+  // Inline contents are copied into the destination's own buffer.
+  InlinePinnableSlice<32> moved_small(std::move(small));
+  ASSERT_EQ("inline", moved_small.ToString());
+  ASSERT_TRUE(Within(moved_small, &moved_small, sizeof(moved_small)));
+  ASSERT_EQ(0u, small.size());
+
+  // Arena contents are shared, since the arena outlives both.
+  const char* arena_data = large.data();
+  InlinePinnableSlice<32> moved_large;
+  moved_large = std::move(large);
+  ASSERT_EQ(arena_data, moved_large.data());
+  ASSERT_EQ(std::string(100, 'a'), moved_large.ToString());
+
+  // Moving into a plain PinnableSlice falls back to its string buffer.
+  InlinePinnableSlice<32> source;
+  source.PinSelf("to string");
+  PinnableSlice plain(std::move(source));
+  ASSERT_EQ("to string", plain.ToString());
+  ASSERT_EQ(plain.data(), plain.GetSelf()->data());
+}
+
+TEST(InlinePinnableSliceTest, PlainPinnableSliceUnchanged) {
+  PinnableSlice slice;
+
+  slice.PinSelf("value");
+  ASSERT_EQ(slice.data(), slice.GetSelf()->data());
+  slice.RemovePrefix(1);
+  ASSERT_EQ("alue", *slice.GetSelf());
+
+  PinnableSlice moved(std::move(slice));
+  ASSERT_EQ("alue", moved.ToString());
+  ASSERT_EQ(0u, slice.size());
+}
+
+}  // namespace badger
@@ -0,0 +1,213 @@
+#include "cpp-badger/util/key_encoding.hh"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "cpp-badger/util/random.hh"
+
+namespace badger {
+
+using Clock = std::chrono::system_clock;
+
+static int Sign(int r) { return (r > 0) - (r < 0); }
+
+template <typename T>
+static int Compare3(const T& a, const T& b) {
+  return (b < a) - (a < b);
+}
+
+TEST(KeyEncodingTest, IntegersRoundTripAndOrder) {
+  std::vector<int64_t> values = {INT64_MIN, INT64_MIN + 1, -256, -1, 0, 1,
+                                 255,       256,           INT64_MAX};
+  std::vector<std::string> encoded;
+
+  for (int64_t v : values) {
+    std::string s;
+    PutOrderedInt64(&s, v);
+    encoded.push_back(s);
+
+    Slice input(s);
+    int64_t decoded;
+    ASSERT_TRUE(GetOrderedInt64(&input, &decoded));
+    ASSERT_EQ(v, decoded);
+    ASSERT_TRUE(input.IsEmpty());
+  }
+
+  ASSERT_TRUE(std::is_sorted(encoded.begin(), encoded.end()));
+
+  for (int32_t v : {INT32_MIN, -7, 0, 7, INT32_MAX}) {
+    std::string s;
+    PutOrderedInt32(&s, v);
+    Slice input(s);
+    int32_t decoded;
+    ASSERT_TRUE(GetOrderedInt32(&input, &decoded));
+    ASSERT_EQ(v, decoded);
+  }
+
+  std::string a;
+  std::string b;
+  PutOrderedUint32(&a, 0x00ffffff);
+  PutOrderedUint32(&b, 0x01000000);
+  ASSERT_LT(Slice(a).Compare(b), 0);
+}
+
+TEST(KeyEncodingTest, FloatingPointOrder) {
+  const double inf = std::numeric_limits<double>::infinity();
+  const double nan = std::numeric_limits<double>::quiet_NaN();
+  std::vector<double> values = {-inf,   -1e300, -1.5,  -1e-300, -0.0,
+                                1e-300, 1.5,    1e300, inf,     nan};
+  std::vector<std::string> encoded;
+
+  for (double v : values) {
+    std::string s;
+    PutOrderedDouble(&s, v);
+    encoded.push_back(s);
+
+    Slice input(s);
+    double decoded;
+    ASSERT_TRUE(GetOrderedDouble(&input, &decoded));
+
+    if (std::isnan(v))
+      ASSERT_TRUE(std::isnan(decoded));
+    else
+      ASSERT_EQ(v, decoded);
+  }
+
+  ASSERT_TRUE(std::is_sorted(encoded.begin(), encoded.end()));
+
+  // -0.0 and +0.0 compare equal, so they must encode identically.
+  std::string neg_zero;
+  std::string pos_zero;
+  PutOrderedDouble(&neg_zero, -0.0);
+  PutOrderedDouble(&pos_zero, 0.0);
+  ASSERT_EQ(pos_zero, neg_zero);
+
+  std::string f1;
+  std::string f2;
+  PutOrderedFloat(&f1, -2.5f);
+  PutOrderedFloat(&f2, 0.25f);
+  ASSERT_LT(Slice(f1).Compare(f2), 0);
+
+  Slice input(f1);
+  float decoded;
+  ASSERT_TRUE(GetOrderedFloat(&input, &decoded));
+  ASSERT_EQ(-2.5f, decoded);
+}
+
+TEST(KeyEncodingTest, Strings) {
+  std::vector<std::string> values = {std::string(),
+                                     std::string("\0", 1),
+                                     std::string("\0\0", 2),
+                                     std::string("\0\x01", 2),
+                                     std::string("\x01", 1),
+                                     "a",
+                                     std::string("a\0", 2),
+                                     std::string("a\0b", 3),
+                                     "ab",
+                                     "b",
+                                     "\xff"};
+  std::vector<std::string> encoded;
+
+  for (const auto& v : values) {
+    std::string s;
+    PutOrderedString(&s, v);
+    PutOrderedUint32(&s, 7);  // a trailing field must not disturb decoding
+    encoded.push_back(s);
+
+    Slice input(s);
+    std::string decoded;
+    uint32_t trailer;
+    ASSERT_TRUE(GetOrderedString(&input, &decoded));
+    ASSERT_EQ(v, decoded);
+    ASSERT_TRUE(GetOrderedUint32(&input, &trailer));
+    ASSERT_EQ(7u, trailer);
+  }
+
+  ASSERT_TRUE(std::is_sorted(encoded.begin(), encoded.end()));
+}
+
+TEST(KeyEncodingTest, PinnableSliceDecode) {
+  std::string s;
+  PutOrderedString(&s, "plain");
+  PutOrderedString(&s, std::string("with\0zero", 9));
+
+  Slice input(s);
+  PinnableSlice plain;
+  PinnableSlice escaped;
+
+  // Without embedded zeros the result points into the encoded key.
+  ASSERT_TRUE(GetOrderedString(&input, &plain));
+  ASSERT_TRUE(plain.IsPinned());
+  ASSERT_EQ("plain", plain.ToString());
+  ASSERT_EQ(s.data(), plain.data());
+
+  ASSERT_TRUE(GetOrderedString(&input, &escaped));
+  ASSERT_FALSE(escaped.IsPinned());
+  ASSERT_EQ(std::string("with\0zero", 9), escaped.ToString());
+  ASSERT_TRUE(input.IsEmpty());
+}
+
+TEST(KeyEncodingTest, Malformed) {
+  std::string value;
+  int64_t i;
+
+  Slice short_int("\x80\x00", 2);
+  ASSERT_FALSE(GetOrderedInt64(&short_int, &i));
+
+  for (const std::string& bad :
+       {std::string("abc"), std::string("abc\0", 4),
+        std::string("ab\0\x02", 4)}) {
+    Slice input(bad);
+    PinnableSlice pinnable;
+    ASSERT_FALSE(GetOrderedString(&input, &value));
+    ASSERT_FALSE(GetOrderedString(&input, &pinnable));
+  }
+}
+
+TEST(KeyEncodingTest, CompositeKeysSortLikeTuples) {
+  using Tuple = std::tuple<int64_t, double, std::string, Clock::time_point>;
+  Random rnd(301);
+  std::vector<std::pair<Tuple, std::string>> keys;
+
+  for (int n = 0; n < 500; ++n) {
+    // Narrow value ranges force ties in the leading fields.
+    const int64_t i = static_cast<int64_t>(rnd.Uniform(5)) - 2;
+    const double d = (static_cast<double>(rnd.Uniform(7)) - 3) / 2;
+    std::string str(rnd.Uniform(4), '\0');
+    for (auto& c : str) c = "\x00\x01a\xff"[rnd.Uniform(4)];
+    const Clock::time_point ts(std::chrono::microseconds(
+        static_cast<int64_t>(rnd.Uniform(1000)) - 500));
+
+    std::string key;
+    PutOrderedInt64(&key, i);
+    PutOrderedDouble(&key, d);
+    PutOrderedString(&key, str);
+    PutOrderedTimestamp(&key, ts);
+    keys.emplace_back(Tuple(i, d, str, ts), key);
+  }
+
+  for (const auto& [ta, ka] : keys) {
+    for (const auto& [tb, kb] : keys)
+      ASSERT_EQ(Compare3(ta, tb), Sign(Slice(ka).Compare(kb)));
+  }
+
+  const auto& [t, key] = keys.front();
+  Slice input(key);
+  int64_t i;
+  double d;
+  std::string str;
+  Clock::time_point ts;
+
+  ASSERT_TRUE(GetOrderedInt64(&input, &i));
+  ASSERT_TRUE(GetOrderedDouble(&input, &d));
+  ASSERT_TRUE(GetOrderedString(&input, &str));
+  ASSERT_TRUE(GetOrderedTimestamp(&input, &ts));
+  ASSERT_EQ(t, Tuple(i, d, str, ts));
+  ASSERT_TRUE(input.IsEmpty());
+}
+
+}  // namespace badger
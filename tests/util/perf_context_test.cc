@@ -0,0 +1,159 @@
+#include "cpp-badger/util/perf_context.hh"
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <string>
+#include <thread>
+
+#include "cpp-badger/memtable/memtable.hh"
+#include "cpp-badger/util/cleanable.hh"
+#include "cpp-badger/util/threadpool.hh"
+
+namespace badger {
+
+namespace {
+
+class PerfContextTest : public testing::Test {
+ protected:
+  void SetUp() override {
+#if defined(BADGER_NPERF_CONTEXT)
+    GTEST_SKIP() << "built without perf context";
+#endif
+    SetPerfLevel(PerfLevel::kEnableTime);
+    GetPerfContext()->Reset();
+  }
+
+  void TearDown() override { SetPerfLevel(PerfLevel::kDisable); }
+
+  /// Adds `n` keys to `mem` and looks each of them up.
+  static void FillAndGet(MemTable* mem, int n) {
+    std::string value;
+
+    for (int i = 0; i < n; ++i) {
+      const std::string key = "key" + std::to_string(1000 + i);
+      mem->Add(i + 1, kTypeValue, key, "value");
+    }
+    for (int i = 0; i < n; ++i) {
+      const std::string key = "key" + std::to_string(1000 + i);
+      ASSERT_EQ(LookupResult::kFound, mem->Get(key, n, &value));
+    }
+  }
+};
+
+void NoOpCleanup(void*, void*) {}
+
+}  // namespace
+
+TEST_F(PerfContextTest, Levels) {
+  const PerfContext* ctx = GetPerfContext();
+
+  SetPerfLevel(PerfLevel::kDisable);
+  MemTable mem;
+  ASSERT_EQ(PerfLevel::kDisable, GetPerfLevel());
+  FillAndGet(&mem, 10);
+  ASSERT_EQ("", ctx->ToString(true));
+
+  MemTable counted;
+  SetPerfLevel(PerfLevel::kEnableCount);
+  FillAndGet(&counted, 10);
+  ASSERT_EQ(10u, ctx->get_from_memtable_count);
+  ASSERT_GT(ctx->user_key_comparison_count, 0u);
+  ASSERT_EQ(0u, ctx->skiplist_insert_nanos);
+  ASSERT_EQ(0u, ctx->get_from_memtable_nanos);
+
+  MemTable timed;
+  SetPerfLevel(PerfLevel::kEnableTime);
+  FillAndGet(&timed, 10);
+  ASSERT_EQ(20u, ctx->get_from_memtable_count);
+  ASSERT_GT(ctx->skiplist_insert_nanos, 0u);
+  ASSERT_GT(ctx->get_from_memtable_nanos, 0u);
+}
+
+// A lookup in a skiplist of n keys takes O(log n) comparisons and descends
+// through every level.
+TEST_F(PerfContextTest, SkipList) {
+  constexpr int kKeys = 10000;
+  MemTable mem;
+
+  FillAndGet(&mem, kKeys);
+
+  const PerfContext* ctx = GetPerfContext();
+  ASSERT_EQ(uint64_t{kKeys}, ctx->get_from_memtable_count);
+  ASSERT_GE(ctx->user_key_comparison_count, uint64_t{2} * kKeys);
+  ASSERT_LT(ctx->user_key_comparison_count, uint64_t{2} * kKeys * 64);
+  ASSERT_GE(ctx->skiplist_levels_traversed, uint64_t{2} * kKeys);
+  ASSERT_GT(ctx->arena_bytes_allocated, uint64_t{kKeys} * 15);
+}
+
+TEST_F(PerfContextTest, Arena) {
+  Arena arena;
+
+  arena.Allocate(100);
+  arena.Allocate(28, 8);
+  arena.Allocate(0);
+
+  ASSERT_EQ(128u, GetPerfContext()->arena_bytes_allocated);
+}
+
+TEST_F(PerfContextTest, Cleanable) {
+  {
+    Cleanable c;
+    for (int i = 0; i < 3; ++i)
+      c.RegisterCleanup(&NoOpCleanup, nullptr, nullptr);
+  }
+
+  ASSERT_EQ(3u, GetPerfContext()->cleanups_registered);
+}
+
+// Scheduling is counted in the caller's context; the tasks run on workers
+// with their own contexts and leave the caller's alone.
+TEST_F(PerfContextTest, ThreadPool) {
+  constexpr int kTasks = 100;
+
+  {
+    ThreadPool pool(2);
+    for (int i = 0; i < kTasks; ++i)
+      pool.Schedule([] { GetPerfContext()->cleanups_registered += 1000; });
+  }
+
+  const PerfContext* ctx = GetPerfContext();
+  ASSERT_EQ(uint64_t{kTasks}, ctx->threadpool_tasks_scheduled);
+  ASSERT_GT(ctx->threadpool_schedule_nanos, 0u);
+  ASSERT_EQ(0u, ctx->cleanups_registered);
+}
+
+TEST_F(PerfContextTest, ThreadLocal) {
+  Arena arena;
+  arena.Allocate(8);
+
+  std::thread([] {
+    ASSERT_EQ(PerfLevel::kDisable, GetPerfLevel());
+    ASSERT_EQ(0u, GetPerfContext()->arena_bytes_allocated);
+
+    SetPerfLevel(PerfLevel::kEnableCount);
+    Arena other;
+    other.Allocate(16);
+    ASSERT_EQ(16u, GetPerfContext()->arena_bytes_allocated);
+  }).join();
+
+  ASSERT_EQ(8u, GetPerfContext()->arena_bytes_allocated);
+}
+
+TEST_F(PerfContextTest, ToStringAndReset) {
+  PerfContext* ctx = GetPerfContext();
+
+  ctx->arena_bytes_allocated = 7;
+  ctx->block_read_count = 2;
+
+  ASSERT_EQ("arena_bytes_allocated = 7, block_read_count = 2",
+            ctx->ToString(true));
+  const std::string all = ctx->ToString();
+  ASSERT_EQ(0u, all.find("user_key_comparison_count = 0, "));
+  ASSERT_NE(std::string::npos, all.find("block_read_nanos = 0"));
+
+  ctx->Reset();
+  ASSERT_EQ("", ctx->ToString(true));
+}
+
+}  // namespace badger
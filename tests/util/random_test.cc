@@ -3,6 +3,7 @@
 #include <gtest/gtest.h>
 
 #include <cstring>
+#include <thread>
 #include <vector>
 
 using badger::Random;
@@ -96,3 +97,94 @@ TEST(RandomTest, PercentTrue) {
     }
   }
 }
+
+using badger::RandomGenerator;
+
+TEST(RandomGeneratorTest, Deterministic) {
+  RandomGenerator a(301);
+  RandomGenerator b(301);
+  RandomGenerator c(302);
+  int same_as_c = 0;
+
+  for (int i = 0; i < 1000; ++i) {
+    const uint64_t x = a.Next();
+    EXPECT_EQ(x, b.Next());
+    same_as_c += x == c.Next();
+  }
+  EXPECT_EQ(same_as_c, 0);
+
+  a.Seed(301);
+  b.Seed(301);
+  EXPECT_EQ(a.Next(), b.Next());
+
+  // Seed 0 is as good as any other.
+  RandomGenerator zero(0);
+  EXPECT_NE(zero.Next(), zero.Next());
+}
+
+TEST(RandomGeneratorTest, Uniform) {
+  // Unlike Random's LCG, the counts vary as much as for truly random draws,
+  // so the bounds are five standard deviations.
+  const int average = 1000;
+  const int max_variance = static_cast<int>(5 * std::sqrt(average));
+  for (uint64_t seed : {0, 1, 2, 37, 4096}) {
+    RandomGenerator r(seed);
+
+    for (uint64_t range : {1, 2, 8, 12, 100}) {
+      std::vector<int> counts(range, 0);
+
+      for (uint64_t i = 0; i < range * average; ++i)
+        ++counts.at(r.Uniform(range));
+
+      for (uint64_t i = 0; i < range; ++i) {
+        EXPECT_GE(counts[i], average - max_variance);
+        EXPECT_LE(counts[i], average + max_variance);
+      }
+    }
+  }
+
+  // Large ranges use the high bits of the whole draw.
+  RandomGenerator r(42);
+  const uint64_t big = (uint64_t{1} << 62) + 12345;
+  int high_half = 0;
+  for (int i = 0; i < 10000; ++i) {
+    const uint64_t x = r.Uniform(big);
+    EXPECT_LT(x, big);
+    high_half += x >= big / 2;
+  }
+  EXPECT_NEAR(high_half, 5000, 300);
+}
+
+TEST(RandomGeneratorTest, OneInAndDouble) {
+  RandomGenerator r(42);
+  int count = 0;
+  double sum = 0;
+
+  for (int i = 0; i < 100000; ++i) {
+    count += r.OneIn(100);
+    const double d = r.NextDouble();
+    EXPECT_GE(d, 0.0);
+    EXPECT_LT(d, 1.0);
+    sum += d;
+  }
+
+  EXPECT_NEAR(count, 1000, 150);
+  EXPECT_NEAR(sum / 100000, 0.5, 0.01);
+  EXPECT_TRUE(r.OneIn(1));
+}
+
+TEST(RandomGeneratorTest, TLSInstance) {
+  RandomGenerator* mine = RandomGenerator::GetTLSInstance();
+  RandomGenerator* other = nullptr;
+  uint64_t other_first = 0;
+
+  EXPECT_EQ(mine, RandomGenerator::GetTLSInstance());
+  std::thread thread([&] {
+    other = RandomGenerator::GetTLSInstance();
+    other_first = other->Next();
+  });
+  thread.join();
+
+  EXPECT_NE(mine, other);
+  EXPECT_NE(mine->Next(), other_first);
+}
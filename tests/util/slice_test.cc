@@ -0,0 +1,158 @@
+#include "cpp-badger/util/slice.hh"
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "cpp-badger/util/hash.hh"
+#include "cpp-badger/util/mismatch.hh"
+#include "cpp-badger/util/random.hh"
+
+using badger::MismatchFunction;
+using badger::Random;
+using badger::Slice;
+
+static std::vector<MismatchFunction> AllKernels() {
+  std::vector<MismatchFunction> kernels = {badger::FindFirstMismatchScalar,
+                                           badger::FindFirstMismatch};
+#ifdef BADGER_HAVE_X86_MISMATCH
+  kernels.push_back(badger::FindFirstMismatchSSE2);
+  if (__builtin_cpu_supports("avx2"))
+    kernels.push_back(badger::FindFirstMismatchAVX2);
+#endif
+
+  return kernels;
+}
+
+static size_t NaiveMismatch(const char* a, const char* b, size_t n) {
+  size_t i = 0;
+
+  while (i < n && a[i] == b[i]) ++i;
+
+  return i;
+}
+
+static int Sign(int r) { return (r > 0) - (r < 0); }
+
+TEST(SliceTest, FindFirstMismatchEveryOffset) {
+  // Covers every block/tail boundary of the 8/16/32-byte kernels, with the
+  // buffers at unaligned addresses.
+  for (MismatchFunction kernel : AllKernels()) {
+    for (size_t len = 0; len <= 130; ++len) {
+      std::string a(len + 3, 'x');
+      std::string b(len + 5, 'x');
+      const char* pa = a.data() + 3;
+      const char* pb = b.data() + 5;
+
+      ASSERT_EQ(len, kernel(pa, pb, len));
+
+      for (size_t pos = 0; pos < len; ++pos) {
+        b[5 + pos] = 'y';
+        ASSERT_EQ(pos, kernel(pa, pb, len)) << len;
+        // A second difference after the first must not matter.
+        if (pos + 1 < len) b[5 + len - 1] = '\0';
+        ASSERT_EQ(pos, kernel(pa, pb, len)) << len;
+        b.assign(len + 5, 'x');
+        pb = b.data() + 5;
+      }
+    }
+  }
+}
+
+TEST(SliceTest, FindFirstMismatchRandom) {
+  Random rnd(301);
+
+  for (MismatchFunction kernel : AllKernels()) {
+    for (int i = 0; i < 2000; ++i) {
+      const size_t len = rnd.Uniform(1100);
+      std::string a(len, '\0');
+
+      for (auto& c : a) c = static_cast<char>(rnd.Uniform(256));
+
+      std::string b = a;
+      for (int flips = rnd.Uniform(3); flips > 0 && len > 0; --flips)
+        b[rnd.Uniform(static_cast<int>(len))] ^= 1 << rnd.Uniform(8);
+
+      ASSERT_EQ(NaiveMismatch(a.data(), b.data(), len),
+                kernel(a.data(), b.data(), len));
+    }
+  }
+}
+
+TEST(SliceTest, Compare) {
+  Random rnd(42);
+  std::vector<std::string> keys = {"", "a", "ab", "b", "\xff", "\x80", "\x7f"};
+
+  for (int i = 0; i < 300; ++i) {
+    std::string key(rnd.Uniform(70), '\0');
+
+    // A small alphabet makes long shared prefixes likely.
+    for (auto& c : key) c = "\x00\x01\x7f\x80\xff"[rnd.Uniform(5)];
+
+    keys.push_back(key);
+  }
+
+  for (const auto& x : keys) {
+    for (const auto& y : keys) {
+      ASSERT_EQ(Sign(x.compare(y)), Sign(Slice(x).Compare(Slice(y))));
+      ASSERT_EQ(NaiveMismatch(x.data(), y.data(), std::min(x.size(), y.size())),
+                Slice(x).DifferenceOffset(Slice(y)));
+    }
+  }
+}
+
+TEST(SliceTest, SliceParts) {
+  Random rnd(301);
+  std::vector<std::string> others = {"", "a", "ab", "b", "\xff"};
+
+  for (int i = 0; i < 200; ++i) {
+    std::string s(rnd.Uniform(40), '\0');
+    for (auto& c : s) c = "\x00\x7f\x80\xff"[rnd.Uniform(4)];
+    others.push_back(s);
+  }
+
+  for (const auto& whole : others) {
+    // Split at random points, including empty parts.
+    std::vector<Slice> pieces;
+    size_t pos = 0;
+
+    for (int k = 0; k < 4; ++k) {
+      const size_t len = rnd.Uniform(static_cast<int>(whole.size() - pos) + 1);
+      pieces.emplace_back(whole.data() + pos, len);
+      pos += len;
+    }
+
+    pieces.emplace_back(whole.data() + pos, whole.size() - pos);
+
+    const badger::SliceParts parts(pieces.data(),
+                                   static_cast<int>(pieces.size()));
+    ASSERT_EQ(whole.size(), parts.size());
+    ASSERT_EQ(whole, parts.ToString());
+    ASSERT_TRUE(parts == Slice(whole));
+    ASSERT_EQ(badger::hash(whole.data(), whole.size(), 7),
+              badger::hash(parts, 7));
+
+    std::string buf = "prefix";
+    ASSERT_EQ("prefix" + whole, Slice(parts, &buf).ToString());
+
+    for (const auto& other : others)
+      ASSERT_EQ(Sign(whole.compare(other)), Sign(parts.Compare(other)));
+  }
+
+  const badger::SliceParts empty;
+  ASSERT_TRUE(empty.IsEmpty());
+  ASSERT_EQ(0, empty.Compare(""));
+  ASSERT_LT(empty.Compare("a"), 0);
+}
+
+TEST(SliceTest, KernelName) {
+  const std::string name = badger::MismatchKernelName();
+
+#ifdef BADGER_HAVE_X86_MISMATCH
+  ASSERT_EQ(__builtin_cpu_supports("avx2") ? "avx2" : "sse2", name);
+#else
+  ASSERT_EQ("scalar", name);
+#endif
+}
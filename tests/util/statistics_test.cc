@@ -0,0 +1,133 @@
+#include "cpp-badger/util/statistics.hh"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "cpp-badger/util/threadpool.hh"
+
+namespace badger {
+
+TEST(StatisticsTest, TickersAndHistograms) {
+  Statistics stats;
+
+  stats.RecordTick(kArenaAllocations);
+  stats.RecordTick(kArenaAllocatedBytes, 100);
+  stats.RecordTick(kArenaAllocatedBytes, 28);
+  for (uint64_t v = 1; v <= 1000; ++v)
+    stats.RecordInHistogram(kArenaAllocationBytes, v);
+
+  ASSERT_EQ(1u, stats.GetTickerCount(kArenaAllocations));
+  ASSERT_EQ(128u, stats.GetTickerCount(kArenaAllocatedBytes));
+  ASSERT_EQ(0u, stats.GetTickerCount(kSkipListInserts));
+
+  const Histogram h = stats.GetHistogram(kArenaAllocationBytes);
+  ASSERT_EQ(1000u, h.Count());
+  ASSERT_EQ(500500u, h.Sum());
+  ASSERT_EQ(1u, h.Min());
+  ASSERT_EQ(1000u, h.Max());
+  ASSERT_NEAR(500, h.Percentile(50), 500 / 16);
+  ASSERT_EQ(0u, stats.GetHistogram(kSkipListInsertNanos).Count());
+
+  stats.Reset();
+  ASSERT_EQ(0u, stats.GetTickerCount(kArenaAllocatedBytes));
+  ASSERT_EQ(0u, stats.GetHistogram(kArenaAllocationBytes).Count());
+  stats.RecordInHistogram(kArenaAllocationBytes, 7);
+  ASSERT_EQ(7u, stats.GetHistogram(kArenaAllocationBytes).Min());
+}
+
+// Threads recording at once, likely on different cores, lose nothing.
+TEST(StatisticsTest, ConcurrentRecording) {
+  constexpr int kThreads = 8;
+  constexpr int kPerThread = 100000;
+  Statistics stats;
+  std::vector<std::thread> threads;
+
+  for (int t = 0; t < kThreads; ++t) {
+    threads.emplace_back([&, t] {
+      for (int i = 0; i < kPerThread; ++i) {
+        stats.RecordTick(kSkipListInserts);
+        stats.RecordInHistogram(kSkipListInsertNanos, t + 1);
+      }
+    });
+  }
+  for (auto& thread : threads) thread.join();
+
+  ASSERT_EQ(uint64_t{kThreads} * kPerThread,
+            stats.GetTickerCount(kSkipListInserts));
+  const Histogram h = stats.GetHistogram(kSkipListInsertNanos);
+  ASSERT_EQ(uint64_t{kThreads} * kPerThread, h.Count());
+  ASSERT_EQ(1u, h.Min());
+  ASSERT_EQ(uint64_t{kThreads}, h.Max());
+}
+
+TEST(StatisticsTest, SnapshotMergeAndDump) {
+  Statistics a;
+  Statistics b;
+
+  a.RecordTick(kThreadPoolTasksScheduled, 3);
+  b.RecordTick(kThreadPoolTasksScheduled, 4);
+  b.RecordInHistogram(kThreadPoolQueueNanos, 1000);
+
+  StatisticsSnapshot snapshot = a.Snapshot();
+  snapshot.Merge(b.Snapshot());
+  ASSERT_EQ(7u, snapshot.tickers[kThreadPoolTasksScheduled]);
+  ASSERT_EQ(1u, snapshot.histograms[kThreadPoolQueueNanos].Count());
+
+  const std::string text = snapshot.ToString();
+  ASSERT_NE(std::string::npos, text.find("threadpool.tasks.scheduled 7\n"));
+  ASSERT_NE(std::string::npos, text.find("threadpool.queue.nanos count 1"));
+  // Empty histograms are left out of the text dump.
+  ASSERT_EQ(std::string::npos, text.find("skiplist.insert.nanos"));
+
+  const std::string json = snapshot.ToJson();
+  ASSERT_EQ('{', json.front());
+  ASSERT_EQ('}', json.back());
+  ASSERT_NE(std::string::npos,
+            json.find("\"threadpool.tasks.scheduled\": 7"));
+  ASSERT_NE(std::string::npos,
+            json.find("\"threadpool.queue.nanos\": {\"count\": 1, "
+                      "\"sum\": 1000, \"min\": 1000, \"max\": 1000"));
+}
+
+TEST(StatisticsTest, NullIsNoOp) {
+  RecordTick(nullptr, kArenaAllocations);
+  RecordInHistogram(nullptr, kArenaAllocationBytes, 1);
+  StopWatch timer(nullptr, kSkipListInsertNanos);
+}
+
+TEST(StatisticsTest, StopWatch) {
+  Statistics stats;
+
+  {
+    StopWatch timer(&stats, kSkipListInsertNanos);
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+
+  const Histogram h = stats.GetHistogram(kSkipListInsertNanos);
+  ASSERT_EQ(1u, h.Count());
+  ASSERT_GE(h.Min(), 1000000u);
+}
+
+TEST(StatisticsTest, ThreadPool) {
+  constexpr int kTasks = 100;
+  Statistics stats;
+  std::atomic<int> ran{0};
+
+  {
+    ThreadPool pool(2, &stats);
+    for (int i = 0; i < kTasks; ++i) pool.Schedule([&] { ++ran; });
+  }
+
+  ASSERT_EQ(kTasks, ran.load());
+  ASSERT_EQ(uint64_t{kTasks}, stats.GetTickerCount(kThreadPoolTasksScheduled));
+  ASSERT_EQ(uint64_t{kTasks}, stats.GetTickerCount(kThreadPoolTasksRun));
+  ASSERT_EQ(uint64_t{kTasks},
+            stats.GetHistogram(kThreadPoolQueueNanos).Count());
+}
+
+}  // namespace badger
@@ -0,0 +1,202 @@
+#include "cpp-badger/util/workload_generator.hh"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace badger {
+
+namespace {
+
+constexpr int kDraws = 1000000;
+
+/// \return How often each key was drawn in kDraws draws.
+std::vector<int> Histogram(KeyGenerator* gen) {
+  std::vector<int> counts(gen->NumKeys());
+
+  for (int i = 0; i < kDraws; ++i) {
+    const uint64_t key = gen->Next();
+    EXPECT_LT(key, gen->NumKeys());
+    if (key < counts.size()) ++counts[key];
+  }
+
+  return counts;
+}
+
+/// The generalized harmonic number H(n, theta).
+double Zeta(uint64_t n, double theta) {
+  double sum = 0;
+  for (uint64_t i = 1; i <= n; ++i) sum += std::pow(i, -theta);
+
+  return sum;
+}
+
+}  // namespace
+
+TEST(WorkloadGeneratorTest, Deterministic) {
+  ZipfianGenerator a(1000, ZipfianGenerator::kDefaultTheta, 301);
+  ZipfianGenerator b(1000, ZipfianGenerator::kDefaultTheta, 301);
+  ZipfianGenerator c(1000, ZipfianGenerator::kDefaultTheta, 302);
+  int same = 0;
+
+  for (int i = 0; i < 1000; ++i) {
+    const uint64_t x = a.Next();
+    ASSERT_EQ(x, b.Next());
+    same += x == c.Next();
+  }
+  ASSERT_LT(same, 1000);
+
+  auto sizes1 = ValueSizeGenerator::Pareto(226.409, 0.923, 0, 4096, 7);
+  auto sizes2 = ValueSizeGenerator::Pareto(226.409, 0.923, 0, 4096, 7);
+  for (int i = 0; i < 1000; ++i) ASSERT_EQ(sizes1.Next(), sizes2.Next());
+}
+
+TEST(WorkloadGeneratorTest, Uniform) {
+  constexpr uint64_t kNumKeys = 100;
+  UniformGenerator gen(kNumKeys, 301);
+
+  for (int count : Histogram(&gen)) {
+    ASSERT_GT(count, kDraws / kNumKeys * 0.95);
+    ASSERT_LT(count, kDraws / kNumKeys * 1.05);
+  }
+}
+
+// The frequency of each of the first ranks matches the Zipf distribution,
+// for the YCSB theta and for theta of 1 and above, which the sampler handles
+// alike.
+TEST(WorkloadGeneratorTest, Zipfian) {
+  constexpr uint64_t kNumKeys = 1000;
+
+  for (double theta : {0.5, 0.99, 1.0, 1.5}) {
+    ZipfianGenerator gen(kNumKeys, theta, 301);
+    const std::vector<int> counts = Histogram(&gen);
+    const double zeta = Zeta(kNumKeys, theta);
+
+    for (uint64_t i = 0; i < 10; ++i) {
+      const double expected = kDraws * std::pow(i + 1, -theta) / zeta;
+      ASSERT_NEAR(counts[i], expected, 5 * std::sqrt(expected) + 1)
+          << "theta " << theta << " rank " << i;
+    }
+  }
+}
+
+TEST(WorkloadGeneratorTest, ZipfianSetNumKeys) {
+  ZipfianGenerator gen(10, ZipfianGenerator::kDefaultTheta, 301);
+
+  for (int i = 0; i < 10000; ++i) ASSERT_LT(gen.Next(), 10u);
+  gen.SetNumKeys(1);
+  for (int i = 0; i < 100; ++i) ASSERT_EQ(0u, gen.Next());
+  gen.SetNumKeys(uint64_t{1} << 40);
+  for (int i = 0; i < 10000; ++i) ASSERT_LT(gen.Next(), uint64_t{1} << 40);
+}
+
+// The scrambled generator is as skewed as the plain one, but its most
+// popular key is not key 0.
+TEST(WorkloadGeneratorTest, ScrambledZipfian) {
+  constexpr uint64_t kNumKeys = 1000;
+  ScrambledZipfianGenerator gen(kNumKeys, ZipfianGenerator::kDefaultTheta,
+                                301);
+  const std::vector<int> counts = Histogram(&gen);
+
+  const auto hottest = std::max_element(counts.begin(), counts.end());
+  ASSERT_NE(counts.begin(), hottest);
+  ASSERT_GT(*hottest, kDraws / Zeta(kNumKeys, 0.99) * 0.95);
+}
+
+TEST(WorkloadGeneratorTest, Latest) {
+  constexpr uint64_t kNumKeys = 1000;
+  LatestGenerator gen(kNumKeys, ZipfianGenerator::kDefaultTheta, 301);
+  std::vector<int> counts = Histogram(&gen);
+
+  ASSERT_EQ(counts.end() - 1, std::max_element(counts.begin(), counts.end()));
+  ASSERT_GT(counts[kNumKeys - 1], counts[kNumKeys - 2]);
+  ASSERT_GT(counts[kNumKeys - 2], counts[0]);
+
+  // New keys become the most popular.
+  gen.SetNumKeys(2 * kNumKeys);
+  counts = Histogram(&gen);
+  ASSERT_EQ(counts.end() - 1, std::max_element(counts.begin(), counts.end()));
+}
+
+TEST(WorkloadGeneratorTest, Hotspot) {
+  constexpr uint64_t kNumKeys = 1000;
+  HotspotGenerator gen(kNumKeys, 0.2, 0.8, 301);
+  const std::vector<int> counts = Histogram(&gen);
+
+  int hot = 0;
+  for (uint64_t i = 0; i < kNumKeys / 5; ++i) hot += counts[i];
+  ASSERT_NEAR(0.8, static_cast<double>(hot) / kDraws, 0.005);
+
+  // Degenerate hot sets.
+  HotspotGenerator all_hot(kNumKeys, 1, 0.5, 301);
+  HotspotGenerator none_hot(kNumKeys, 0, 0.5, 301);
+  for (int i = 0; i < 10000; ++i) {
+    ASSERT_LT(all_hot.Next(), kNumKeys);
+    ASSERT_LT(none_hot.Next(), kNumKeys);
+  }
+}
+
+// By construction, 95% of the draws fall in the first 6/7 of the keys.
+TEST(WorkloadGeneratorTest, Exponential) {
+  constexpr uint64_t kNumKeys = 7000;
+  ExponentialGenerator gen(kNumKeys, ExponentialGenerator::kDefaultPercentile,
+                           ExponentialGenerator::kDefaultRangeFraction, 301);
+  const std::vector<int> counts = Histogram(&gen);
+
+  int in_range = 0;
+  for (uint64_t i = 0; i < 6000; ++i) in_range += counts[i];
+  // Draws past the last key are redrawn, so the fraction is conditional on
+  // a draw below 7000.
+  const double below_num_keys = 1 - std::pow(0.05, 7.0 / 6);
+  ASSERT_NEAR(0.95 / below_num_keys, static_cast<double>(in_range) / kDraws,
+              0.005);
+  ASSERT_GT(counts[0], counts[kNumKeys / 2]);
+}
+
+TEST(WorkloadGeneratorTest, ValueSizes) {
+  auto fixed = ValueSizeGenerator::Fixed(100);
+  ASSERT_EQ(ValueSizeGenerator::Distribution::kFixed,
+            fixed.GetDistribution());
+  for (int i = 0; i < 100; ++i) ASSERT_EQ(100u, fixed.Next());
+
+  auto uniform = ValueSizeGenerator::Uniform(10, 20, 301);
+  auto normal = ValueSizeGenerator::Normal(1000, 100, 700, 1300, 301);
+  auto pareto = ValueSizeGenerator::Pareto(226.409, 0.923, 10, 4096, 301);
+  double uniform_sum = 0;
+  double normal_sum = 0;
+  int pareto_small = 0;
+  bool pareto_max = false;
+  bool uniform_min = false;
+  bool uniform_max = false;
+
+  for (int i = 0; i < kDraws; ++i) {
+    const uint32_t u = uniform.Next();
+    ASSERT_GE(u, 10u);
+    ASSERT_LE(u, 20u);
+    uniform_min |= u == 10;
+    uniform_max |= u == 20;
+    uniform_sum += u;
+
+    const uint32_t n = normal.Next();
+    ASSERT_GE(n, 700u);
+    ASSERT_LE(n, 1300u);
+    normal_sum += n;
+
+    const uint32_t p = pareto.Next();
+    ASSERT_GE(p, 10u);
+    ASSERT_LE(p, 4096u);
+    pareto_small += p < 10 + 226;
+    pareto_max |= p == 4096;
+  }
+
+  ASSERT_TRUE(uniform_min && uniform_max);
+  ASSERT_NEAR(15, uniform_sum / kDraws, 0.05);
+  ASSERT_NEAR(1000, normal_sum / kDraws, 1);
+  // Most values are small, but the tail reaches the maximum.
+  ASSERT_GT(pareto_small, kDraws / 2);
+  ASSERT_TRUE(pareto_max);
+}
+
+}  // namespace badger
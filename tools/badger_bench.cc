@@ -0,0 +1,679 @@
+// badger_bench: a db_bench-style tool that measures throughput and latency
+// of write, read and scan workloads end to end.
+//
+// Workloads run against a ShardedMemTable (a single shard by default, which
+// is a plain MemTable behind one lock), one after the other, on --threads
+// threads each. The fill workloads start from an empty memtable; the others
+// use whatever the previous workloads left, so a typical run is
+//
+//   badger_bench --benchmarks=fillrandom,readrandom,seekrandom --threads=4
+//
+// For each workload the tool prints ops/sec, MB/s of keys and values moved
+// and the p50, p99 and p99.9 latencies of single operations, and with
+// --json=<file> (or --json=- for stdout) writes the same as JSON for scripts
+// that compare runs.
+//
+// Keys are 16-digit decimal indexes in [0, --num), drawn with the
+// generators of workload_generator.hh; every thread's generators are seeded
+// from --seed and the thread index, so runs are repeatable.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cinttypes>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <latch>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "cpp-badger/memtable/memtable.hh"
+#include "cpp-badger/memtable/sharded_memtable.hh"
+#include "cpp-badger/util/histogram.hh"
+#include "cpp-badger/util/random.hh"
+#include "cpp-badger/util/slice.hh"
+#include "cpp-badger/util/statistics.hh"
+#include "cpp-badger/util/workload_generator.hh"
+
+namespace badger {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr size_t kKeySize = 16;
+
+struct Flags {
+  std::string benchmarks =
+      "fillseq,fillrandom,overwrite,readrandom,readseq,seekrandom,mixed";
+  /// Number of keys; the fill workloads write this many in total.
+  uint64_t num = 1000000;
+  /// Operations per thread of the read, seek and mixed workloads; 0 means
+  /// --num.
+  uint64_t reads = 0;
+  int threads = 1;
+  size_t shards = 1;
+  /// uniform, zipfian, scrambled_zipfian, latest, hotspot or exponential.
+  std::string key_distribution = "uniform";
+  double zipf_theta = ZipfianGenerator::kDefaultTheta;
+  /// fixed, uniform, normal or pareto.
+  std::string value_size_distribution = "fixed";
+  uint32_t value_size = 100;
+  uint32_t value_size_min = 16;
+  uint32_t value_size_max = 1024;
+  /// Share of the mixed workload's operations that are reads.
+  int read_percent = 90;
+  /// Entries read after each seek of seekrandom.
+  int seek_nexts = 10;
+  uint64_t seed = 301;
+  /// Record memtable statistics and print them after each workload.
+  bool statistics = false;
+  std::string json;
+};
+
+void PrintUsage() {
+  const Flags defaults;
+
+  fprintf(stderr,
+          "Usage: badger_bench [--flag=value]...\n"
+          "  --benchmarks=%s\n"
+          "  --num=%" PRIu64 "  --reads=<num>  --threads=%d  --shards=%zu\n"
+          "  --key_distribution=uniform|zipfian|scrambled_zipfian|latest|"
+          "hotspot|exponential\n"
+          "  --zipf_theta=%g  --seed=%" PRIu64 "\n"
+          "  --value_size_distribution=fixed|uniform|normal|pareto\n"
+          "  --value_size=%u  --value_size_min=%u  --value_size_max=%u\n"
+          "  --read_percent=%d  --seek_nexts=%d  --statistics=0|1\n"
+          "  --json=<file or ->\n",
+          defaults.benchmarks.c_str(), defaults.num, defaults.threads,
+          defaults.shards, defaults.zipf_theta, defaults.seed,
+          defaults.value_size, defaults.value_size_min,
+          defaults.value_size_max, defaults.read_percent,
+          defaults.seek_nexts);
+}
+
+template <typename T>
+bool ParseNumber(std::string_view text, T* value) {
+  const std::string s(text);
+  char* end = nullptr;
+
+  if constexpr (std::is_floating_point_v<T>)
+    *value = static_cast<T>(strtod(s.c_str(), &end));
+  else if constexpr (std::is_signed_v<T>)
+    *value = static_cast<T>(strtoll(s.c_str(), &end, 10));
+  else
+    *value = static_cast<T>(strtoull(s.c_str(), &end, 10));
+
+  return !s.empty() && *end == '\0';
+}
+
+/// \return false, after printing why, if an argument is not understood.
+bool ParseFlags(int argc, char** argv, Flags* flags) {
+  const std::vector<
+      std::pair<std::string_view, std::function<bool(std::string_view)>>>
+      setters = {
+          {"benchmarks",
+           [&](std::string_view v) {
+             flags->benchmarks = v;
+             return true;
+           }},
+          {"num",
+           [&](auto v) {
+             return ParseNumber(v, &flags->num) && flags->num > 0;
+           }},
+          {"reads", [&](auto v) { return ParseNumber(v, &flags->reads); }},
+          {"threads",
+           [&](auto v) {
+             return ParseNumber(v, &flags->threads) && flags->threads > 0;
+           }},
+          {"shards",
+           [&](auto v) {
+             return ParseNumber(v, &flags->shards) && flags->shards > 0;
+           }},
+          {"key_distribution",
+           [&](std::string_view v) {
+             flags->key_distribution = v;
+             return true;
+           }},
+          {"zipf_theta",
+           [&](auto v) { return ParseNumber(v, &flags->zipf_theta); }},
+          {"value_size_distribution",
+           [&](std::string_view v) {
+             flags->value_size_distribution = v;
+             return true;
+           }},
+          {"value_size",
+           [&](auto v) { return ParseNumber(v, &flags->value_size); }},
+          {"value_size_min",
+           [&](auto v) { return ParseNumber(v, &flags->value_size_min); }},
+          {"value_size_max",
+           [&](auto v) { return ParseNumber(v, &flags->value_size_max); }},
+          {"read_percent",
+           [&](auto v) { return ParseNumber(v, &flags->read_percent); }},
+          {"seek_nexts",
+           [&](auto v) { return ParseNumber(v, &flags->seek_nexts); }},
+          {"seed", [&](auto v) { return ParseNumber(v, &flags->seed); }},
+          {"statistics",
+           [&](std::string_view v) {
+             flags->statistics = v == "1" || v == "true";
+             return v == "0" || v == "1" || v == "true" || v == "false";
+           }},
+          {"json",
+           [&](std::string_view v) {
+             flags->json = v;
+             return true;
+           }},
+      };
+
+  for (int i = 1; i < argc; ++i) {
+    std::string_view arg = argv[i];
+    const size_t eq = arg.find('=');
+
+    if (!arg.starts_with("--") || eq == std::string_view::npos) {
+      fprintf(stderr, "Bad argument: %s\n", argv[i]);
+      return false;
+    }
+
+    const std::string_view name = arg.substr(2, eq - 2);
+    const std::string_view value = arg.substr(eq + 1);
+    const auto it =
+        std::find_if(setters.begin(), setters.end(),
+                     [&](const auto& setter) { return setter.first == name; });
+
+    if (it == setters.end()) {
+      fprintf(stderr, "Unknown flag: --%.*s\n", static_cast<int>(name.size()),
+              name.data());
+      return false;
+    }
+    if (!it->second(value)) {
+      fprintf(stderr, "Bad value for --%.*s: %.*s\n",
+              static_cast<int>(name.size()), name.data(),
+              static_cast<int>(value.size()), value.data());
+      return false;
+    }
+  }
+
+  if (flags->value_size_min > flags->value_size_max) {
+    fprintf(stderr, "--value_size_min is above --value_size_max\n");
+    return false;
+  }
+
+  return true;
+}
+
+std::unique_ptr<KeyGenerator> NewKeyGenerator(const Flags& flags,
+                                              uint64_t seed) {
+  const std::string& dist = flags.key_distribution;
+
+  if (dist == "uniform")
+    return std::make_unique<UniformGenerator>(flags.num, seed);
+  if (dist == "zipfian")
+    return std::make_unique<ZipfianGenerator>(flags.num, flags.zipf_theta,
+                                              seed);
+  if (dist == "scrambled_zipfian")
+    return std::make_unique<ScrambledZipfianGenerator>(
+        flags.num, flags.zipf_theta, seed);
+  if (dist == "latest")
+    return std::make_unique<LatestGenerator>(flags.num, flags.zipf_theta,
+                                             seed);
+  if (dist == "hotspot")
+    return std::make_unique<HotspotGenerator>(flags.num, 0.2, 0.8, seed);
+  if (dist == "exponential")
+    return std::make_unique<ExponentialGenerator>(
+        flags.num, ExponentialGenerator::kDefaultPercentile,
+        ExponentialGenerator::kDefaultRangeFraction, seed);
+
+  return nullptr;
+}
+
+std::unique_ptr<ValueSizeGenerator> NewValueSizeGenerator(const Flags& flags,
+                                                          uint64_t seed) {
+  const std::string& dist = flags.value_size_distribution;
+  const uint32_t min = flags.value_size_min;
+  const uint32_t max = flags.value_size_max;
+
+  if (dist == "fixed")
+    return std::make_unique<ValueSizeGenerator>(
+        ValueSizeGenerator::Fixed(flags.value_size));
+  if (dist == "uniform")
+    return std::make_unique<ValueSizeGenerator>(
+        ValueSizeGenerator::Uniform(min, max, seed));
+  if (dist == "normal")
+    return std::make_unique<ValueSizeGenerator>(ValueSizeGenerator::Normal(
+        flags.value_size, flags.value_size / 4.0, min, max, seed));
+  if (dist == "pareto")
+    return std::make_unique<ValueSizeGenerator>(
+        ValueSizeGenerator::Pareto(226.409, 0.923, min, max, seed));
+
+  return nullptr;
+}
+
+/// What one thread did in one workload.
+struct ThreadStats {
+  uint64_t ops = 0;
+  uint64_t bytes = 0;
+  /// Reads that found their key.
+  uint64_t found = 0;
+  Clock::time_point start;
+  Clock::time_point finish;
+  Histogram latency;
+};
+
+class ThreadState {
+ public:
+  ThreadState(const Flags& flags, int tid)
+      : tid_(tid),
+        rnd_(flags.seed * 1000003 + tid),
+        keys_(NewKeyGenerator(flags, rnd_.Next())),
+        value_sizes_(NewValueSizeGenerator(flags, rnd_.Next())) {}
+
+  int tid() const { return tid_; }
+  RandomGenerator* rnd() { return &rnd_; }
+  uint64_t NextKey() { return keys_->Next(); }
+  uint32_t NextValueSize() { return value_sizes_->Next(); }
+  ThreadStats* stats() { return &stats_; }
+
+  void Start() { stats_.start = last_op_ = Clock::now(); }
+
+  /// Records an operation that moved `bytes` of keys and values and ended
+  /// now; it started when the previous one ended.
+  void FinishedOp(uint64_t bytes) {
+    const Clock::time_point now = Clock::now();
+
+    stats_.latency.Add(static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(now - last_op_)
+            .count()));
+    ++stats_.ops;
+    stats_.bytes += bytes;
+    last_op_ = now;
+  }
+
+  void Finish() { stats_.finish = last_op_; }
+
+ private:
+  int tid_;
+  RandomGenerator rnd_;
+  std::unique_ptr<KeyGenerator> keys_;
+  std::unique_ptr<ValueSizeGenerator> value_sizes_;
+  ThreadStats stats_;
+  Clock::time_point last_op_;
+};
+
+struct Result {
+  std::string name;
+  uint64_t ops;
+  uint64_t found;
+  double seconds;
+  double ops_per_sec;
+  double mb_per_sec;
+  double p50_us;
+  double p99_us;
+  double p999_us;
+  size_t memory_bytes;
+  /// The statistics recorded during the workload, as JSON; empty without
+  /// --statistics.
+  std::string statistics;
+};
+
+class Benchmark {
+ public:
+  explicit Benchmark(const Flags& flags)
+      : flags_(flags),
+        reads_(flags.reads > 0 ? flags.reads : flags.num),
+        stats_(flags.statistics ? std::make_unique<Statistics>() : nullptr),
+        mem_(NewMemTable()) {
+    // Values are windows of one random buffer, so that writing them costs
+    // no generation.
+    RandomGenerator rnd(flags.seed);
+    value_data_.resize(std::max<size_t>(
+        1 << 20, 2 * size_t{std::max(flags.value_size,
+                                     flags.value_size_max)}));
+    for (char& c : value_data_) c = static_cast<char>(' ' + rnd.Uniform(95));
+  }
+
+  /// \return false if a workload or distribution is unknown.
+  bool Run();
+
+  const std::vector<Result>& results() const { return results_; }
+
+ private:
+  using Method = void (Benchmark::*)(ThreadState*);
+
+  std::unique_ptr<ShardedMemTable> NewMemTable() const {
+    MemTableOptions options;
+    options.statistics = stats_.get();
+
+    return std::make_unique<ShardedMemTable>(flags_.shards, options);
+  }
+
+  /// Runs `method` on every thread and records the combined result.
+  void RunWorkload(const std::string& name, Method method);
+
+  static void EncodeKey(uint64_t k, char* buf) {
+    for (int i = kKeySize - 1; i >= 0; --i) {
+      buf[i] = static_cast<char>('0' + k % 10);
+      k /= 10;
+    }
+  }
+
+  Slice Value(ThreadState* thread) {
+    const uint32_t size = thread->NextValueSize();
+    const size_t offset =
+        thread->rnd()->Uniform(value_data_.size() - size + 1);
+
+    return Slice(value_data_.data() + offset, size);
+  }
+
+  SequenceNumber NextSequence() {
+    return seq_.fetch_add(1, std::memory_order_relaxed) + 1;
+  }
+
+  void Write(ThreadState* thread, uint64_t k, bool update) {
+    char key[kKeySize];
+    EncodeKey(k, key);
+    const Slice value = Value(thread);
+
+    if (update)
+      mem_->Update(NextSequence(), Slice(key, kKeySize), value);
+    else
+      mem_->Add(NextSequence(), kTypeValue, Slice(key, kKeySize), value);
+    thread->FinishedOp(kKeySize + value.size());
+  }
+
+  void Read(ThreadState* thread, std::string* value) {
+    char key[kKeySize];
+    EncodeKey(thread->NextKey(), key);
+    uint64_t bytes = 0;
+
+    if (mem_->Get(Slice(key, kKeySize), kMaxSequenceNumber, value) ==
+        LookupResult::kFound) {
+      ++thread->stats()->found;
+      bytes = kKeySize + value->size();
+    }
+    thread->FinishedOp(bytes);
+  }
+
+  /// Each thread writes its own contiguous part of the keys, in order.
+  void FillSeq(ThreadState* thread) {
+    const uint64_t first = flags_.num * thread->tid() / flags_.threads;
+    const uint64_t last = flags_.num * (thread->tid() + 1) / flags_.threads;
+
+    for (uint64_t k = first; k < last; ++k) Write(thread, k, false);
+  }
+
+  void FillRandom(ThreadState* thread) {
+    for (uint64_t i = 0; i < WritesPerThread(thread); ++i)
+      Write(thread, thread->NextKey(), false);
+  }
+
+  void Overwrite(ThreadState* thread) {
+    for (uint64_t i = 0; i < WritesPerThread(thread); ++i)
+      Write(thread, thread->NextKey(), true);
+  }
+
+  void ReadRandom(ThreadState* thread) {
+    std::string value;
+
+    for (uint64_t i = 0; i < reads_; ++i) Read(thread, &value);
+  }
+
+  /// Scans from the first key, up to --reads entries.
+  void ReadSeq(ThreadState* thread) {
+    ShardedMemTable::Iterator iter(mem_.get(), kMaxSequenceNumber);
+
+    iter.SeekToFirst();
+    for (uint64_t i = 0; i < reads_ && iter.Valid(); ++i, iter.Next()) {
+      ++thread->stats()->found;
+      thread->FinishedOp(iter.key().size() + iter.value().size());
+    }
+  }
+
+  void SeekRandom(ThreadState* thread) {
+    ShardedMemTable::Iterator iter(mem_.get(), kMaxSequenceNumber);
+    char key[kKeySize];
+
+    for (uint64_t i = 0; i < reads_; ++i) {
+      EncodeKey(thread->NextKey(), key);
+      iter.Seek(Slice(key, kKeySize));
+
+      uint64_t bytes = 0;
+      if (iter.Valid()) ++thread->stats()->found;
+      for (int j = 0; j <= flags_.seek_nexts && iter.Valid();
+           ++j, iter.Next())
+        bytes += iter.key().size() + iter.value().size();
+      thread->FinishedOp(bytes);
+    }
+  }
+
+  /// --read_percent reads, the rest overwrites.
+  void Mixed(ThreadState* thread) {
+    std::string value;
+
+    for (uint64_t i = 0; i < reads_; ++i) {
+      if (thread->rnd()->PercentTrue(flags_.read_percent))
+        Read(thread, &value);
+      else
+        Write(thread, thread->NextKey(), true);
+    }
+  }
+
+  uint64_t WritesPerThread(ThreadState* thread) const {
+    return flags_.num * (thread->tid() + 1) / flags_.threads -
+           flags_.num * thread->tid() / flags_.threads;
+  }
+
+  const Flags flags_;
+  const uint64_t reads_;
+  std::string value_data_;
+  const std::unique_ptr<Statistics> stats_;
+  std::unique_ptr<ShardedMemTable> mem_;
+  std::atomic<SequenceNumber> seq_{0};
+  std::vector<Result> results_;
+};
+
+bool Benchmark::Run() {
+  if (NewKeyGenerator(flags_, 0) == nullptr) {
+    fprintf(stderr, "Unknown --key_distribution: %s\n",
+            flags_.key_distribution.c_str());
+    return false;
+  }
+  if (NewValueSizeGenerator(flags_, 0) == nullptr) {
+    fprintf(stderr, "Unknown --value_size_distribution: %s\n",
+            flags_.value_size_distribution.c_str());
+    return false;
+  }
+
+  fprintf(stderr, "Keys:       %zu bytes each, %s\n", kKeySize,
+          flags_.key_distribution.c_str());
+  if (flags_.value_size_distribution == "fixed")
+    fprintf(stderr, "Values:     %u bytes each\n", flags_.value_size);
+  else
+    fprintf(stderr, "Values:     %s, %u to %u bytes\n",
+            flags_.value_size_distribution.c_str(), flags_.value_size_min,
+            flags_.value_size_max);
+  fprintf(stderr,
+          "Entries:    %" PRIu64 "\n"
+          "Threads:    %d\n"
+          "Shards:     %zu\n"
+          "----------------------------------------------------------------\n",
+          flags_.num, flags_.threads, flags_.shards);
+
+  std::string_view rest = flags_.benchmarks;
+
+  while (!rest.empty()) {
+    const size_t comma = rest.find(',');
+    const std::string name(rest.substr(0, comma));
+    rest = comma == std::string_view::npos ? std::string_view()
+                                           : rest.substr(comma + 1);
+    if (name.empty()) continue;
+
+    Method method = nullptr;
+    bool fresh = false;
+
+    if (name == "fillseq") {
+      method = &Benchmark::FillSeq;
+      fresh = true;
+    } else if (name == "fillrandom") {
+      method = &Benchmark::FillRandom;
+      fresh = true;
+    } else if (name == "overwrite") {
+      method = &Benchmark::Overwrite;
+    } else if (name == "readrandom") {
+      method = &Benchmark::ReadRandom;
+    } else if (name == "readseq") {
+      method = &Benchmark::ReadSeq;
+    } else if (name == "seekrandom") {
+      method = &Benchmark::SeekRandom;
+    } else if (name == "mixed") {
+      method = &Benchmark::Mixed;
+    } else {
+      fprintf(stderr, "Unknown benchmark: %s\n", name.c_str());
+      return false;
+    }
+
+    if (fresh) {
+      mem_ = NewMemTable();
+      seq_ = 0;
+    }
+    RunWorkload(name, method);
+  }
+
+  return true;
+}
+
+void Benchmark::RunWorkload(const std::string& name, Method method) {
+  std::vector<std::unique_ptr<ThreadState>> threads;
+  std::latch start(flags_.threads);
+  std::vector<std::thread> workers;
+
+  for (int tid = 0; tid < flags_.threads; ++tid)
+    threads.push_back(std::make_unique<ThreadState>(flags_, tid));
+  if (stats_ != nullptr) stats_->Reset();
+
+  for (auto& thread : threads) {
+    workers.emplace_back([&, state = thread.get()] {
+      start.arrive_and_wait();
+      state->Start();
+      (this->*method)(state);
+      state->Finish();
+    });
+  }
+  for (auto& worker : workers) worker.join();
+
+  ThreadStats total = *threads[0]->stats();
+  for (size_t i = 1; i < threads.size(); ++i) {
+    const ThreadStats& stats = *threads[i]->stats();
+
+    total.ops += stats.ops;
+    total.bytes += stats.bytes;
+    total.found += stats.found;
+    total.start = std::min(total.start, stats.start);
+    total.finish = std::max(total.finish, stats.finish);
+    total.latency.Merge(stats.latency);
+  }
+
+  Result result;
+  result.name = name;
+  result.ops = total.ops;
+  result.found = total.found;
+  result.seconds =
+      std::chrono::duration<double>(total.finish - total.start).count();
+  const double seconds = std::max(result.seconds, 1e-9);
+  result.ops_per_sec = static_cast<double>(total.ops) / seconds;
+  result.mb_per_sec = static_cast<double>(total.bytes) / 1048576 / seconds;
+  result.p50_us = total.latency.Percentile(50) / 1000;
+  result.p99_us = total.latency.Percentile(99) / 1000;
+  result.p999_us = total.latency.Percentile(99.9) / 1000;
+  result.memory_bytes = mem_->ApproximateMemoryUsage();
+
+  fprintf(stderr,
+          "%-12s : %10.0f ops/sec %8.1f MB/s  p50 %.3f  p99 %.3f  "
+          "p99.9 %.3f us",
+          name.c_str(), result.ops_per_sec, result.mb_per_sec, result.p50_us,
+          result.p99_us, result.p999_us);
+  if (method != &Benchmark::FillSeq && method != &Benchmark::FillRandom &&
+      method != &Benchmark::Overwrite)
+    fprintf(stderr, "  (%" PRIu64 " of %" PRIu64 " found)", result.found,
+            result.ops);
+  fprintf(stderr, "\n");
+
+  if (stats_ != nullptr) {
+    const StatisticsSnapshot snapshot = stats_->Snapshot();
+
+    fprintf(stderr, "%s", snapshot.ToString().c_str());
+    result.statistics = snapshot.ToJson();
+  }
+
+  results_.push_back(result);
+}
+
+void WriteJson(FILE* out, const Flags& flags,
+               const std::vector<Result>& results) {
+  fprintf(out,
+          "{\n"
+          "  \"config\": {\"num\": %" PRIu64 ", \"threads\": %d, "
+          "\"shards\": %zu, \"key_size\": %zu, \"key_distribution\": \"%s\", "
+          "\"value_size_distribution\": \"%s\", \"value_size\": %u, "
+          "\"seed\": %" PRIu64 "},\n"
+          "  \"benchmarks\": [",
+          flags.num, flags.threads, flags.shards, kKeySize,
+          flags.key_distribution.c_str(),
+          flags.value_size_distribution.c_str(), flags.value_size,
+          flags.seed);
+
+  for (size_t i = 0; i < results.size(); ++i) {
+    const Result& r = results[i];
+
+    fprintf(out,
+            "%s\n    {\"name\": \"%s\", \"ops\": %" PRIu64
+            ", \"found\": %" PRIu64
+            ", \"seconds\": %.6f, \"ops_per_sec\": %.1f, "
+            "\"mb_per_sec\": %.3f, \"p50_us\": %.4f, \"p99_us\": %.4f, "
+            "\"p999_us\": %.4f, \"memory_bytes\": %zu",
+            i == 0 ? "" : ",", r.name.c_str(), r.ops, r.found, r.seconds,
+            r.ops_per_sec, r.mb_per_sec, r.p50_us, r.p99_us, r.p999_us,
+            r.memory_bytes);
+    if (!r.statistics.empty())
+      fprintf(out, ", \"statistics\": %s", r.statistics.c_str());
+    fprintf(out, "}");
+  }
+
+  fprintf(out, "\n  ]\n}\n");
+}
+
+}  // namespace
+
+}  // namespace badger
+
+int main(int argc, char** argv) {
+  badger::Flags flags;
+
+  if (!badger::ParseFlags(argc, argv, &flags)) {
+    badger::PrintUsage();
+    return 1;
+  }
+
+  badger::Benchmark benchmark(flags);
+  if (!benchmark.Run()) return 1;
+
+  if (!flags.json.empty()) {
+    FILE* out = flags.json == "-" ? stdout : fopen(flags.json.c_str(), "w");
+
+    if (out == nullptr) {
+      perror(flags.json.c_str());
+      return 1;
+    }
+    badger::WriteJson(out, flags, benchmark.results());
+    if (out != stdout) fclose(out);
+  }
+
+  return 0;
+}